@@ -0,0 +1,682 @@
+#include "bvh.h"
+#include "../core/interaction.h"
+#include "../core/profile.h"
+#include "../core/stats.h"
+#include "../core/raypacket.h"
+#include "../core/shapedispatch.h"
+
+#include <algorithm>
+#include <chrono>
+
+
+namespace pbrt
+{
+	STAT_INT_DISTRIBUTION("BVH/Nodes visited per query", nodesPerQuery);
+	STAT_INT_DISTRIBUTION("BVH/Primitive tests per query", primitiveTestsPerQuery);
+	STAT_PERCENT("BVH/Closest-hit queries that hit", nBVHHits, nBVHRays);
+	STAT_PERCENT("BVH/Any-hit queries that hit", nBVHShadowHits, nBVHShadowRays);
+	// ѭÿβѯҪBVHȫͼԪֵǱѭͼԪԴΪBVHĶٱ
+	STAT_RATIO("BVH/Brute-force vs. BVH primitive tests", nBruteForceTests, nBVHPrimitiveTests);
+
+	struct BVHPrimitiveInfo
+	{
+		BVHPrimitiveInfo() {}
+		BVHPrimitiveInfo(int primitiveNumber, const Bounds3f &bounds)
+			: primitiveNumber(primitiveNumber),
+			bounds(bounds),
+			centroid((bounds.pMin + bounds.pMax) * 0.5f) {}
+
+		int primitiveNumber;
+		Bounds3f bounds;
+		Point3f centroid;
+	};
+
+	struct BVHBuildNode
+	{
+		void InitLeaf(int first, int n, const Bounds3f &b)
+		{
+			firstPrimOffset = first;
+			nPrimitives = n;
+			bounds = b;
+			children[0] = children[1] = nullptr;
+		}
+
+		void InitInterior(int axis, BVHBuildNode *c0, BVHBuildNode *c1)
+		{
+			children[0] = c0;
+			children[1] = c1;
+			bounds = Union(c0->bounds, c1->bounds);
+			splitAxis = axis;
+			nPrimitives = 0;
+		}
+
+		Bounds3f bounds;
+		BVHBuildNode *children[2];
+		int splitAxis, firstPrimOffset, nPrimitives;
+	};
+
+
+	// еʱ״̬
+	struct BVHBuilder
+	{
+		int maxPrimsInNode;
+		int primGroupSize;
+		BVHSplitMethod splitMethod;
+		std::vector<BVHPrimitiveInfo> primitiveInfo;
+		std::vector<BVHBuildNode> buildNodes;
+		AlignedVector<LinearBVHNode> *nodes;
+		std::vector<int> *orderedIndices;
+		BVHBuildStats *stats;
+
+		// nͼԪҶҪ
+		int groupCount(int n) const { return (n + primGroupSize - 1) / primGroupSize; }
+
+		BVHBuildNode *recursiveBuild(int start, int end, int depth)
+		{
+			DCHECK(start != end);
+			buildNodes.emplace_back();
+			BVHBuildNode *node = &buildNodes.back();
+			stats->maxDepth = std::max(stats->maxDepth, depth);
+
+			// ͼԪİΧ
+			Bounds3f bounds;
+			for (int i = start; i < end; ++i)
+				bounds = Union(bounds, primitiveInfo[i].bounds);
+
+			auto createLeaf = [&]() {
+				int firstPrimOffset = (int)orderedIndices->size();
+				for (int i = start; i < end; ++i)
+					orderedIndices->push_back(primitiveInfo[i].primitiveNumber);
+				node->InitLeaf(firstPrimOffset, end - start, bounds);
+				++stats->leafNodes;
+				return node;
+			};
+
+			int nPrimitives = end - start;
+			if (nPrimitives == 1)
+				return createLeaf();
+
+			// ͼԪĵİΧУѡΪ
+			Bounds3f centroidBounds;
+			for (int i = start; i < end; ++i)
+				centroidBounds = Union(centroidBounds, primitiveInfo[i].centroid);
+			int dim = centroidBounds.MaximumExtent();
+
+			// ĵغϣ޷ٻ
+			if (centroidBounds.pMax[dim] == centroidBounds.pMin[dim])
+				return createLeaf();
+
+			int mid = (start + end) / 2;
+			switch (splitMethod)
+			{
+			case BVHSplitMethod::Middle:
+			{
+				Float pmid = (centroidBounds.pMin[dim] + centroidBounds.pMax[dim]) / 2;
+				BVHPrimitiveInfo *midPtr = std::partition(
+					&primitiveInfo[start], &primitiveInfo[end - 1] + 1,
+					[dim, pmid](const BVHPrimitiveInfo &pi) { return pi.centroid[dim] < pmid; });
+				mid = (int)(midPtr - &primitiveInfo[0]);
+				if (mid != start && mid != end)
+					break;
+				// е㻮ʧܣͼԪΧдص˻Ϊ
+			}
+			// fallthrough
+			case BVHSplitMethod::EqualCounts:
+			{
+				mid = (start + end) / 2;
+				std::nth_element(&primitiveInfo[start], &primitiveInfo[mid], &primitiveInfo[end - 1] + 1,
+					[dim](const BVHPrimitiveInfo &a, const BVHPrimitiveInfo &b) {
+					return a.centroid[dim] < b.centroid[dim];
+				});
+				break;
+			}
+			case BVHSplitMethod::SAH:
+			default:
+			{
+				if (nPrimitives <= 2)
+				{
+					mid = (start + end) / 2;
+					std::nth_element(&primitiveInfo[start], &primitiveInfo[mid], &primitiveInfo[end - 1] + 1,
+						[dim](const BVHPrimitiveInfo &a, const BVHPrimitiveInfo &b) {
+						return a.centroid[dim] < b.centroid[dim];
+					});
+					break;
+				}
+
+				// ĵdimֵnBucketsͰ
+				constexpr int nBuckets = 12;
+				struct BucketInfo
+				{
+					int count = 0;
+					Bounds3f bounds;
+				};
+				BucketInfo buckets[nBuckets];
+
+				for (int i = start; i < end; ++i)
+				{
+					int b = (int)(nBuckets * centroidBounds.Offset(primitiveInfo[i].centroid)[dim]);
+					if (b == nBuckets) b = nBuckets - 1;
+					DCHECK(b >= 0 && b < nBuckets);
+					buckets[b].count++;
+					buckets[b].bounds = Union(buckets[b].bounds, primitiveInfo[i].bounds);
+				}
+
+				// ÿͰ֮һSAHۣ
+				//   cost = tTraversal + (A(b0) * n0 + A(b1) * n1) / A(node)
+				// ȡΪ󽻴۵1/8
+				// Ҹɨһ飬O(nBuckets^2)ļ㽵ΪO(nBuckets)
+				Float leftArea[nBuckets - 1], rightArea[nBuckets - 1];
+				int leftCount[nBuckets - 1], rightCount[nBuckets - 1];
+				{
+					Bounds3f b;
+					int count = 0;
+					for (int i = 0; i < nBuckets - 1; ++i)
+					{
+						b = Union(b, buckets[i].bounds);
+						count += buckets[i].count;
+						leftArea[i] = count ? b.SurfaceArea() : 0;
+						leftCount[i] = count;
+					}
+				}
+				{
+					Bounds3f b;
+					int count = 0;
+					for (int i = nBuckets - 1; i > 0; --i)
+					{
+						b = Union(b, buckets[i].bounds);
+						count += buckets[i].count;
+						rightArea[i - 1] = count ? b.SurfaceArea() : 0;
+						rightCount[i - 1] = count;
+					}
+				}
+
+				Float totalArea = bounds.SurfaceArea();
+				Float minCost = std::numeric_limits<Float>::infinity();
+				int minCostSplitBucket = 0;
+				for (int i = 0; i < nBuckets - 1; ++i)
+				{
+					Float cost = 0.125f;
+					if (totalArea > 0)
+						cost += (groupCount(leftCount[i]) * leftArea[i] +
+							groupCount(rightCount[i]) * rightArea[i]) / totalArea;
+					else
+						cost += groupCount(nPrimitives);
+					if (cost < minCost)
+					{
+						minCost = cost;
+						minCostSplitBucket = i;
+					}
+				}
+
+				// ֱֱҶӸ㣬ͼԪҶӵޣż
+				Float leafCost = (Float)groupCount(nPrimitives);
+				if (nPrimitives > maxPrimsInNode || minCost < leafCost)
+				{
+					BVHPrimitiveInfo *pmid = std::partition(
+						&primitiveInfo[start], &primitiveInfo[end - 1] + 1,
+						[=](const BVHPrimitiveInfo &pi) {
+						int b = (int)(nBuckets * centroidBounds.Offset(pi.centroid)[dim]);
+						if (b == nBuckets) b = nBuckets - 1;
+						return b <= minCostSplitBucket;
+					});
+					mid = (int)(pmid - &primitiveInfo[0]);
+				}
+				else
+				{
+					return createLeaf();
+				}
+				break;
+			}
+			}
+
+			BVHBuildNode *c0 = recursiveBuild(start, mid, depth + 1);
+			BVHBuildNode *c1 = recursiveBuild(mid, end, depth + 1);
+			node->InitInterior(dim, c0, c1);
+			++stats->interiorNodes;
+			return node;
+		}
+
+		int flattenBVHTree(const BVHBuildNode *node, int *offset)
+		{
+			LinearBVHNode *linearNode = &(*nodes)[*offset];
+			linearNode->bounds = node->bounds;
+			int myOffset = (*offset)++;
+			if (node->nPrimitives > 0)
+			{
+				DCHECK(!node->children[0] && !node->children[1]);
+				DCHECK(node->nPrimitives < 65536);
+				linearNode->primitivesOffset = node->firstPrimOffset;
+				linearNode->nPrimitives = (uint16_t)node->nPrimitives;
+			}
+			else
+			{
+				linearNode->axis = (uint8_t)node->splitAxis;
+				linearNode->nPrimitives = 0;
+				flattenBVHTree(node->children[0], offset);
+				linearNode->secondChildOffset = flattenBVHTree(node->children[1], offset);
+			}
+			return myOffset;
+		}
+	};
+
+
+	void BuildLinearBVH(const std::vector<Bounds3f>& primBounds, int maxPrimsInNode, BVHSplitMethod splitMethod, AlignedVector<LinearBVHNode>* nodes, std::vector<int>* orderedIndices, BVHBuildStats * stats, int primGroupSize)
+	{
+		ProfilePhase _(Prof::AccelConstruction);
+		auto startTime = std::chrono::steady_clock::now();
+		*stats = BVHBuildStats();
+		stats->primitives = (int)primBounds.size();
+		nodes->clear();
+		orderedIndices->clear();
+		if (primBounds.empty())
+			return;
+
+		BVHBuilder builder;
+		builder.maxPrimsInNode = std::min(255, maxPrimsInNode);
+		builder.primGroupSize = std::max(1, primGroupSize);
+		builder.splitMethod = splitMethod;
+		builder.nodes = nodes;
+		builder.orderedIndices = orderedIndices;
+		builder.stats = stats;
+
+		builder.primitiveInfo.resize(primBounds.size());
+		for (size_t i = 0; i < primBounds.size(); ++i)
+			builder.primitiveInfo[i] = { (int)i, primBounds[i] };
+
+		// nͼԪĶ2n-1ڵ㣬Ԥȷã֤ڵָڹвʧЧ
+		builder.buildNodes.reserve(2 * primBounds.size() - 1);
+		orderedIndices->reserve(primBounds.size());
+		BVHBuildNode *root = builder.recursiveBuild(0, (int)primBounds.size(), 1);
+
+		// õָֻʱģѹƽȵͷŵ
+		nodes->resize(builder.buildNodes.size());
+		int offset = 0;
+		builder.flattenBVHTree(root, &offset);
+		DCHECK(offset == (int)builder.buildNodes.size());
+
+		stats->treeBytes = nodes->size() * sizeof(LinearBVHNode);
+		stats->buildSeconds = std::chrono::duration<double>(
+			std::chrono::steady_clock::now() - startTime).count();
+	}
+
+
+	BVHAccel::BVHAccel(std::vector<std::shared_ptr<Primitive>> p, int maxPrimsInNode, SplitMethod splitMethod)
+		: primitives(std::move(p))
+	{
+		std::vector<Bounds3f> primBounds(primitives.size());
+		for (size_t i = 0; i < primitives.size(); ++i)
+			primBounds[i] = primitives[i]->WorldBound();
+
+		std::vector<int> orderedIndices;
+		AlignedVector<LinearBVHNode> builtNodes;
+		BuildLinearBVH(primBounds, maxPrimsInNode, splitMethod, &builtNodes, &orderedIndices, &buildStats);
+		nodes = ReadOnlyArray<LinearBVHNode>(std::move(builtNodes));
+
+		std::vector<std::shared_ptr<Primitive>> orderedPrims(orderedIndices.size());
+		for (size_t i = 0; i < orderedIndices.size(); ++i)
+			orderedPrims[i] = primitives[orderedIndices[i]];
+		primitives.swap(orderedPrims);
+		primitiveHandles = MakePrimitiveHandles(primitives);
+	}
+
+	BVHAccel::BVHAccel(std::vector<std::shared_ptr<Primitive>> orderedPrims, ReadOnlyArray<LinearBVHNode> nodes)
+		: primitives(std::move(orderedPrims)), nodes(std::move(nodes))
+	{
+		buildStats.primitives = (int)primitives.size();
+		buildStats.treeBytes = this->nodes.BytesUsed();
+		primitiveHandles = MakePrimitiveHandles(primitives);
+	}
+
+	BVHAccel::~BVHAccel() {}
+
+	Bounds3f BVHAccel::WorldBound() const
+	{
+		return nodes.empty() ? Bounds3f() : nodes[0].bounds;
+	}
+
+	bool BVHAccel::IntersectHit(const Ray & ray, SurfaceHit * hit) const
+	{
+		ProfilePhase _(Prof::AccelIntersect);
+		if (nodes.empty()) return false;
+
+		int64_t nodesVisited = 0, primitiveTests = 0;
+		bool found = false;
+
+		Vector3f invDir(1 / ray.d.x, 1 / ray.d.y, 1 / ray.d.z);
+		int dirIsNeg[3] = { invDir.x < 0, invDir.y < 0, invDir.z < 0 };
+
+		// ڻϵķΪʱȷʵڶӣĽڵȱʵ
+		// tMax̵ø죬Ľڵܱ޳
+		int toVisitOffset = 0, currentNodeIndex = 0;
+		int nodesToVisit[64];
+		while (true)
+		{
+			const LinearBVHNode *node = &nodes[currentNodeIndex];
+			++nodesVisited;
+			if (node->bounds.IntersectP(ray, invDir, dirIsNeg))
+			{
+				if (node->nPrimitives > 0)
+				{
+					for (int i = 0; i < node->nPrimitives; ++i)
+					{
+						++primitiveTests;
+						if (primitiveHandles[node->primitivesOffset + i].IntersectHit(ray, hit))
+							found = true;
+					}
+					if (toVisitOffset == 0) break;
+					currentNodeIndex = nodesToVisit[--toVisitOffset];
+				}
+				else
+				{
+					if (dirIsNeg[node->axis])
+					{
+						nodesToVisit[toVisitOffset++] = currentNodeIndex + 1;
+						currentNodeIndex = node->secondChildOffset;
+					}
+					else
+					{
+						nodesToVisit[toVisitOffset++] = node->secondChildOffset;
+						currentNodeIndex = currentNodeIndex + 1;
+					}
+				}
+			}
+			else
+			{
+				if (toVisitOffset == 0) break;
+				currentNodeIndex = nodesToVisit[--toVisitOffset];
+			}
+		}
+
+		++nBVHRays;
+		nBVHHits += found;
+		ReportValue(nodesPerQuery, nodesVisited);
+		ReportValue(primitiveTestsPerQuery, primitiveTests);
+		nBVHPrimitiveTests += primitiveTests;
+		nBruteForceTests += (int64_t)primitives.size();
+		return found;
+	}
+
+	bool BVHAccel::IntersectP(const Ray & ray) const
+	{
+		ProfilePhase _(Prof::AccelIntersectP);
+		if (nodes.empty()) return false;
+
+		int64_t nodesVisited = 0, primitiveTests = 0;
+		bool hit = false;
+
+		Vector3f invDir(1 / ray.d.x, 1 / ray.d.y, 1 / ray.d.z);
+		int dirIsNeg[3] = { invDir.x < 0, invDir.y < 0, invDir.z < 0 };
+
+		int toVisitOffset = 0, currentNodeIndex = 0;
+		int nodesToVisit[64];
+		while (true)
+		{
+			const LinearBVHNode *node = &nodes[currentNodeIndex];
+			++nodesVisited;
+			if (node->bounds.IntersectP(ray, invDir, dirIsNeg))
+			{
+				if (node->nPrimitives > 0)
+				{
+					for (int i = 0; i < node->nPrimitives; ++i)
+					{
+						++primitiveTests;
+						if (primitiveHandles[node->primitivesOffset + i].IntersectP(ray))
+						{
+							hit = true;
+							break;
+						}
+					}
+					if (hit || toVisitOffset == 0) break;
+					currentNodeIndex = nodesToVisit[--toVisitOffset];
+				}
+				else
+				{
+					if (dirIsNeg[node->axis])
+					{
+						nodesToVisit[toVisitOffset++] = currentNodeIndex + 1;
+						currentNodeIndex = node->secondChildOffset;
+					}
+					else
+					{
+						nodesToVisit[toVisitOffset++] = node->secondChildOffset;
+						currentNodeIndex = currentNodeIndex + 1;
+					}
+				}
+			}
+			else
+			{
+				if (toVisitOffset == 0) break;
+				currentNodeIndex = nodesToVisit[--toVisitOffset];
+			}
+		}
+
+		++nBVHShadowRays;
+		nBVHShadowHits += hit;
+		ReportValue(nodesPerQuery, nodesVisited);
+		ReportValue(primitiveTestsPerQuery, primitiveTests);
+		nBVHPrimitiveTests += primitiveTests;
+		nBruteForceTests += (int64_t)primitives.size();
+		return hit;
+	}
+
+	namespace
+	{
+		struct PacketRayInfo
+		{
+			PacketRayInfo(const RayPacket &packet)
+			{
+				for (int i = 0; i < packet.size; ++i)
+				{
+					invDx[i] = 1 / packet.dx[i];
+					invDy[i] = 1 / packet.dy[i];
+					invDz[i] = 1 / packet.dz[i];
+				}
+			}
+
+			Float invDx[RayPacket::MaxSize], invDy[RayPacket::MaxSize], invDz[RayPacket::MaxSize];
+		};
+
+		inline void SlabTest(Float bMin, Float bMax, Float o, Float invDir, Float &t0, Float &t1)
+		{
+			Float tNear = (bMin - o) * invDir;
+			Float tFar = (bMax - o) * invDir;
+			Float lo = tNear < tFar ? tNear : tFar;
+			Float hi = (tNear < tFar ? tFar : tNear) * (1 + 2 * gamma(3));
+			t0 = lo > t0 ? lo : t0;
+			t1 = hi < t1 ? hi : t1;
+		}
+
+		// ͬһΧж԰ȫԡѭûз֧SoA±ֱ
+		inline uint32_t IntersectPacketBounds(const Bounds3f &b, const RayPacket &packet,
+			const PacketRayInfo &info, uint32_t activeMask)
+		{
+			int hit[RayPacket::MaxSize];
+			for (int i = 0; i < packet.size; ++i)
+			{
+				Float t0 = 0, t1 = packet.tMax[i];
+				SlabTest(b.pMin.x, b.pMax.x, packet.ox[i], info.invDx[i], t0, t1);
+				SlabTest(b.pMin.y, b.pMax.y, packet.oy[i], info.invDy[i], t0, t1);
+				SlabTest(b.pMin.z, b.pMax.z, packet.oz[i], info.invDz[i], t0, t1);
+				hit[i] = t0 <= t1;
+			}
+			uint32_t mask = 0;
+			for (int i = 0; i < packet.size; ++i)
+				mask |= (uint32_t)hit[i] << i;
+			return mask & activeMask;
+		}
+
+		inline int CountBits(uint32_t v)
+		{
+			int n = 0;
+			for (; v; v &= v - 1) ++n;
+			return n;
+		}
+
+		// ߰ķһ£õһЧߵķӵķ˳
+		inline void PacketDirIsNeg(const RayPacket &packet, uint32_t activeMask, int dirIsNeg[3])
+		{
+			int first = 0;
+			while (!(activeMask & (1u << first))) ++first;
+			dirIsNeg[0] = packet.dx[first] < 0;
+			dirIsNeg[1] = packet.dy[first] < 0;
+			dirIsNeg[2] = packet.dz[first] < 0;
+		}
+
+		struct PacketStackEntry
+		{
+			int nodeIndex;
+			uint32_t mask;
+		};
+	}
+
+	uint32_t BVHAccel::IntersectPacket(RayPacket & packet, uint32_t activeMask, SurfaceInteraction * isects) const
+	{
+		if (nodes.empty() || activeMask == 0) return 0;
+
+		uint32_t hitMask = 0;
+		// ͱIntersectһʱÿֻ¼SurfaceHit
+		SurfaceHit hits[RayPacket::MaxSize];
+
+		PacketRayInfo info(packet);
+		int dirIsNeg[3];
+		PacketDirIsNeg(packet, activeMask, dirIsNeg);
+
+		PacketStackEntry nodesToVisit[64];
+		int toVisitOffset = 0, currentNodeIndex = 0;
+		uint32_t mask = activeMask;
+		while (true)
+		{
+			const LinearBVHNode *node = &nodes[currentNodeIndex];
+			// ߸ԵtMax󽻹л̣ÿζ²
+			uint32_t nodeMask = IntersectPacketBounds(node->bounds, packet, info, mask);
+			if (nodeMask)
+			{
+				if (node->nPrimitives > 0)
+				{
+					for (int j = 0; j < packet.size; ++j)
+					{
+						if (!(nodeMask & (1u << j)))
+							continue;
+						Ray r = packet.GetRay(j);
+						for (int i = 0; i < node->nPrimitives; ++i)
+							if (primitiveHandles[node->primitivesOffset + i].IntersectHit(r, &hits[j]))
+								hitMask |= 1u << j;
+						packet.tMax[j] = r.tMax;
+					}
+					if (toVisitOffset == 0) break;
+					--toVisitOffset;
+					currentNodeIndex = nodesToVisit[toVisitOffset].nodeIndex;
+					mask = nodesToVisit[toVisitOffset].mask;
+				}
+				else
+				{
+					if (dirIsNeg[node->axis])
+					{
+						nodesToVisit[toVisitOffset++] = { currentNodeIndex + 1, nodeMask };
+						currentNodeIndex = node->secondChildOffset;
+					}
+					else
+					{
+						nodesToVisit[toVisitOffset++] = { node->secondChildOffset, nodeMask };
+						currentNodeIndex = currentNodeIndex + 1;
+					}
+					mask = nodeMask;
+				}
+			}
+			else
+			{
+				if (toVisitOffset == 0) break;
+				--toVisitOffset;
+				currentNodeIndex = nodesToVisit[toVisitOffset].nodeIndex;
+				mask = nodesToVisit[toVisitOffset].mask;
+			}
+		}
+
+		// ֻΪÿߵ㹹һSurfaceInteraction
+		for (int j = 0; j < packet.size; ++j)
+			if (hitMask & (1u << j))
+				InteractionFromHit(packet.GetRay(j), hits[j], &isects[j]);
+
+		nBVHRays += CountBits(activeMask);
+		nBVHHits += CountBits(hitMask);
+		return hitMask;
+	}
+
+	uint32_t BVHAccel::IntersectPPacket(const RayPacket & packet, uint32_t activeMask) const
+	{
+		if (nodes.empty() || activeMask == 0) return 0;
+
+		uint32_t occluded = 0;
+
+		PacketRayInfo info(packet);
+		int dirIsNeg[3];
+		PacketDirIsNeg(packet, activeMask, dirIsNeg);
+
+		PacketStackEntry nodesToVisit[64];
+		int toVisitOffset = 0, currentNodeIndex = 0;
+		uint32_t mask = activeMask;
+		while (true)
+		{
+			const LinearBVHNode *node = &nodes[currentNodeIndex];
+			// Ѿڵ߲ٲĲ
+			uint32_t nodeMask = IntersectPacketBounds(node->bounds, packet, info, mask & ~occluded);
+			if (nodeMask)
+			{
+				if (node->nPrimitives > 0)
+				{
+					for (int i = 0; i < node->nPrimitives && nodeMask; ++i)
+					{
+						uint32_t m = primitiveHandles[node->primitivesOffset + i].IntersectPPacket(packet, nodeMask);
+						occluded |= m;
+						nodeMask &= ~m;
+					}
+					if (occluded == activeMask || toVisitOffset == 0) break;
+					--toVisitOffset;
+					currentNodeIndex = nodesToVisit[toVisitOffset].nodeIndex;
+					mask = nodesToVisit[toVisitOffset].mask;
+				}
+				else
+				{
+					if (dirIsNeg[node->axis])
+					{
+						nodesToVisit[toVisitOffset++] = { currentNodeIndex + 1, nodeMask };
+						currentNodeIndex = node->secondChildOffset;
+					}
+					else
+					{
+						nodesToVisit[toVisitOffset++] = { node->secondChildOffset, nodeMask };
+						currentNodeIndex = currentNodeIndex + 1;
+					}
+					mask = nodeMask;
+				}
+			}
+			else
+			{
+				if (toVisitOffset == 0) break;
+				--toVisitOffset;
+				currentNodeIndex = nodesToVisit[toVisitOffset].nodeIndex;
+				mask = nodesToVisit[toVisitOffset].mask;
+			}
+		}
+
+		nBVHShadowRays += CountBits(activeMask);
+		nBVHShadowHits += CountBits(occluded);
+		return occluded;
+	}
+
+	void BVHAccel::ReportStats(FILE * dest) const
+	{
+		ReportBVHStats(dest, "BVH", buildStats);
+	}
+
+	void ReportBVHStats(FILE * dest, const char * name, const BVHBuildStats & b)
+	{
+		fprintf(dest, "%s build\n", name);
+		fprintf(dest, "    Primitives                %d\n", b.primitives);
+		fprintf(dest, "    Interior nodes            %d\n", b.interiorNodes);
+		fprintf(dest, "    Leaf nodes                %d\n", b.leafNodes);
+		fprintf(dest, "    Max depth                 %d\n", b.maxDepth);
+		fprintf(dest, "    Tree size                 %.2f MB\n", b.treeBytes / (1024. * 1024.));
+		fprintf(dest, "    Build time                %.3f s\n", b.buildSeconds);
+	}
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+#include "../core/memory.h"
+#include "../core/primitive.h"
+
+
+namespace pbrt
+{
+	enum class BVHSplitMethod { SAH, Middle, EqualCounts };
+
+	// ׶εͳ
+	struct BVHBuildStats
+	{
+		int primitives = 0;
+		int interiorNodes = 0;
+		int leafNodes = 0;
+		int maxDepth = 0;
+		size_t treeBytes = 0;
+		double buildSeconds = 0;
+	};
+
+	// ˳ŵıƽڵ㣬32ֽڣڵռһС
+	// ڲڵĵһӽԼ棬ֻ¼ڶӵλá
+	struct alignas(32) LinearBVHNode
+	{
+		Bounds3f bounds;
+		union {
+			int primitivesOffset;   // leaf
+			int secondChildOffset;  // interior
+		};
+		uint16_t nPrimitives;       // 0 -> interior node
+		uint8_t axis;               // interior node: xyz
+		uint8_t pad[1];
+	};
+	static_assert(sizeof(LinearBVHNode) == 32, "LinearBVHNode must stay 32 bytes");
+
+
+	// ֻͼԪΧеĶBVHּٽṹá
+	// ƽڵ㣬orderedIndices[i]ҶiͼԪprimBoundsе±ꡣ
+	// ҶͼԪprimGroupSizeһSIMDʱSAHͼԪ󽻴ۡ
+	void BuildLinearBVH(const std::vector<Bounds3f> &primBounds, int maxPrimsInNode,
+		BVHSplitMethod splitMethod, AlignedVector<LinearBVHNode> *nodes,
+		std::vector<int> *orderedIndices, BVHBuildStats *stats, int primGroupSize = 1);
+
+	// ͳƣѯʡÿβѯʵĽڵԱѭʡµͼԪԣ"BVH/"Ⱦͳ
+	void ReportBVHStats(FILE *dest, const char *name, const BVHBuildStats &build);
+
+
+	class BVHAccel : public Aggregate
+	{
+	public:
+		typedef BVHSplitMethod SplitMethod;
+
+		BVHAccel(std::vector<std::shared_ptr<Primitive>> p,
+			int maxPrimsInNode = 1,
+			SplitMethod splitMethod = SplitMethod::SAH);
+
+		// ѾõĽڵ㣨ģorderedPrimsѾҶ˳
+		BVHAccel(std::vector<std::shared_ptr<Primitive>> orderedPrims, ReadOnlyArray<LinearBVHNode> nodes);
+
+		~BVHAccel();
+
+		virtual Bounds3f WorldBound() const;
+		virtual bool IntersectHit(const Ray &ray, SurfaceHit *hit) const;
+		virtual bool IntersectP(const Ray &ray) const;
+
+		// ߰һ½ڵֻҪһоͷʡ
+		virtual uint32_t IntersectPacket(RayPacket &packet, uint32_t activeMask,
+			SurfaceInteraction *isects) const;
+		virtual uint32_t IntersectPPacket(const RayPacket &packet, uint32_t activeMask) const;
+
+		// Ҷ˳ͼԪͽڵ㣬дʱ
+		const std::vector<std::shared_ptr<Primitive>> &GetPrimitives() const { return primitives; }
+		const ReadOnlyArray<LinearBVHNode> &GetNodes() const { return nodes; }
+
+		const BVHBuildStats &GetBuildStats() const { return buildStats; }
+		void ReportStats(FILE *dest) const;
+
+	private:
+		// BVHAccel Private Data
+		std::vector<std::shared_ptr<Primitive>> primitives;
+		// primitivesһһӦҶGeometricPrimitive麯
+		std::vector<PrimitiveHandle> primitiveHandles;
+		ReadOnlyArray<LinearBVHNode> nodes;
+
+		BVHBuildStats buildStats;
+	};
+}
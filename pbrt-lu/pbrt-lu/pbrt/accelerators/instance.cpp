@@ -0,0 +1,172 @@
+#include "instance.h"
+#include "../core/interaction.h"
+#include "../core/profile.h"
+#include "../core/stats.h"
+#include "../core/transform.h"
+
+
+namespace pbrt
+{
+	STAT_RATIO("Instancing/Instances entered per query", nInstanceTests, nInstanceQueries);
+
+	InstanceAccel::InstanceAccel(std::vector<std::shared_ptr<Primitive>> p, std::vector<Instance> inst, int maxPrimsInNode)
+		: prototypes(std::move(p))
+	{
+		// ÿԭ͵İΧֻһΣʵİΧ任õ
+		std::vector<Bounds3f> prototypeBounds(prototypes.size());
+		for (size_t i = 0; i < prototypes.size(); ++i)
+			prototypeBounds[i] = prototypes[i]->WorldBound();
+
+		std::vector<Bounds3f> primBounds(inst.size());
+		for (size_t i = 0; i < inst.size(); ++i)
+		{
+			DCHECK(inst[i].prototype >= 0 && inst[i].prototype < (int)prototypes.size());
+			primBounds[i] = (*inst[i].InstanceToWorld)(prototypeBounds[inst[i].prototype]);
+		}
+
+		std::vector<int> orderedIndices;
+		AlignedVector<LinearBVHNode> builtNodes;
+		BuildLinearBVH(primBounds, maxPrimsInNode, BVHSplitMethod::SAH, &builtNodes,
+			&orderedIndices, &buildStats);
+		nodes = ReadOnlyArray<LinearBVHNode>(std::move(builtNodes));
+		primBounds.clear();
+		primBounds.shrink_to_fit();
+
+		// Ҷ˳
+		instances.resize(inst.size());
+		for (size_t i = 0; i < inst.size(); ++i)
+			instances[i] = inst[orderedIndices[i]];
+
+		if (!nodes.empty())
+			bounds = nodes[0].bounds;
+	}
+
+	InstanceAccel::InstanceAccel(std::vector<std::shared_ptr<Primitive>> p, std::vector<Instance> orderedInstances,
+		ReadOnlyArray<LinearBVHNode> n)
+		: prototypes(std::move(p)), instances(std::move(orderedInstances)), nodes(std::move(n))
+	{
+		if (!nodes.empty())
+			bounds = nodes[0].bounds;
+		buildStats.primitives = (int)instances.size();
+		buildStats.treeBytes = nodes.BytesUsed();
+	}
+
+	bool InstanceAccel::IntersectHit(const Ray & ray, SurfaceHit * hit) const
+	{
+		ProfilePhase _(Prof::AccelIntersect);
+		if (nodes.empty()) return false;
+		++nInstanceQueries;
+
+		bool found = false;
+		Vector3f invDir(1 / ray.d.x, 1 / ray.d.y, 1 / ray.d.z);
+		int dirIsNeg[3] = { invDir.x < 0, invDir.y < 0, invDir.z < 0 };
+
+		int toVisitOffset = 0, currentNodeIndex = 0;
+		int nodesToVisit[64];
+		while (true)
+		{
+			const LinearBVHNode *node = &nodes[currentNodeIndex];
+			if (node->bounds.IntersectP(ray, invDir, dirIsNeg))
+			{
+				if (node->nPrimitives > 0)
+				{
+					int end = node->primitivesOffset + node->nPrimitives;
+					for (int i = node->primitivesOffset; i < end; ++i)
+					{
+						// 任ʱһռеtռеt
+						const Instance &instance = instances[i];
+						++nInstanceTests;
+						Ray rayObj = (*instance.WorldToInstance)(ray);
+						if (prototypes[instance.prototype]->IntersectHit(rayObj, hit))
+						{
+							ray.tMax = rayObj.tMax;
+							hit->instanceToWorld = instance.InstanceToWorld;
+							hit->worldToInstance = instance.WorldToInstance;
+							found = true;
+						}
+					}
+					if (toVisitOffset == 0) break;
+					currentNodeIndex = nodesToVisit[--toVisitOffset];
+				}
+				else
+				{
+					if (dirIsNeg[node->axis])
+					{
+						nodesToVisit[toVisitOffset++] = currentNodeIndex + 1;
+						currentNodeIndex = node->secondChildOffset;
+					}
+					else
+					{
+						nodesToVisit[toVisitOffset++] = node->secondChildOffset;
+						currentNodeIndex = currentNodeIndex + 1;
+					}
+				}
+			}
+			else
+			{
+				if (toVisitOffset == 0) break;
+				currentNodeIndex = nodesToVisit[--toVisitOffset];
+			}
+		}
+		return found;
+	}
+
+	bool InstanceAccel::IntersectP(const Ray & ray) const
+	{
+		ProfilePhase _(Prof::AccelIntersectP);
+		if (nodes.empty()) return false;
+		++nInstanceQueries;
+
+		Vector3f invDir(1 / ray.d.x, 1 / ray.d.y, 1 / ray.d.z);
+		int dirIsNeg[3] = { invDir.x < 0, invDir.y < 0, invDir.z < 0 };
+
+		int toVisitOffset = 0, currentNodeIndex = 0;
+		int nodesToVisit[64];
+		while (true)
+		{
+			const LinearBVHNode *node = &nodes[currentNodeIndex];
+			if (node->bounds.IntersectP(ray, invDir, dirIsNeg))
+			{
+				if (node->nPrimitives > 0)
+				{
+					int end = node->primitivesOffset + node->nPrimitives;
+					for (int i = node->primitivesOffset; i < end; ++i)
+					{
+						const Instance &instance = instances[i];
+						++nInstanceTests;
+						if (prototypes[instance.prototype]->IntersectP((*instance.WorldToInstance)(ray)))
+							return true;
+					}
+					if (toVisitOffset == 0) break;
+					currentNodeIndex = nodesToVisit[--toVisitOffset];
+				}
+				else
+				{
+					if (dirIsNeg[node->axis])
+					{
+						nodesToVisit[toVisitOffset++] = currentNodeIndex + 1;
+						currentNodeIndex = node->secondChildOffset;
+					}
+					else
+					{
+						nodesToVisit[toVisitOffset++] = node->secondChildOffset;
+						currentNodeIndex = currentNodeIndex + 1;
+					}
+				}
+			}
+			else
+			{
+				if (toVisitOffset == 0) break;
+				currentNodeIndex = nodesToVisit[--toVisitOffset];
+			}
+		}
+		return false;
+	}
+
+	size_t InstanceAccel::BytesUsed() const
+	{
+		return sizeof(*this) + prototypes.capacity() * sizeof(prototypes[0]) +
+			instances.capacity() * sizeof(Instance) +
+			nodes.BytesUsed();
+	}
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+
+#include <memory>
+#include <vector>
+
+#include "bvh.h"
+
+
+namespace pbrt
+{
+	// һʵԭͣĵײٽṹBLAS±һԱ任
+	// 任ӦTransformCacheͬľֻһݡ
+	struct Instance
+	{
+		const Transform *InstanceToWorld;
+		const Transform *WorldToInstance;
+		int prototype;
+	};
+
+
+	// ٽṹTLASʵռΧϽһBVH
+	// ʵPrimitiveûshared_ptrҶ˳ţÿʵ24ֽڣټBVHڵ㣻
+	// ֻԭһݣϰʵҲֻռMB
+	// ߽ʵʱTransform任ռ䣬ٽԭ󽻡ֻ֧һʵ
+	class InstanceAccel : public Aggregate
+	{
+	public:
+		InstanceAccel(std::vector<std::shared_ptr<Primitive>> prototypes,
+			std::vector<Instance> instances,
+			int maxPrimsInNode = 2);
+
+		// ѾõĽڵ㣨ģorderedInstancesѾҶ˳
+		InstanceAccel(std::vector<std::shared_ptr<Primitive>> prototypes,
+			std::vector<Instance> orderedInstances, ReadOnlyArray<LinearBVHNode> nodes);
+
+		virtual Bounds3f WorldBound() const { return bounds; }
+		virtual bool IntersectHit(const Ray &ray, SurfaceHit *hit) const;
+		virtual bool IntersectP(const Ray &ray) const;
+
+		int NumInstances() const { return (int)instances.size(); }
+		int NumPrototypes() const { return (int)prototypes.size(); }
+		// Ҷ˳ʵͽڵ㣬дʱ
+		const std::vector<Instance> &GetInstances() const { return instances; }
+		const ReadOnlyArray<LinearBVHNode> &GetNodes() const { return nodes; }
+		// ֻͳƶʵͽڵ㣬ԭͺͱ任
+		size_t BytesUsed() const;
+		const BVHBuildStats &GetBuildStats() const { return buildStats; }
+
+	private:
+		std::vector<std::shared_ptr<Primitive>> prototypes;
+		std::vector<Instance> instances;
+		ReadOnlyArray<LinearBVHNode> nodes;
+		Bounds3f bounds;
+		BVHBuildStats buildStats;
+	};
+}
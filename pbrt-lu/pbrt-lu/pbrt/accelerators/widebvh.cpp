@@ -0,0 +1,430 @@
+#include "widebvh.h"
+#include "../core/interaction.h"
+#include "../core/profile.h"
+#include "../core/shapedispatch.h"
+#include "../core/stats.h"
+
+#include <algorithm>
+#include <chrono>
+
+#if defined(PBRT_HAVE_AVX) || defined(PBRT_HAVE_SSE)
+#include <immintrin.h>
+#endif
+
+
+namespace pbrt
+{
+	STAT_INT_DISTRIBUTION("BVH/Nodes visited per query", nodesPerQuery);
+	STAT_INT_DISTRIBUTION("BVH/Primitive tests per query", primitiveTestsPerQuery);
+	STAT_PERCENT("BVH/Closest-hit queries that hit", nBVHHits, nBVHRays);
+	STAT_PERCENT("BVH/Any-hit queries that hit", nBVHShadowHits, nBVHShadowRays);
+	// ѭÿβѯҪBVHȫͼԪֵǱѭͼԪԴΪBVHĶٱ
+	STAT_RATIO("BVH/Brute-force vs. BVH primitive tests", nBruteForceTests, nBVHPrimitiveTests);
+
+	static_assert(sizeof(Float) == sizeof(float), "WideBVHAccel stores float bounds");
+
+	namespace
+	{
+		// ÿֻһε
+		struct WideRay
+		{
+			WideRay(const Ray &ray)
+			{
+				for (int a = 0; a < 3; ++a)
+				{
+					o[a] = ray.o[a];
+					invDir[a] = 1 / ray.d[a];
+					dirIsNeg[a] = invDir[a] < 0;
+				}
+			}
+
+			float o[3], invDir[3];
+			int dirIsNeg[3];
+		};
+
+		struct StackEntry
+		{
+			int32_t index;
+			int32_t nPrimitives;
+			float tNear;
+		};
+
+		// Bounds3::IntersectPһſtFar֤Ϊ©㡣
+		const float tFarScale = (float)(1 + 2 * gamma(3));
+
+		// 汾Nӣ룬tNear[i]Ϊiӵľ롣
+		template <int N>
+		inline int IntersectChildren(const WideBVHNode<N> &node, const WideRay &r,
+			float tMax, float tNear[N])
+		{
+			int mask = 0;
+			for (int i = 0; i < N; ++i)
+			{
+				float t0 = 0, t1 = tMax;
+				for (int a = 0; a < 3; ++a)
+				{
+					const float *nearPlane = r.dirIsNeg[a] ? node.bMax[a] : node.bMin[a];
+					const float *farPlane = r.dirIsNeg[a] ? node.bMin[a] : node.bMax[a];
+					float tn = (nearPlane[i] - r.o[a]) * r.invDir[a];
+					float tf = (farPlane[i] - r.o[a]) * r.invDir[a] * tFarScale;
+					// NaNȽܻ᷵falseNaNķԡ
+					t0 = tn > t0 ? tn : t0;
+					t1 = tf < t1 ? tf : t1;
+				}
+				tNear[i] = t0;
+				if (t0 <= t1)
+					mask |= 1 << i;
+			}
+			return mask;
+		}
+
+#ifdef PBRT_HAVE_SSE
+		// _mm_max_ps/_mm_min_psNaNʱصڶۼֵܷڵڶλã
+		// 汾һNaN
+		// ڵAlignedVectorﰴж룬bMin/bMaxÿһNfloatN = 4ʱ16ֽڡ
+		// N = 8ʱ32ֽڶ룬öload
+		template <>
+		inline int IntersectChildren<4>(const WideBVHNode<4> &node, const WideRay &r,
+			float tMax, float tNear[4])
+		{
+			__m128 t0 = _mm_setzero_ps();
+			__m128 t1 = _mm_set1_ps(std::numeric_limits<float>::infinity());
+			for (int a = 0; a < 3; ++a)
+			{
+				const float *nearPlane = r.dirIsNeg[a] ? node.bMax[a] : node.bMin[a];
+				const float *farPlane = r.dirIsNeg[a] ? node.bMin[a] : node.bMax[a];
+				__m128 o = _mm_set1_ps(r.o[a]);
+				__m128 invDir = _mm_set1_ps(r.invDir[a]);
+				__m128 tn = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(nearPlane), o), invDir);
+				__m128 tf = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(farPlane), o), invDir);
+				t0 = _mm_max_ps(tn, t0);
+				t1 = _mm_min_ps(tf, t1);
+			}
+			t1 = _mm_min_ps(_mm_mul_ps(t1, _mm_set1_ps(tFarScale)), _mm_set1_ps(tMax));
+			_mm_storeu_ps(tNear, t0);
+			return _mm_movemask_ps(_mm_cmple_ps(t0, t1));
+		}
+#endif  // PBRT_HAVE_SSE
+
+#ifdef PBRT_HAVE_AVX
+		template <>
+		inline int IntersectChildren<8>(const WideBVHNode<8> &node, const WideRay &r,
+			float tMax, float tNear[8])
+		{
+			__m256 t0 = _mm256_setzero_ps();
+			__m256 t1 = _mm256_set1_ps(std::numeric_limits<float>::infinity());
+			for (int a = 0; a < 3; ++a)
+			{
+				const float *nearPlane = r.dirIsNeg[a] ? node.bMax[a] : node.bMin[a];
+				const float *farPlane = r.dirIsNeg[a] ? node.bMin[a] : node.bMax[a];
+				__m256 o = _mm256_set1_ps(r.o[a]);
+				__m256 invDir = _mm256_set1_ps(r.invDir[a]);
+				__m256 tn = _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(nearPlane), o), invDir);
+				__m256 tf = _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(farPlane), o), invDir);
+				t0 = _mm256_max_ps(tn, t0);
+				t1 = _mm256_min_ps(tf, t1);
+			}
+			t1 = _mm256_min_ps(_mm256_mul_ps(t1, _mm256_set1_ps(tFarScale)), _mm256_set1_ps(tMax));
+			_mm256_storeu_ps(tNear, t0);
+			return _mm256_movemask_ps(_mm256_cmp_ps(t0, t1, _CMP_LE_OQ));
+		}
+#endif  // PBRT_HAVE_AVX
+	}
+
+
+	template <int N>
+	WideBVHAccel<N>::WideBVHAccel(std::vector<std::shared_ptr<Primitive>> p, int maxPrimsInNode, BVHSplitMethod splitMethod)
+		: primitives(std::move(p))
+	{
+		auto startTime = std::chrono::steady_clock::now();
+
+		// ȽͨĶBVHٰѹ⡱N
+		std::vector<Bounds3f> primBounds(primitives.size());
+		for (size_t i = 0; i < primitives.size(); ++i)
+			primBounds[i] = primitives[i]->WorldBound();
+
+		AlignedVector<LinearBVHNode> binary;
+		std::vector<int> orderedIndices;
+		BVHBuildStats binaryStats;
+		BuildLinearBVH(primBounds, maxPrimsInNode, splitMethod, &binary, &orderedIndices, &binaryStats);
+
+		std::vector<std::shared_ptr<Primitive>> orderedPrims(orderedIndices.size());
+		for (size_t i = 0; i < orderedIndices.size(); ++i)
+			orderedPrims[i] = primitives[orderedIndices[i]];
+		primitives.swap(orderedPrims);
+		primitiveHandles = MakePrimitiveHandles(primitives);
+
+		buildStats.primitives = (int)primitives.size();
+		if (!binary.empty())
+		{
+			bounds = binary[0].bounds;
+			nodes.reserve(binary.size() / (N - 1) + 1);
+			collapse(binary, 0, 1);
+		}
+
+		buildStats.treeBytes = nodes.size() * sizeof(WideBVHNode<N>);
+		buildStats.buildSeconds = std::chrono::duration<double>(
+			std::chrono::steady_clock::now() - startTime).count();
+	}
+
+	template <int N>
+	int WideBVHAccel<N>::collapse(const AlignedVector<LinearBVHNode>& binary, int binaryIndex, int depth)
+	{
+		buildStats.maxDepth = std::max(buildStats.maxDepth, depth);
+		++buildStats.interiorNodes;
+
+		// Ӷڵӳѱڲڵ㻻ӣ
+		// ֱNĽڵ㱻еĸʴչߡ
+		int slots[N];
+		int nSlots = 0;
+		const LinearBVHNode &bn = binary[binaryIndex];
+		if (bn.nPrimitives > 0)
+			slots[nSlots++] = binaryIndex;
+		else
+		{
+			slots[nSlots++] = binaryIndex + 1;
+			slots[nSlots++] = bn.secondChildOffset;
+		}
+
+		while (nSlots < N)
+		{
+			int best = -1;
+			Float bestArea = -1;
+			for (int i = 0; i < nSlots; ++i)
+			{
+				const LinearBVHNode &c = binary[slots[i]];
+				if (c.nPrimitives == 0 && c.bounds.SurfaceArea() > bestArea)
+				{
+					best = i;
+					bestArea = c.bounds.SurfaceArea();
+				}
+			}
+			if (best < 0)
+				break;
+			int expand = slots[best];
+			slots[best] = expand + 1;
+			slots[nSlots++] = binary[expand].secondChildOffset;
+		}
+
+		int nodeIndex = (int)nodes.size();
+		nodes.emplace_back();
+		{
+			WideBVHNode<N> &node = nodes[nodeIndex];
+			for (int i = 0; i < N; ++i)
+			{
+				for (int a = 0; a < 3; ++a)
+				{
+					node.bMin[a][i] = std::numeric_limits<float>::infinity();
+					node.bMax[a][i] = -std::numeric_limits<float>::infinity();
+				}
+				node.child[i] = -1;
+				node.nPrimitives[i] = 0;
+			}
+		}
+
+		for (int i = 0; i < nSlots; ++i)
+		{
+			const LinearBVHNode &c = binary[slots[i]];
+			int child;
+			if (c.nPrimitives > 0)
+			{
+				child = c.primitivesOffset;
+				++buildStats.leafNodes;
+			}
+			else
+				child = collapse(binary, slots[i], depth + 1);
+
+			// ݹnodes·䣬Ҫȡá
+			WideBVHNode<N> &node = nodes[nodeIndex];
+			for (int a = 0; a < 3; ++a)
+			{
+				node.bMin[a][i] = c.bounds.pMin[a];
+				node.bMax[a][i] = c.bounds.pMax[a];
+			}
+			node.child[i] = child;
+			node.nPrimitives[i] = (uint8_t)c.nPrimitives;
+		}
+		return nodeIndex;
+	}
+
+	template <int N>
+	bool WideBVHAccel<N>::IntersectHit(const Ray & ray, SurfaceHit * hit) const
+	{
+		ProfilePhase _(Prof::AccelIntersect);
+		if (nodes.empty()) return false;
+
+		int64_t nodesVisited = 0, primitiveTests = 0;
+		bool found = false;
+		WideRay r(ray);
+
+		StackEntry stack[64 * N];
+		int stackSize = 0;
+		stack[stackSize++] = { 0, 0, 0.f };
+		while (stackSize > 0)
+		{
+			StackEntry entry = stack[--stackSize];
+			// ջ֮tMaxѾĽ
+			if (entry.tNear > ray.tMax)
+				continue;
+
+			if (entry.nPrimitives > 0)
+			{
+				for (int i = 0; i < entry.nPrimitives; ++i)
+				{
+					++primitiveTests;
+					if (primitiveHandles[entry.index + i].IntersectHit(ray, hit))
+						found = true;
+				}
+				continue;
+			}
+
+			++nodesVisited;
+			const WideBVHNode<N> &node = nodes[entry.index];
+			float tNear[N];
+			int mask = IntersectChildren<N>(node, r, ray.tMax, tNear);
+			if (mask == 0)
+				continue;
+
+			// Զջĺȳջ
+			StackEntry hits[N];
+			int nHits = 0;
+			for (int i = 0; i < N; ++i)
+			{
+				if (!(mask & (1 << i)))
+					continue;
+				StackEntry e = { node.child[i], node.nPrimitives[i], tNear[i] };
+				int j = nHits++;
+				while (j > 0 && hits[j - 1].tNear < e.tNear)
+				{
+					hits[j] = hits[j - 1];
+					--j;
+				}
+				hits[j] = e;
+			}
+			for (int i = 0; i < nHits; ++i)
+				stack[stackSize++] = hits[i];
+		}
+
+		++nBVHRays;
+		nBVHHits += found;
+		ReportValue(nodesPerQuery, nodesVisited);
+		ReportValue(primitiveTestsPerQuery, primitiveTests);
+		nBVHPrimitiveTests += primitiveTests;
+		nBruteForceTests += (int64_t)primitives.size();
+		return found;
+	}
+
+	template <int N>
+	bool WideBVHAccel<N>::IntersectP(const Ray & ray) const
+	{
+		ProfilePhase _(Prof::AccelIntersectP);
+		if (nodes.empty()) return false;
+
+		int64_t nodesVisited = 0, primitiveTests = 0;
+		bool hit = false;
+		WideRay r(ray);
+
+		// ֻҪҵ⽻㣬Ҫ
+		StackEntry stack[64 * N];
+		int stackSize = 0;
+		stack[stackSize++] = { 0, 0, 0.f };
+		while (stackSize > 0 && !hit)
+		{
+			StackEntry entry = stack[--stackSize];
+			if (entry.nPrimitives > 0)
+			{
+				for (int i = 0; i < entry.nPrimitives; ++i)
+				{
+					++primitiveTests;
+					if (primitiveHandles[entry.index + i].IntersectP(ray))
+					{
+						hit = true;
+						break;
+					}
+				}
+				continue;
+			}
+
+			++nodesVisited;
+			const WideBVHNode<N> &node = nodes[entry.index];
+			float tNear[N];
+			int mask = IntersectChildren<N>(node, r, ray.tMax, tNear);
+			for (int i = 0; i < N; ++i)
+				if (mask & (1 << i))
+					stack[stackSize++] = { node.child[i], node.nPrimitives[i], tNear[i] };
+		}
+
+		++nBVHShadowRays;
+		nBVHShadowHits += hit;
+		ReportValue(nodesPerQuery, nodesVisited);
+		ReportValue(primitiveTestsPerQuery, primitiveTests);
+		nBVHPrimitiveTests += primitiveTests;
+		nBruteForceTests += (int64_t)primitives.size();
+		return hit;
+	}
+
+	template <int N>
+	void WideBVHAccel<N>::ReportStats(FILE * dest) const
+	{
+		ReportBVHStats(dest, N == 4 ? "QBVH" : "OBVH", buildStats);
+	}
+
+	template class WideBVHAccel<4>;
+	template class WideBVHAccel<8>;
+
+
+	bool ParseAccelType(const std::string & name, AccelType * type)
+	{
+		if (name == "bvh")
+			*type = AccelType::BVH;
+		else if (name == "qbvh")
+			*type = AccelType::QBVH;
+		else if (name == "obvh")
+			*type = AccelType::OBVH;
+		else
+			return false;
+		return true;
+	}
+
+	const char * AccelTypeName(AccelType type)
+	{
+		switch (type)
+		{
+		case AccelType::QBVH:
+			return "qbvh";
+		case AccelType::OBVH:
+			return "obvh";
+		default:
+			return "bvh";
+		}
+	}
+
+	std::shared_ptr<Aggregate> CreateAccel(AccelType type, std::vector<std::shared_ptr<Primitive>> prims,
+		const BVHBuildStats ** buildStats)
+	{
+		switch (type)
+		{
+		case AccelType::QBVH:
+		{
+			auto accel = std::make_shared<QBVHAccel>(std::move(prims));
+			if (buildStats)
+				*buildStats = &accel->GetBuildStats();
+			return accel;
+		}
+		case AccelType::OBVH:
+		{
+			auto accel = std::make_shared<OBVHAccel>(std::move(prims));
+			if (buildStats)
+				*buildStats = &accel->GetBuildStats();
+			return accel;
+		}
+		default:
+		{
+			auto accel = std::make_shared<BVHAccel>(std::move(prims));
+			if (buildStats)
+				*buildStats = &accel->GetBuildStats();
+			return accel;
+		}
+		}
+	}
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bvh.h"
+
+
+namespace pbrt
+{
+	// NӵİΧаSoAţȴNxٴNyһһξܲȫӡ
+	// N = 4 ʱSSEN = 8 ʱAVX֧ʱ˻رѭ
+	template <int N>
+	struct alignas(64) WideBVHNode
+	{
+		float bMin[3][N];
+		float bMax[3][N];
+		// ڲڵʱΪڵ±ꣻҶʱΪͼԪʼλ
+		int32_t child[N];
+		// 0ʾڲڵ㣬>0ʾҶеͼԪ
+		// ûϵĲλΧΪգpMin = +infpMax = -infԶᱻС
+		uint8_t nPrimitives[N];
+	};
+
+
+	template <int N>
+	class WideBVHAccel : public Aggregate
+	{
+	public:
+		static_assert(N == 4 || N == 8, "WideBVHAccel supports 4 or 8 children");
+
+		WideBVHAccel(std::vector<std::shared_ptr<Primitive>> p,
+			int maxPrimsInNode = 4,
+			BVHSplitMethod splitMethod = BVHSplitMethod::SAH);
+
+		virtual Bounds3f WorldBound() const { return bounds; }
+		virtual bool IntersectHit(const Ray &ray, SurfaceHit *hit) const;
+		virtual bool IntersectP(const Ray &ray) const;
+
+		const BVHBuildStats &GetBuildStats() const { return buildStats; }
+		void ReportStats(FILE *dest) const;
+
+	private:
+		int collapse(const AlignedVector<LinearBVHNode> &binary, int binaryIndex, int depth);
+
+		// WideBVHAccel Private Data
+		std::vector<std::shared_ptr<Primitive>> primitives;
+		// primitivesһһӦҶGeometricPrimitive麯
+		std::vector<PrimitiveHandle> primitiveHandles;
+		AlignedVector<WideBVHNode<N>> nodes;
+		Bounds3f bounds;
+
+		BVHBuildStats buildStats;
+	};
+
+	typedef WideBVHAccel<4> QBVHAccel;
+	typedef WideBVHAccel<8> OBVHAccel;
+
+
+	// ͼԪľۺBVHֽṹ󽻽ӿͬ԰лȽ
+	enum class AccelType { BVH, QBVH, OBVH };
+
+	// nameΪ"bvh""qbvh""obvh"ʶʱfalse
+	bool ParseAccelType(const std::string &name, AccelType *type);
+	const char *AccelTypeName(AccelType type);
+
+	// ҶӴСøṹĬֵbuildStatsΪʱָ򽨺õĽṹĹͳ
+	std::shared_ptr<Aggregate> CreateAccel(AccelType type, std::vector<std::shared_ptr<Primitive>> prims,
+		const BVHBuildStats **buildStats = nullptr);
+}
@@ -1,5 +1,7 @@
 #include "Shape.h"
 #include "transform.h"
+#include "raypacket.h"
+#include "interaction.h"
 
 namespace pbrt
 {
@@ -15,4 +17,43 @@ namespace pbrt
 	{
 		return (*ObjectToWorld)(ObjectBound());
 	}
+
+	bool Shape::IntersectHit(const Ray & ray, SurfaceHit * hit, bool testAlphaTexture) const
+	{
+		Float tHit;
+		if (!Intersect(ray, &tHit, nullptr, testAlphaTexture))
+			return false;
+		hit->tHit = tHit;
+		return true;
+	}
+
+	void Shape::ComputeSurfaceInteraction(const Ray & ray, const SurfaceHit & hit, SurfaceInteraction * isect) const
+	{
+		// һνhit.tHit뱾״Ľ㣬ԲtMaxҲõͬһ㣻
+		// tMaxtHitý㱻ܾ
+		Ray r(ray.o, ray.d, std::numeric_limits<Float>::infinity(), ray.time);
+		Float tHit;
+		bool found = Intersect(r, &tHit, isect);
+		DCHECK(found);
+		(void)found;
+	}
+
+	uint32_t Shape::IntersectPacket(const RayPacket & packet, uint32_t activeMask, Float * tHit, SurfaceInteraction * isect, bool testAlphaTexture) const
+	{
+		uint32_t hitMask = 0;
+		for (int i = 0; i < packet.size; ++i)
+			if ((activeMask & (1u << i)) &&
+				Intersect(packet.GetRay(i), &tHit[i], &isect[i], testAlphaTexture))
+				hitMask |= 1u << i;
+		return hitMask;
+	}
+
+	uint32_t Shape::IntersectPPacket(const RayPacket & packet, uint32_t activeMask, bool testAlphaTexture) const
+	{
+		uint32_t hitMask = 0;
+		for (int i = 0; i < packet.size; ++i)
+			if ((activeMask & (1u << i)) && IntersectP(packet.GetRay(i), testAlphaTexture))
+				hitMask |= 1u << i;
+		return hitMask;
+	}
 }
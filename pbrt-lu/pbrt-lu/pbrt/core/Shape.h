@@ -1,13 +1,18 @@
 #pragma once
 
 
+#include <cstdint>
+
 #include "geometry.h"
+#include "taggedpointer.h"
 
 
 namespace pbrt
 {
 	class Transform;
 	class SurfaceInteraction;
+	struct SurfaceHit;
+	struct RayPacket;
 
 	class Shape
 	{
@@ -35,10 +40,55 @@ namespace pbrt
 			return Intersect(ray, nullptr, nullptr, testAlphaTexture);
 		}
 
+		// ӳٹ콻㣺IntersectHitֻдhit->tHitprimIndexuv
+		// ȷĽComputeSurfaceInteractionSurfaceInteraction
+		// ĬʵֶתIntersect״ṩ˵İ汾
+		virtual bool IntersectHit(const Ray &ray, SurfaceHit *hit,
+			bool testAlphaTexture = true) const;
+
+		virtual void ComputeSurfaceInteraction(const Ray &ray, const SurfaceHit &hit,
+			SurfaceInteraction *isect) const;
+
+		// ߰汾ֻactiveMaskеߣ룬tHitisect±Ӧ
+		// Ĭʵı汾״԰ṩ󽻵ʵ֡
+		virtual uint32_t IntersectPacket(const RayPacket &packet, uint32_t activeMask,
+			Float *tHit, SurfaceInteraction *isect,
+			bool testAlphaTexture = true) const;
+
+		virtual uint32_t IntersectPPacket(const RayPacket &packet, uint32_t activeMask,
+			bool testAlphaTexture = true) const;
+
 
 		virtual Float Area() const = 0;
 
 	};
+
+
+	class Sphere;
+	class TriangleMeshShape;
+	class SphereCloud;
+
+	// ״ľ̬ɣͱswitch״ֱӵãٽṹҶﲻþ
+	// ⼸״඼finalģ֪õĸ
+	// ״Լչ״ȻֻͨShape麯ʹãFromShapeǷؿյľ
+	// Աshapedispatch.hõĵطҪ
+	class ShapeHandle : public TaggedPointer<Sphere, TriangleMeshShape, SphereCloud>
+	{
+	public:
+		using TaggedPointer::TaggedPointer;
+
+		static ShapeHandle FromShape(const Shape *shape);
+
+		Bounds3f ObjectBound() const;
+		Bounds3f WorldBound() const;
+		Float Area() const;
+
+		bool IntersectP(const Ray &ray) const;
+		bool IntersectHit(const Ray &ray, SurfaceHit *hit) const;
+		uint32_t IntersectPacket(const RayPacket &packet, uint32_t activeMask,
+			Float *tHit, SurfaceInteraction *isect) const;
+		uint32_t IntersectPPacket(const RayPacket &packet, uint32_t activeMask) const;
+	};
 }
 
 
@@ -0,0 +1,72 @@
+#include "adaptive.h"
+#include "stats.h"
+
+#include <cmath>
+
+
+namespace pbrt
+{
+	STAT_INT_DISTRIBUTION("Adaptive sampling/Samples per pixel", samplesPerPixel);
+	STAT_PERCENT("Adaptive sampling/Pixels converged below the noise threshold", nConvergedPixels, nPixels);
+	STAT_COUNTER("Adaptive sampling/Passes", nPasses);
+
+	// ֵСذжϣȫԱߵİԶ""
+	static const double MinLuminance = 1e-3;
+
+	AdaptiveSampling::AdaptiveSampling(const Bounds2i & pixelBounds, const AdaptiveSamplingOptions & options)
+		: pixelBounds(pixelBounds), options(options),
+		width(std::max(0, pixelBounds.pMax.x - pixelBounds.pMin.x)),
+		pixels((size_t)width * std::max(0, pixelBounds.pMax.y - pixelBounds.pMin.y))
+	{
+		DCHECK(options.minSamples > 0 && options.passSamples > 0 && options.maxSamples >= options.minSamples);
+		activePixels = (int64_t)pixels.size();
+	}
+
+	Float AdaptiveSampling::RelativeError(const PixelState & pixel) const
+	{
+		if (pixel.n < 2)
+			return std::numeric_limits<Float>::infinity();
+		double variance = pixel.m2 / (pixel.n - 1);
+		double stdError = std::sqrt(variance / pixel.n);
+		return (Float)(stdError / std::max(pixel.mean, MinLuminance));
+	}
+
+	Float AdaptiveSampling::RelativeError(const Point2i & p) const
+	{
+		return RelativeError(GetPixel(p));
+	}
+
+	int64_t AdaptiveSampling::EndPass()
+	{
+		++passes;
+		activePixels = 0;
+		for (PixelState &pixel : pixels)
+		{
+			if (!pixel.active)
+				continue;
+			if (pixel.n >= options.minSamples && options.errorThreshold > 0 &&
+				RelativeError(pixel) < options.errorThreshold)
+			{
+				pixel.active = false;
+				pixel.converged = true;
+			}
+			else if (pixel.n >= options.maxSamples)
+				pixel.active = false;
+			else
+				++activePixels;
+		}
+		return activePixels;
+	}
+
+	void AdaptiveSampling::ReportStats() const
+	{
+		nPasses += passes;
+		for (const PixelState &pixel : pixels)
+		{
+			ReportValue(samplesPerPixel, pixel.n);
+			++nPixels;
+			if (pixel.converged)
+				++nConvergedPixels;
+		}
+	}
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "geometry.h"
+
+
+// Ӧͼ񰴱飨passȾÿһֻû
+// ÿWelford㷨άȵľֵͷֵԱ׼
+//   sqrt( / n) / ֵ
+// ֵminSamplesʱֹͣﵽmaxSamplesʱҲֹͣ
+// աܿǰͣˣ֮ı飨ԼʱԤ㣩ϡ
+//
+//   AdaptiveSampling adaptive(bounds, options);
+//   do
+//   {
+//       // ̣߳p[adaptive.SampleCount(p), + adaptive.SamplesThisPass(p))
+//       //         ÿadaptive.AddSample(p, rgb)
+//   } while (adaptive.EndPass() > 0 && ʱû);
+namespace pbrt
+{
+	struct AdaptiveSamplingOptions
+	{
+		int minSamples = 16;          // һÿصжǰҪô
+		int maxSamples = 1024;
+		int passSamples = 4;          // ֮ÿһÿδӵ
+		Float errorThreshold = 0;     // ֵ0ʾֹͣ
+	};
+
+	class AdaptiveSampling
+	{
+	public:
+		AdaptiveSampling(const Bounds2i &pixelBounds, const AdaptiveSamplingOptions &options);
+
+		// pһҪɵ0ʾѾֹͣ
+		int SamplesThisPass(const Point2i &p) const
+		{
+			const PixelState &pixel = GetPixel(p);
+			if (!pixel.active)
+				return 0;
+			int n = pixel.n == 0 ? options.minSamples : options.passSamples;
+			return std::min(n, options.maxSamples - pixel.n);
+		}
+
+		// pеҲһһ
+		int SampleCount(const Point2i &p) const { return GetPixel(p).n; }
+
+		// ͬһزܱ߳ͬʱ£ParallelFor2DĿ黥صҪ
+		void AddSample(const Point2i &p, const Float rgb[3])
+		{
+			PixelState &pixel = GetPixel(p);
+			double y = 0.212671f * rgb[0] + 0.715160f * rgb[1] + 0.072169f * rgb[2];
+			++pixel.n;
+			double delta = y - pixel.mean;
+			pixel.mean += delta / pixel.n;
+			pixel.m2 += delta * (y - pixel.mean);
+		}
+
+		// ֵԱ׼
+		Float RelativeError(const Point2i &p) const;
+
+		// һڵ߳еãÿǷػڲ
+		int64_t EndPass();
+
+		int64_t ActivePixels() const { return activePixels; }
+		int Passes() const { return passes; }
+		const Bounds2i &GetPixelBounds() const { return pixelBounds; }
+
+		// ÿصͳƣǰ̣߳ʱһ
+		void ReportStats() const;
+
+	private:
+		struct PixelState
+		{
+			double mean = 0, m2 = 0;
+			int32_t n = 0;
+			bool active = true;
+			bool converged = false;   // Ϊֵֹͣ
+		};
+
+		PixelState &GetPixel(const Point2i &p)
+		{
+			DCHECK(p.x >= pixelBounds.pMin.x && p.x < pixelBounds.pMax.x);
+			DCHECK(p.y >= pixelBounds.pMin.y && p.y < pixelBounds.pMax.y);
+			return pixels[(p.y - pixelBounds.pMin.y) * width + (p.x - pixelBounds.pMin.x)];
+		}
+		const PixelState &GetPixel(const Point2i &p) const
+		{
+			return const_cast<AdaptiveSampling *>(this)->GetPixel(p);
+		}
+		Float RelativeError(const PixelState &pixel) const;
+
+		Bounds2i pixelBounds;
+		AdaptiveSamplingOptions options;
+		int width;
+		std::vector<PixelState> pixels;
+		int64_t activePixels;
+		int passes = 0;
+	};
+}
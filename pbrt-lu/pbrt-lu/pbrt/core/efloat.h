@@ -0,0 +1,184 @@
+#pragma once
+
+
+#include <algorithm>
+
+#include "geometry.h"
+
+
+namespace pbrt
+{
+	// ĸvͨĸ[low, high]صذס˾ȷֵ
+	// ÿ㶼һulpNextFloatDown/NextFloatUp֤©ȷֵ
+	class EFloat
+	{
+	public:
+		EFloat() {}
+
+		EFloat(float v, float err = 0.f) : v(v)
+		{
+			if (err == 0.)
+				low = high = v;
+			else
+			{
+				low = NextFloatDown(v - err);
+				high = NextFloatUp(v + err);
+			}
+		}
+
+		EFloat operator+(EFloat ef) const
+		{
+			EFloat r;
+			r.v = v + ef.v;
+			r.low = NextFloatDown(LowerBound() + ef.LowerBound());
+			r.high = NextFloatUp(UpperBound() + ef.UpperBound());
+			r.Check();
+			return r;
+		}
+
+		EFloat operator-(EFloat ef) const
+		{
+			EFloat r;
+			r.v = v - ef.v;
+			r.low = NextFloatDown(LowerBound() - ef.UpperBound());
+			r.high = NextFloatUp(UpperBound() - ef.LowerBound());
+			r.Check();
+			return r;
+		}
+
+		EFloat operator*(EFloat ef) const
+		{
+			EFloat r;
+			r.v = v * ef.v;
+			Float prod[4] = { LowerBound() * ef.LowerBound(), UpperBound() * ef.LowerBound(),
+				LowerBound() * ef.UpperBound(), UpperBound() * ef.UpperBound() };
+			r.low = NextFloatDown(std::min(std::min(prod[0], prod[1]), std::min(prod[2], prod[3])));
+			r.high = NextFloatUp(std::max(std::max(prod[0], prod[1]), std::max(prod[2], prod[3])));
+			r.Check();
+			return r;
+		}
+
+		EFloat operator/(EFloat ef) const
+		{
+			EFloat r;
+			r.v = v / ef.v;
+			if (ef.low < 0 && ef.high > 0)
+			{
+				// 0ֵ
+				r.low = -std::numeric_limits<Float>::infinity();
+				r.high = std::numeric_limits<Float>::infinity();
+			}
+			else
+			{
+				Float div[4] = { LowerBound() / ef.LowerBound(), UpperBound() / ef.LowerBound(),
+					LowerBound() / ef.UpperBound(), UpperBound() / ef.UpperBound() };
+				r.low = NextFloatDown(std::min(std::min(div[0], div[1]), std::min(div[2], div[3])));
+				r.high = NextFloatUp(std::max(std::max(div[0], div[1]), std::max(div[2], div[3])));
+			}
+			r.Check();
+			return r;
+		}
+
+		EFloat operator-() const
+		{
+			EFloat r;
+			r.v = -v;
+			r.low = -high;
+			r.high = -low;
+			r.Check();
+			return r;
+		}
+
+		bool operator==(EFloat fe) const { return v == fe.v; }
+
+		explicit operator float() const { return v; }
+		explicit operator double() const { return v; }
+
+		float GetAbsoluteError() const
+		{
+			return NextFloatUp(std::max(std::abs(high - v), std::abs(v - low)));
+		}
+		float UpperBound() const { return high; }
+		float LowerBound() const { return low; }
+
+		void Check() const
+		{
+			if (!std::isinf(low) && !std::isnan(low) && !std::isinf(high) && !std::isnan(high))
+				DCHECK(low <= high);
+		}
+
+	private:
+		float v, low, high;
+
+		friend inline EFloat sqrt(EFloat fe);
+		friend inline EFloat abs(EFloat fe);
+		friend inline bool Quadratic(EFloat A, EFloat B, EFloat C, EFloat *t0, EFloat *t1);
+	};
+
+
+	inline EFloat operator*(float f, EFloat fe) { return EFloat(f) * fe; }
+
+	inline EFloat operator/(float f, EFloat fe) { return EFloat(f) / fe; }
+
+	inline EFloat operator+(float f, EFloat fe) { return EFloat(f) + fe; }
+
+	inline EFloat operator-(float f, EFloat fe) { return EFloat(f) - fe; }
+
+	inline EFloat sqrt(EFloat fe)
+	{
+		EFloat r;
+		r.v = std::sqrt(fe.v);
+		r.low = NextFloatDown(std::sqrt(fe.low));
+		r.high = NextFloatUp(std::sqrt(fe.high));
+		r.Check();
+		return r;
+	}
+
+	inline EFloat abs(EFloat fe)
+	{
+		if (fe.low >= 0)
+			return fe;
+		else if (fe.high <= 0)
+		{
+			EFloat r;
+			r.v = -fe.v;
+			r.low = -fe.high;
+			r.high = -fe.low;
+			r.Check();
+			return r;
+		}
+		else
+		{
+			// 0
+			EFloat r;
+			r.v = std::abs(fe.v);
+			r.low = 0;
+			r.high = std::max(-fe.low, fe.high);
+			r.Check();
+			return r;
+		}
+	}
+
+	//  A t^2 + B t + C = 0t0 <= t1
+	// бʽdouble㣻qȡ -B  sqrt(бʽ) ʱcatastrophic cancellation
+	inline bool Quadratic(EFloat A, EFloat B, EFloat C, EFloat *t0, EFloat *t1)
+	{
+		double discrim = (double)B.v * (double)B.v - 4. * (double)A.v * (double)C.v;
+		if (discrim < 0.)
+			return false;
+		double rootDiscrim = std::sqrt(discrim);
+
+		EFloat floatRootDiscrim((float)rootDiscrim, (float)(MachineEpsilon * rootDiscrim));
+
+		EFloat q;
+		if ((float)B < 0)
+			q = -.5f * (B - floatRootDiscrim);
+		else
+			q = -.5f * (B + floatRootDiscrim);
+		*t0 = q / A;
+		*t1 = C / q;
+		if ((float)*t0 > (float)*t1)
+			std::swap(*t0, *t1);
+		return true;
+	}
+}
@@ -0,0 +1,120 @@
+#include "film.h"
+#include "stats.h"
+
+#include <algorithm>
+
+
+namespace pbrt
+{
+	STAT_COUNTER("Film/Splats outside the resident rows", nSplatsDropped);
+
+	FilmTile::FilmTile(const Bounds2i & pixelBounds, MemoryArena & arena)
+		: pixelBounds(pixelBounds),
+		width(std::max(0, pixelBounds.pMax.x - pixelBounds.pMin.x))
+	{
+		pixels = arena.Alloc<FilmTilePixel>((size_t)width * std::max(0, pixelBounds.pMax.y - pixelBounds.pMin.y));
+	}
+
+
+	Film::Film(const Point2i & resolution, const std::string & filename, int residentRows)
+		: fullResolution(resolution),
+		filename(filename),
+		bandHeight(residentRows > 0 ? std::min(residentRows, resolution.y) : resolution.y),
+		pixels(new Pixel[(size_t)resolution.x * bandHeight])
+	{
+		ok = writer.Open(filename, resolution);
+	}
+
+	Bounds2i Film::GetCurrentBand() const
+	{
+		Bounds2i band;
+		band.pMin = Point2i(0, bandY0);
+		band.pMax = Point2i(fullResolution.x, std::min(bandY0 + bandHeight, fullResolution.y));
+		return band;
+	}
+
+	FilmTile * Film::GetFilmTile(const Bounds2i & pixelBounds, MemoryArena & arena) const
+	{
+		Bounds2i band = GetCurrentBand(), tileBounds;
+		tileBounds.pMin = Point2i(std::max(pixelBounds.pMin.x, band.pMin.x), std::max(pixelBounds.pMin.y, band.pMin.y));
+		tileBounds.pMax = Point2i(std::min(pixelBounds.pMax.x, band.pMax.x), std::min(pixelBounds.pMax.y, band.pMax.y));
+		return ARENA_ALLOC(arena, FilmTile)(tileBounds, arena);
+	}
+
+	void Film::MergeFilmTile(const FilmTile & tile)
+	{
+		ProfilePhase _(Prof::FilmMerge);
+		const Bounds2i &bounds = tile.GetPixelBounds();
+		for (int y = bounds.pMin.y; y < bounds.pMax.y; ++y)
+		{
+			for (int x = bounds.pMin.x; x < bounds.pMax.x; ++x)
+			{
+				const FilmTilePixel &tilePixel = tile.GetPixel(Point2i(x, y));
+				Pixel &mergePixel = GetPixel(Point2i(x, y));
+				for (int k = 0; k < 3; ++k)
+					mergePixel.rgb[k].Add(tilePixel.contribSum[k]);
+				mergePixel.filterWeightSum.Add(tilePixel.filterWeightSum);
+			}
+		}
+	}
+
+	void Film::AddSplat(const Point2f & p, const Float rgb[3])
+	{
+		int x = (int)std::floor(p.x), y = (int)std::floor(p.y);
+		if (x < 0 || x >= fullResolution.x || y < 0 || y >= fullResolution.y)
+			return;
+		if (y < bandY0 || y >= bandY0 + bandHeight)
+		{
+			++nSplatsDropped;
+			return;
+		}
+		Pixel &pixel = GetPixel(Point2i(x, y));
+		for (int k = 0; k < 3; ++k)
+			pixel.splatRGB[k].Add(rgb[k]);
+	}
+
+	bool Film::FinishBand(Float splatScale)
+	{
+		DCHECK(!Done());
+		Bounds2i band = GetCurrentBand();
+		const int width = fullResolution.x;
+
+		// ÿתдУתõĻεĴС
+		const int rowsPerWrite = 16;
+		std::vector<Float> rgb(3 * (size_t)width * rowsPerWrite);
+		for (int y0 = band.pMin.y; y0 < band.pMax.y; y0 += rowsPerWrite)
+		{
+			int nRows = std::min(rowsPerWrite, band.pMax.y - y0);
+			Pixel *rowPixels = &GetPixel(Point2i(0, y0));
+			for (size_t i = 0; i < (size_t)nRows * width; ++i)
+			{
+				Pixel &pixel = rowPixels[i];
+				Float filterWeightSum = pixel.filterWeightSum;
+				for (int k = 0; k < 3; ++k)
+				{
+					Float v = filterWeightSum != 0 ? pixel.rgb[k] / filterWeightSum : 0;
+					rgb[3 * i + k] = v + splatScale * pixel.splatRGB[k];
+				}
+
+				// գһʹ
+				for (int k = 0; k < 3; ++k)
+				{
+					pixel.rgb[k] = 0;
+					pixel.splatRGB[k] = 0;
+				}
+				pixel.filterWeightSum = 0;
+			}
+			ok = ok && writer.WriteRows(y0, nRows, rgb.data());
+		}
+
+		bandY0 += bandHeight;
+		if (Done())
+			ok = writer.Close() && ok;
+		return ok;
+	}
+
+	size_t Film::BytesUsed() const
+	{
+		return sizeof(*this) + (size_t)fullResolution.x * bandHeight * sizeof(Pixel);
+	}
+}
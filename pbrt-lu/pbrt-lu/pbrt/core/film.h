@@ -0,0 +1,131 @@
+#pragma once
+
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "geometry.h"
+#include "imageio.h"
+#include "memory.h"
+#include "parallel.h"
+#include "profile.h"
+
+
+namespace pbrt
+{
+	struct FilmTilePixel
+	{
+		Float contribSum[3] = { 0, 0, 0 };
+		Float filterWeightSum = 0;
+	};
+
+	// һ߳Ⱦһͼʱ˽еĻд벻ҪͬȾ꽻Film::MergeFilmTile
+	// ˲ǰ뾶0.5ĺʽ˲ֻڵǸڵĿ黥ص
+	// طȾ̵߳arenaϣarena ResetʧЧ
+	class FilmTile
+	{
+	public:
+		FilmTile(const Bounds2i &pixelBounds, MemoryArena &arena);
+
+		// pfloor(x + dx)ƣxϴdxӽ1ʱӷλһ
+		void AddSample(const Point2i &p, const Float rgb[3], Float sampleWeight = 1)
+		{
+			ProfilePhase _(Prof::FilmAddSample);
+			if (p.x < pixelBounds.pMin.x || p.x >= pixelBounds.pMax.x ||
+				p.y < pixelBounds.pMin.y || p.y >= pixelBounds.pMax.y)
+				return;
+			FilmTilePixel &pixel = GetPixel(p);
+			for (int k = 0; k < 3; ++k)
+				pixel.contribSum[k] += rgb[k] * sampleWeight;
+			pixel.filterWeightSum += sampleWeight;
+		}
+
+		FilmTilePixel &GetPixel(const Point2i &p)
+		{
+			DCHECK(p.x >= pixelBounds.pMin.x && p.x < pixelBounds.pMax.x);
+			DCHECK(p.y >= pixelBounds.pMin.y && p.y < pixelBounds.pMax.y);
+			return pixels[(p.y - pixelBounds.pMin.y) * width + (p.x - pixelBounds.pMin.x)];
+		}
+		const FilmTilePixel &GetPixel(const Point2i &p) const
+		{
+			return const_cast<FilmTile *>(this)->GetPixel(p);
+		}
+
+		const Bounds2i &GetPixelBounds() const { return pixelBounds; }
+
+	private:
+		Bounds2i pixelBounds;
+		int width;
+		FilmTilePixel *pixels;
+	};
+
+
+	// ͼƬ߳ȾĿϲдļ
+	// ϲsplatǶصԭӸۼӣҪȫֵ
+	//
+	// ʽresidentRowsΪ0ʱͼϵ°residentRowsһΣbandȾ
+	// ڴֻеǰһεءһȾFinishBandдļԼλã
+	// պƵһΡ16KͼҲֻҪ  x residentRows صڴ档
+	// residentRowsΪ0ʱֻһΣͼ
+	//
+	//   Film film(resolution, "out.pfm", 64);
+	//   while (!film.Done())
+	//   {
+	//       ParallelFor2D(..., film.GetCurrentBand());   // GetFilmTile / AddSample / MergeFilmTile
+	//       film.FinishBand();
+	//   }
+	class Film
+	{
+	public:
+		Film(const Point2i &resolution, const std::string &filename, int residentRows = 0);
+
+		// ļǷ򿪳ɹʧʱѾ˴Ϣ
+		bool Ok() const { return ok; }
+
+		// ǰεطΧ
+		Bounds2i GetCurrentBand() const;
+		// жζд
+		bool Done() const { return bandY0 >= fullResolution.y; }
+
+		// pixelBoundsǰεĲֱõضarena
+		FilmTile *GetFilmTile(const Bounds2i &pixelBounds, MemoryArena &arena) const;
+		// ߳̿ͬʱϲ֮ص
+		void MergeFilmTile(const FilmTile &tile);
+
+		// ·صĹף˲ȨصĹһ߳̿ͬʱá
+		// ʽʱڵǰsplat޷棬ᱻͳм
+		void AddSplat(const Point2f &p, const Float rgb[3]);
+
+		// ѵǰдļպƵһΣдһʱرļ
+		// ֵΪ Ȩƽ + splatScale * splat
+		bool FinishBand(Float splatScale = 1);
+
+		size_t BytesUsed() const;
+
+		const Point2i fullResolution;
+		const std::string filename;
+		const int bandHeight;
+
+	private:
+		// 32ֽڣռһ
+		struct Pixel
+		{
+			AtomicFloat rgb[3];
+			AtomicFloat filterWeightSum;
+			AtomicFloat splatRGB[3];
+			Float pad;
+		};
+
+		Pixel &GetPixel(const Point2i &p)
+		{
+			DCHECK(p.x >= 0 && p.x < fullResolution.x && p.y >= bandY0 && p.y < bandY0 + bandHeight);
+			return pixels[(p.y - bandY0) * fullResolution.x + p.x];
+		}
+
+		std::unique_ptr<Pixel[]> pixels;
+		int bandY0 = 0;
+		ImageWriter writer;
+		bool ok;
+	};
+}
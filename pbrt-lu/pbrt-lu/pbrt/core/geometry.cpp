@@ -1,3 +1,7 @@
+#include "geometry.h"
 
 
-
+namespace pbrt
+{
+	STAT_GLOBAL_PERCENT("Geometry/Ray-bounds hits", nBoundsHits, nBoundsTests);
+}
@@ -1,11 +1,15 @@
 #pragma once
 
 
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <limits>
 #include <utility>
 
 #include "../pbrt.h"
+#include "stats.h"
 
 
 namespace pbrt
@@ -15,6 +19,10 @@ namespace pbrt
 #define MachineEpsilon (std::numeric_limits<Float>::epsilon() * 0.5)
 
 
+	// Bounds3::IntersectPĲԴдgeometry.cpp
+	STAT_EXTERN_PERCENT(nBoundsHits, nBoundsTests);
+
+
 	static constexpr Float Pi = 3.14159265358979323846;
 
 
@@ -38,6 +46,41 @@ namespace pbrt
 		return (n * MachineEpsilon) / (1 - n * MachineEpsilon);
 	}
 
+	inline uint32_t FloatToBits(float f) {
+		uint32_t ui;
+		memcpy(&ui, &f, sizeof(float));
+		return ui;
+	}
+
+	inline float BitsToFloat(uint32_t ui) {
+		float f;
+		memcpy(&f, &ui, sizeof(uint32_t));
+		return f;
+	}
+
+	// vһ⣩-0.fҪȱ0.fߵķ֧
+	inline float NextFloatUp(float v) {
+		if (std::isinf(v) && v > 0.) return v;
+		if (v == -0.f) v = 0.f;
+		uint32_t ui = FloatToBits(v);
+		if (v >= 0)
+			++ui;
+		else
+			--ui;
+		return BitsToFloat(ui);
+	}
+
+	inline float NextFloatDown(float v) {
+		if (std::isinf(v) && v < 0.) return v;
+		if (v == 0.f) v = -0.f;
+		uint32_t ui = FloatToBits(v);
+		if (v > 0)
+			--ui;
+		else
+			++ui;
+		return BitsToFloat(ui);
+	}
+
 
 	template<typename T>
 	class Point2;
@@ -69,6 +112,14 @@ namespace pbrt
 			return value;
 	}
 
+	inline Float SafeASin(Float x) {
+		return std::asin(Clamp(x, (Float)-1, (Float)1));
+	}
+
+	inline Float SafeACos(Float x) {
+		return std::acos(Clamp(x, (Float)-1, (Float)1));
+	}
+
 	// ת
 	inline Float Radians(Float deg) { return (Pi / 180) * deg; }
 
@@ -791,7 +842,7 @@ namespace pbrt
 
 		bool HasNaNs() const { return (o.HasNaNs() || d.HasNaNs() || isNaN(tMax)); }
 
-		Point3f operator() (Float t)
+		Point3f operator() (Float t) const
 		{
 			return o + d * t;
 		}
@@ -913,6 +964,7 @@ namespace pbrt
 		bool IntersectP(const Ray &ray, Float *hitt0 = nullptr,
 			Float *hitt1 = nullptr) const
 		{
+			++nBoundsTests;
 			Float t0 = 0.0, t1 = ray.tMax;
 			for (int i = 0; i < 3; i++)
 			{
@@ -943,9 +995,42 @@ namespace pbrt
 			if (hitt0) *hitt0 = t0;
 			if (hitt1) *hitt1 = t1;
 
+			++nBoundsHits;
 			return true;
 		}
 
+		// BVHʱõĿٰ汾invDirdirIsNegÿֻһΣ
+		// ﲻҲҪtNear/tFarİ汾һ¡
+		inline bool IntersectP(const Ray &ray, const Vector3f &invDir,
+			const int dirIsNeg[3]) const
+		{
+			const Bounds3<T> &bounds = *this;
+			++nBoundsTests;
+
+			Float tMin = (bounds[dirIsNeg[0]].x - ray.o.x) * invDir.x;
+			Float tMax = (bounds[1 - dirIsNeg[0]].x - ray.o.x) * invDir.x;
+			Float tyMin = (bounds[dirIsNeg[1]].y - ray.o.y) * invDir.y;
+			Float tyMax = (bounds[1 - dirIsNeg[1]].y - ray.o.y) * invDir.y;
+
+			tMax *= 1 + 2 * gamma(3);
+			tyMax *= 1 + 2 * gamma(3);
+			if (tMin > tyMax || tyMin > tMax) return false;
+			if (tyMin > tMin) tMin = tyMin;
+			if (tyMax < tMax) tMax = tyMax;
+
+			Float tzMin = (bounds[dirIsNeg[2]].z - ray.o.z) * invDir.z;
+			Float tzMax = (bounds[1 - dirIsNeg[2]].z - ray.o.z) * invDir.z;
+
+			tzMax *= 1 + 2 * gamma(3);
+			if (tMin > tzMax || tzMin > tMax) return false;
+			if (tzMin > tMin) tMin = tzMin;
+			if (tzMax < tMax) tMax = tzMax;
+
+			bool hit = (tMin < ray.tMax) && (tMax > 0);
+			nBoundsHits += hit;
+			return hit;
+		}
+
 	};
 
 
@@ -999,7 +1084,121 @@ namespace pbrt
 		return ret;
 	}
 
-}
+	template <typename T>
+	Bounds3<T> Union(const Bounds3<T> &b1, const Bounds3<T> &b2)
+	{
+		Bounds3<T> ret;
+		ret.pMin = Min(b1.pMin, b2.pMin);
+		ret.pMax = Max(b1.pMax, b2.pMax);
+		return ret;
+	}
+
+
+	template <typename T>
+	inline Vector3<T> operator*(T s, const Vector3<T> &v) { return v * s; }
+
+	template <typename T>
+	inline Normal3<T> operator*(T s, const Normal3<T> &n) { return n * s; }
+
+	template <typename T>
+	inline Point3<T> operator*(T s, const Point3<T> &p) { return p * s; }
+
+	template <typename T>
+	inline Vector3<T> Abs(const Vector3<T> &v) {
+		return Vector3<T>(std::abs(v.x), std::abs(v.y), std::abs(v.z));
+	}
+
+	template <typename T>
+	inline T Dot(const Vector3<T> &v1, const Vector3<T> &v2) {
+		DCHECK(!v1.HasNaNs() && !v2.HasNaNs());
+		return v1.x * v2.x + v1.y * v2.y + v1.z * v2.z;
+	}
+
+	template <typename T>
+	inline T Dot(const Normal3<T> &n1, const Vector3<T> &v2) {
+		return n1.x * v2.x + n1.y * v2.y + n1.z * v2.z;
+	}
+
+	template <typename T>
+	inline T Dot(const Vector3<T> &v1, const Normal3<T> &n2) {
+		return v1.x * n2.x + v1.y * n2.y + v1.z * n2.z;
+	}
+
+	template <typename T>
+	inline T Dot(const Normal3<T> &n1, const Normal3<T> &n2) {
+		return n1.x * n2.x + n1.y * n2.y + n1.z * n2.z;
+	}
+
+	template <typename T>
+	inline T AbsDot(const Vector3<T> &v1, const Vector3<T> &v2) {
+		return std::abs(Dot(v1, v2));
+	}
+
+	template <typename T>
+	inline Normal3<T> Normalize(const Normal3<T> &n) {
+		return n / n.Length();
+	}
+
+	// nvͬһ
+	template <typename T>
+	inline Normal3<T> Faceforward(const Normal3<T> &n, const Vector3<T> &v) {
+		return (Dot(n, v) < 0.f) ? -n : n;
+	}
+
+	template <typename T>
+	inline Normal3<T> Faceforward(const Normal3<T> &n, const Normal3<T> &n2) {
+		return (Dot(n, n2) < 0.f) ? -n : n;
+	}
+
+	template <typename T>
+	inline Vector3<T> Cross(const Vector3<T> &v1, const Normal3<T> &v2) {
+		return Cross(v1, Vector3<T>(v2.x, v2.y, v2.z));
+	}
+
+	template <typename T>
+	inline Vector3<T> Cross(const Normal3<T> &v1, const Vector3<T> &v2) {
+		return Cross(Vector3<T>(v1.x, v1.y, v1.z), v2);
+	}
+
+	template <typename T>
+	inline T MaxComponent(const Vector3<T> &v) {
+		return std::max(v.x, std::max(v.y, v.z));
+	}
+
+	// ֵķڵҪȡAbs
+	template <typename T>
+	inline int MaxDimension(const Vector3<T> &v) {
+		return (v.x > v.y) ? ((v.x > v.z) ? 0 : 2) : ((v.y > v.z) ? 1 : 2);
+	}
 
+	template <typename T>
+	inline Vector3<T> Permute(const Vector3<T> &v, int x, int y, int z) {
+		return Vector3<T>(v[x], v[y], v[z]);
+	}
 
+	template <typename T>
+	inline Point3<T> Permute(const Point3<T> &p, int x, int y, int z) {
+		return Point3<T>(p[x], p[y], p[z]);
+	}
 
+	// ɵλv1(v1, v2, v3)
+	template <typename T>
+	inline void CoordinateSystem(const Vector3<T> &v1, Vector3<T> *v2, Vector3<T> *v3) {
+		if (std::abs(v1.x) > std::abs(v1.y))
+			*v2 = Vector3<T>(-v1.z, 0, v1.x) / std::sqrt(v1.x * v1.x + v1.z * v1.z);
+		else
+			*v2 = Vector3<T>(0, v1.z, -v1.y) / std::sqrt(v1.y * v1.y + v1.z * v1.z);
+		*v3 = Cross(v1, *v2);
+	}
+
+	template <typename T>
+	inline Float Distance(const Point3<T> &p1, const Point3<T> &p2) {
+		return (p1 - p2).Length();
+	}
+
+	template <typename T>
+	inline Float DistanceSquared(const Point3<T> &p1, const Point3<T> &p2) {
+		return (p1 - p2).LengthSquared();
+	}
+
+}
@@ -0,0 +1,137 @@
+#include "imageio.h"
+#include "profile.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+
+namespace pbrt
+{
+	static bool HasExtension(const std::string &name, const char *ext)
+	{
+		size_t n = std::char_traits<char>::length(ext);
+		if (name.size() < n)
+			return false;
+		for (size_t i = 0; i < n; ++i)
+			if (std::tolower(name[name.size() - n + i]) != ext[i])
+				return false;
+		return true;
+	}
+
+	static inline Float GammaCorrect(Float value)
+	{
+		if (value <= 0.0031308f)
+			return 12.92f * value;
+		return 1.055f * std::pow(value, (Float)(1.f / 2.4f)) - 0.055f;
+	}
+
+	// 2GBļҲҪܶλ
+	static bool Seek(FILE *fp, int64_t offset)
+	{
+#if defined(_MSC_VER)
+		return _fseeki64(fp, offset, SEEK_SET) == 0;
+#else
+		return fseeko(fp, (off_t)offset, SEEK_SET) == 0;
+#endif
+	}
+
+	ImageWriter::~ImageWriter()
+	{
+		if (fp)
+			Close();
+	}
+
+	bool ImageWriter::Open(const std::string & filename, const Point2i & res)
+	{
+		DCHECK(!fp);
+		name = filename;
+		resolution = res;
+		if (HasExtension(name, ".pfm"))
+			format = Format::PFM;
+		else if (HasExtension(name, ".ppm"))
+			format = Format::PPM;
+		else
+		{
+			fprintf(stderr, "%s: unsupported image format (use .pfm or .ppm)\n", name.c_str());
+			return false;
+		}
+
+		fp = fopen(name.c_str(), "wb");
+		if (!fp)
+		{
+			fprintf(stderr, "%s: unable to open image for writing\n", name.c_str());
+			return false;
+		}
+		if (format == Format::PFM)
+		{
+			// ΪʾС
+			int one = 1;
+			bool littleEndian = *(unsigned char *)&one == 1;
+			ok = fprintf(fp, "PF\n%d %d\n%s\n", res.x, res.y, littleEndian ? "-1" : "1") > 0;
+		}
+		else
+			ok = fprintf(fp, "P6\n%d %d\n255\n", res.x, res.y) > 0;
+		headerBytes = ok ? (int64_t)ftell(fp) : 0;
+		return ok;
+	}
+
+	bool ImageWriter::WriteRows(int y0, int nRows, const Float * rgb)
+	{
+		DCHECK(fp && y0 >= 0 && y0 + nRows <= resolution.y);
+		ProfilePhase _(Prof::ImageWrite);
+		const int width = resolution.x;
+		if (format == Format::PFM)
+		{
+			// PFMɨߴϴţyļǵresolution.y - 1 - y
+			std::vector<float> scanline(3 * width);
+			for (int row = 0; ok && row < nRows; ++row)
+			{
+				int64_t fileRow = resolution.y - 1 - (y0 + row);
+				for (int i = 0; i < 3 * width; ++i)
+					scanline[i] = (float)rgb[3 * row * width + i];
+				ok = Seek(fp, headerBytes + fileRow * 3 * width * (int64_t)sizeof(float)) &&
+					fwrite(scanline.data(), sizeof(float), scanline.size(), fp) == scanline.size();
+			}
+		}
+		else
+		{
+			std::vector<unsigned char> scanline(3 * width);
+			ok = ok && Seek(fp, headerBytes + (int64_t)y0 * 3 * width);
+			for (int row = 0; ok && row < nRows; ++row)
+			{
+				for (int i = 0; i < 3 * width; ++i)
+				{
+					Float v = 255 * GammaCorrect(rgb[3 * row * width + i]) + 0.5f;
+					scanline[i] = (unsigned char)std::min(std::max(v, (Float)0), (Float)255);
+				}
+				ok = fwrite(scanline.data(), 1, scanline.size(), fp) == scanline.size();
+			}
+		}
+		if (!ok)
+			fprintf(stderr, "%s: unable to write image\n", name.c_str());
+		return ok;
+	}
+
+	bool ImageWriter::Close()
+	{
+		if (!fp)
+			return false;
+		bool closed = fclose(fp) == 0;
+		fp = nullptr;
+		if (ok && !closed)
+			fprintf(stderr, "%s: unable to write image\n", name.c_str());
+		return ok && closed;
+	}
+
+	bool WriteImage(const std::string & name, const Float * rgb, const Point2i & resolution)
+	{
+		ImageWriter writer;
+		if (!writer.Open(name, resolution))
+			return false;
+		writer.WriteRows(0, resolution.y, rgb);
+		return writer.Close();
+	}
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+#include "geometry.h"
+
+
+namespace pbrt
+{
+	// չдͼ.pfmԵĸֵ.ppmsRGB٤УΪ8λ
+	// rgbΪresolution.x * resolution.yصRGBдϵ´šʧʱfalseϢ
+	bool WriteImage(const std::string &name, const Float *rgb, const Point2i &resolution);
+
+
+	// ֶдͼOpenٰ˳дУClose
+	// ļСOpenʱȷˣÿֱӶλԼλãڴﲻҪͼ
+	// ʽWriteImageͬûдĲݲȷ
+	class ImageWriter
+	{
+	public:
+		ImageWriter() {}
+		~ImageWriter();
+		ImageWriter(const ImageWriter &) = delete;
+		ImageWriter &operator=(const ImageWriter &) = delete;
+
+		bool Open(const std::string &name, const Point2i &resolution);
+		// rgbΪy0пʼnRowsУдϵ´
+		bool WriteRows(int y0, int nRows, const Float *rgb);
+		bool Close();
+
+		const Point2i &Resolution() const { return resolution; }
+
+	private:
+		enum class Format { PFM, PPM };
+
+		std::string name;
+		Format format = Format::PFM;
+		Point2i resolution;
+		FILE *fp = nullptr;
+		int64_t headerBytes = 0;
+		bool ok = false;   // Ժд
+	};
+}
@@ -1,9 +1,12 @@
 #include "interaction.h"
 #include "Shape.h"
+#include "stats.h"
 
 
 namespace pbrt
 {
+	STAT_COUNTER("Intersections/SurfaceInteractions constructed", nSurfaceInteractions);
+
 	SurfaceInteraction::SurfaceInteraction(const Point3f & p, const Vector3f & pError, const Point2f & uv, const Vector3f & wo, const Vector3f & dpdu, const Vector3f & dpdv, const Normal3f & dndu, const Normal3f & dndv, Float time, const Shape * sh, int faceIndex)
 		:Interaction(p, Normal3f(Normalize(Cross(dpdu, dpdv))),pError,wo,time),
 		uv(uv),
@@ -11,9 +14,11 @@ namespace pbrt
 		dpdv(dpdv),
 		dndu(dndu),
 		dndv(dndv),
-		shape(shape),
+		shape(sh),
 		faceIndex(faceIndex)
 	{
+		++nSurfaceInteractions;
+
 		// Initialize shading geometry from true geometry
 		shading.n = n;
 		shading.dpdu = dpdu;
@@ -29,6 +34,22 @@ namespace pbrt
 		}
 
 	}
+
+	void SurfaceInteraction::SetShadingGeometry(const Vector3f & dpdus, const Vector3f & dpdvs, const Normal3f & dndus, const Normal3f & dndvs, bool orientationIsAuthoritative)
+	{
+		shading.n = Normal3f(Normalize(Cross(dpdus, dpdvs)));
+		if (shape && (shape->reverseOrientation ^ shape->transformSwapsHandedness))
+			shading.n = -shading.n;
+		if (orientationIsAuthoritative)
+			n = Faceforward(n, shading.n);
+		else
+			shading.n = Faceforward(shading.n, n);
+
+		shading.dpdu = dpdus;
+		shading.dpdv = dpdvs;
+		shading.dndu = dndus;
+		shading.dndv = dndvs;
+	}
 }
 
 
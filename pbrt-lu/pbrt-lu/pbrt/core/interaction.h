@@ -1,5 +1,7 @@
 #pragma once
 
+#include <type_traits>
+
 #include "geometry.h"
 #include "medium.h"
 
@@ -45,6 +47,8 @@ namespace pbrt
 	};
 
 	class Shape;
+	class Primitive;
+	class Transform;
 
 	class SurfaceInteraction : public Interaction 
 	{
@@ -54,6 +58,7 @@ namespace pbrt
 		Vector3f dpdu, dpdv;
 		Normal3f dndu, dndv;
 		const Shape *shape = nullptr;
+		const Primitive *primitive = nullptr;
 
 		struct {
 			Normal3f n;
@@ -72,6 +77,28 @@ namespace pbrt
 			const Normal3f &dndu, const Normal3f &dndv, Float time,
 			const Shape *sh,
 			int faceIndex = 0);
+
+		// ɫΣֵߡͼȣ
+		// orientationIsAuthoritativeΪtrueʱηnɫͬһ࣬򷴹
+		void SetShadingGeometry(const Vector3f &dpdus, const Vector3f &dpdvs,
+			const Normal3f &dndus, const Normal3f &dndvs, bool orientationIsAuthoritative);
+	};
+
+	// ʱֻ¼СϢкѡ㲻ϱ滻
+	// SurfaceInteractionֻڱΪĽ㹹һΣPrimitive::ComputeSurfaceInteraction
+	struct SurfaceHit
+	{
+		Float tHit = std::numeric_limits<Float>::infinity();
+		const Primitive *primitive = nullptr;
+		int primIndex = 0;   // ״ڲıţ״Ӳλαŵȣ
+		Point2f uv;          // ꣬״
+		// ʵʱΪʵı任primitivetHitʵռ䣻ʵʱΪnullptr
+		const Transform *instanceToWorld = nullptr;
+		const Transform *worldToInstance = nullptr;
 	};
 
+	// Ϣͨÿ̵߳MemoryArenaϣARENA_ALLOCResetʱ
+	static_assert(std::is_trivially_destructible<SurfaceInteraction>::value,
+		"SurfaceInteraction is allocated from MemoryArena and must not need a destructor");
+
 }
@@ -0,0 +1,102 @@
+#include "lowdiscrepancy.h"
+
+
+namespace pbrt
+{
+	const int Primes[PrimeTableSize] = {
+		2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47, 53,
+		59, 61, 67, 71, 73, 79, 83, 89, 97, 101, 103, 107, 109, 113, 127, 131,
+		137, 139, 149, 151, 157, 163, 167, 173, 179, 181, 191, 193, 197, 199, 211, 223,
+		227, 229, 233, 239, 241, 251, 257, 263, 269, 271, 277, 281, 283, 293, 307, 311,
+		313, 317, 331, 337, 347, 349, 353, 359, 367, 373, 379, 383, 389, 397, 401, 409,
+		419, 421, 431, 433, 439, 443, 449, 457, 461, 463, 467, 479, 487, 491, 499, 503,
+		509, 521, 523, 541, 547, 557, 563, 569, 571, 577, 587, 593, 599, 601, 607, 613,
+		617, 619, 631, 641, 643, 647, 653, 659, 661, 673, 677, 683, 691, 701, 709, 719,
+	};
+
+	const int PrimeSums[PrimeTableSize] = {
+		0, 2, 5, 10, 17, 28, 41, 58, 77, 100, 129, 160, 197, 238, 281, 328,
+		381, 440, 501, 568, 639, 712, 791, 874, 963, 1060, 1161, 1264, 1371, 1480, 1593, 1720,
+		1851, 1988, 2127, 2276, 2427, 2584, 2747, 2914, 3087, 3266, 3447, 3638, 3831, 4028, 4227, 4438,
+		4661, 4888, 5117, 5350, 5589, 5830, 6081, 6338, 6601, 6870, 7141, 7418, 7699, 7982, 8275, 8582,
+		8893, 9206, 9523, 9854, 10191, 10538, 10887, 11240, 11599, 11966, 12339, 12718, 13101, 13490, 13887, 14288,
+		14697, 15116, 15537, 15968, 16401, 16840, 17283, 17732, 18189, 18650, 19113, 19580, 20059, 20546, 21037, 21536,
+		22039, 22548, 23069, 23592, 24133, 24680, 25237, 25800, 26369, 26940, 27517, 28104, 28697, 29296, 29897, 30504,
+		31117, 31734, 32353, 32984, 33625, 34268, 34915, 35568, 36227, 36888, 37561, 38238, 38921, 39612, 40313, 41022,
+	};
+
+	static inline Float RadicalInverseGeneric(uint64_t base, uint64_t a)
+	{
+		const Float invBase = (Float)1 / (Float)base;
+		uint64_t reversedDigits = 0;
+		Float invBaseN = 1;
+		while (a)
+		{
+			uint64_t next = a / base;
+			uint64_t digit = a - next * base;
+			reversedDigits = reversedDigits * base + digit;
+			invBaseN *= invBase;
+			a = next;
+		}
+		return std::min(reversedDigits * invBaseN, OneMinusEpsilon);
+	}
+
+	// ΪڳʱԱɳ˷õļ׵ʵ
+	template <int base>
+	static Float RadicalInverseSpecialized(uint64_t a)
+	{
+		return RadicalInverseGeneric(base, a);
+	}
+
+	Float RadicalInverse(int baseIndex, uint64_t a)
+	{
+		DCHECK(baseIndex >= 0 && baseIndex < PrimeTableSize);
+		switch (baseIndex)
+		{
+		case 0:
+			// Ϊ2ʱǰλ2^-64
+			return std::min((Float)(ReverseBits64(a) * 5.4210108624275222e-20), OneMinusEpsilon);
+		case 1:
+			return RadicalInverseSpecialized<3>(a);
+		case 2:
+			return RadicalInverseSpecialized<5>(a);
+		case 3:
+			return RadicalInverseSpecialized<7>(a);
+		default:
+			return RadicalInverseGeneric(Primes[baseIndex], a);
+		}
+	}
+
+	Float ScrambledRadicalInverse(int baseIndex, uint64_t a, const uint16_t * perm)
+	{
+		DCHECK(baseIndex >= 0 && baseIndex < PrimeTableSize);
+		const uint64_t base = Primes[baseIndex];
+		const Float invBase = (Float)1 / (Float)base;
+		uint64_t reversedDigits = 0;
+		Float invBaseN = 1;
+		while (a)
+		{
+			uint64_t next = a / base;
+			uint64_t digit = a - next * base;
+			reversedDigits = reversedDigits * base + perm[digit];
+			invBaseN *= invBase;
+			a = next;
+		}
+		return std::min(invBaseN * (reversedDigits + invBase * perm[0] / (1 - invBase)), OneMinusEpsilon);
+	}
+
+	std::vector<uint16_t> ComputeRadicalInversePermutations(RNG & rng)
+	{
+		std::vector<uint16_t> perms(PrimeSums[PrimeTableSize - 1] + Primes[PrimeTableSize - 1]);
+		for (int i = 0; i < PrimeTableSize; ++i)
+		{
+			uint16_t *p = &perms[PrimeSums[i]];
+			for (int j = 0; j < Primes[i]; ++j)
+				p[j] = (uint16_t)j;
+			// Fisher-Yatesϴ
+			for (int j = Primes[i] - 1; j > 0; --j)
+				std::swap(p[j], p[rng.UniformUInt32((uint32_t)j + 1)]);
+		}
+		return perms;
+	}
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "rng.h"
+#include "sobolmatrices.h"
+
+
+// ͲеĻ㣺ʽݣHaltonɾ˷SobolԼǵҡ
+namespace pbrt
+{
+	static const int PrimeTableSize = 128;
+	extern const int Primes[PrimeTableSize];
+	// PrimeSums[i]Ϊǰi֮ͣiûûʼλ
+	extern const int PrimeSums[PrimeTableSize];
+
+	inline uint32_t ReverseBits32(uint32_t n)
+	{
+		n = (n << 16) | (n >> 16);
+		n = ((n & 0x00ff00ff) << 8) | ((n & 0xff00ff00) >> 8);
+		n = ((n & 0x0f0f0f0f) << 4) | ((n & 0xf0f0f0f0) >> 4);
+		n = ((n & 0x33333333) << 2) | ((n & 0xcccccccc) >> 2);
+		n = ((n & 0x55555555) << 1) | ((n & 0xaaaaaaaa) >> 1);
+		return n;
+	}
+
+	inline uint64_t ReverseBits64(uint64_t n)
+	{
+		uint64_t n0 = ReverseBits32((uint32_t)n);
+		uint64_t n1 = ReverseBits32((uint32_t)(n >> 32));
+		return (n0 << 32) | n1;
+	}
+
+	// ԵbaseIndexbΪ׵ĸʽݣa = d_0 + d_1 b + d_2 b^2 + ... ӳΪ 0.d_0 d_1 d_2 ...
+	Float RadicalInverse(int baseIndex, uint64_t a);
+
+	// ȾpermûٷݡpermΪbû0ҲλҪperm[0] / (b - 1)β
+	Float ScrambledRadicalInverse(int baseIndex, uint64_t a, const uint16_t *perm);
+
+	// RadicalInverse棺inverseΪݺСnDigitsλɵԭa
+	template <int base>
+	inline uint64_t InverseRadicalInverse(uint64_t inverse, int nDigits)
+	{
+		uint64_t index = 0;
+		for (int i = 0; i < nDigits; ++i)
+		{
+			uint64_t digit = inverse % base;
+			inverse /= base;
+			index = index * base + digit;
+		}
+		return index;
+	}
+
+	// ÿһûPrimeSumsδ
+	std::vector<uint16_t> ComputeRadicalInversePermutations(RNG &rng);
+
+	// ɾCaĸλGF(2)ϵľ˷
+	inline uint32_t MultiplyGenerator(const uint32_t *C, uint32_t a)
+	{
+		uint32_t v = 0;
+		for (int i = 0; a != 0; ++i, a >>= 1)
+			if (a & 1)
+				v ^= C[i];
+		return v;
+	}
+
+	// Sobolеaĵdimensionά32λ
+	inline uint32_t SobolSampleBits(uint32_t a, int dimension)
+	{
+		DCHECK(dimension < NumSobolDimensions);
+		return MultiplyGenerator(&SobolMatrices32[dimension * SobolMatrixSize], a);
+	}
+
+	// OwenңǶ׾ûĹϣƣLaineKarras 2011Burley 2020
+	// תÿһλֻܸλԭλӰ죬ԱSobolеķֲ㡣
+	inline uint32_t OwenScramble(uint32_t v, uint32_t seed)
+	{
+		v = ReverseBits32(v);
+		v ^= v * 0x3d20adea;
+		v += seed;
+		v *= (seed >> 16) | 1;
+		v ^= v * 0x05526c56;
+		v ^= v * 0x53a22864;
+		return ReverseBits32(v);
+	}
+
+	// 32λתΪ[0, 1)ϵFloatֻø24λһС1SIMD汾зתõͬĽ
+	inline Float FixedToUnitFloat(uint32_t v)
+	{
+		return (Float)(v >> 8) * (1.f / 16777216.f);
+	}
+}
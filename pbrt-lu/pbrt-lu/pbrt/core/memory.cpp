@@ -0,0 +1,106 @@
+#include "memory.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#ifdef _MSC_VER
+#include <malloc.h>
+#endif
+
+
+namespace pbrt
+{
+	void *AllocAligned(size_t size)
+	{
+#if defined(_MSC_VER)
+		return _aligned_malloc(size, PBRT_L1_CACHE_LINE_SIZE);
+#else
+		void *ptr;
+		if (posix_memalign(&ptr, PBRT_L1_CACHE_LINE_SIZE, size) != 0)
+			ptr = nullptr;
+		return ptr;
+#endif
+	}
+
+	void FreeAligned(void *ptr)
+	{
+		if (!ptr) return;
+#if defined(_MSC_VER)
+		_aligned_free(ptr);
+#else
+		free(ptr);
+#endif
+	}
+
+
+	MemoryArena::~MemoryArena()
+	{
+		FreeAligned(currentBlock);
+		for (auto &block : usedBlocks) FreeAligned(block.second);
+		for (auto &block : availableBlocks) FreeAligned(block.second);
+	}
+
+	void * MemoryArena::Alloc(size_t nBytes, size_t align)
+	{
+		DCHECK(align > 0 && (align & (align - 1)) == 0 && align <= PBRT_L1_CACHE_LINE_SIZE);
+		size_t start = (currentBlockPos + align - 1) & ~(align - 1);
+		if (start + nBytes > currentAllocSize)
+		{
+			// ǰŲ£ŽusedBlocksһ㹻Ŀп飬ûо
+			if (currentBlock)
+			{
+				usedBlocks.push_back(std::make_pair(currentAllocSize, currentBlock));
+				bytesInUsedBlocks += currentBlockPos;
+				currentBlock = nullptr;
+				currentAllocSize = 0;
+			}
+
+			for (auto iter = availableBlocks.begin(); iter != availableBlocks.end(); ++iter)
+			{
+				if (iter->first >= nBytes)
+				{
+					currentAllocSize = iter->first;
+					currentBlock = iter->second;
+					availableBlocks.erase(iter);
+					break;
+				}
+			}
+			if (!currentBlock)
+			{
+				currentAllocSize = std::max(nBytes, blockSize);
+				currentBlock = AllocAligned<uint8_t>(currentAllocSize);
+			}
+			// ¿㰴ж
+			start = 0;
+		}
+		void *ret = currentBlock + start;
+		currentBlockPos = start + nBytes;
+		return ret;
+	}
+
+	void MemoryArena::Reset()
+	{
+		currentBlockPos = 0;
+		bytesInUsedBlocks = 0;
+		availableBlocks.splice(availableBlocks.begin(), usedBlocks);
+	}
+
+	size_t MemoryArena::BytesInUse() const
+	{
+		return bytesInUsedBlocks + currentBlockPos;
+	}
+
+	size_t MemoryArena::TotalAllocated() const
+	{
+		size_t total = currentAllocSize;
+		for (const auto &alloc : usedBlocks) total += alloc.first;
+		for (const auto &alloc : availableBlocks) total += alloc.first;
+		return total;
+	}
+
+	MemoryArena & ThreadArena()
+	{
+		static thread_local MemoryArena arena;
+		return arena;
+	}
+}
@@ -0,0 +1,147 @@
+#pragma once
+
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include "../pbrt.h"
+
+
+namespace pbrt
+{
+#ifndef PBRT_L1_CACHE_LINE_SIZE
+#define PBRT_L1_CACHE_LINE_SIZE 64
+#endif
+
+	// ж
+	void *AllocAligned(size_t size);
+
+	template <typename T>
+	T *AllocAligned(size_t count)
+	{
+		return (T *)AllocAligned(count * sizeof(T));
+	}
+
+	void FreeAligned(void *);
+
+	// жstd::allocatorƷC++14std::allocatoralignas
+	// 16ֽڶͣBVHڵ㡢飩ŽvectorʱҪSIMDдܳ
+	template <typename T>
+	class AlignedAllocator
+	{
+	public:
+		typedef T value_type;
+		static_assert(alignof(T) <= PBRT_L1_CACHE_LINE_SIZE, "T needs more than cache line alignment");
+
+		AlignedAllocator() {}
+		template <typename U>
+		AlignedAllocator(const AlignedAllocator<U> &) {}
+
+		T *allocate(size_t n)
+		{
+			T *ptr = AllocAligned<T>(n);
+			if (!ptr && n > 0)
+				throw std::bad_alloc();
+			return ptr;
+		}
+		void deallocate(T *ptr, size_t) { FreeAligned(ptr); }
+
+		template <typename U>
+		bool operator==(const AlignedAllocator<U> &) const { return true; }
+		template <typename U>
+		bool operator!=(const AlignedAllocator<U> &) const { return false; }
+	};
+
+	template <typename T>
+	using AlignedVector = std::vector<T, AlignedAllocator<T>>;
+
+	// arenaϹARENA_ALLOC(arena, SurfaceInteraction)(...)
+#define ARENA_ALLOC(arena, Type) new ((arena).Alloc(sizeof(Type), alignof(Type))) Type
+
+
+	// Ӷڴ棬ֻƶָ䣨bump allocationֵ֧ͷţֻReset
+	// ʺϴͬС󡣲̰߳ȫģ߳ʱÿ߳ԼarenaThreadArena()
+	class alignas(PBRT_L1_CACHE_LINE_SIZE) MemoryArena
+	{
+	public:
+		MemoryArena(size_t blockSize = 262144) : blockSize(blockSize) {}
+
+		~MemoryArena();
+
+		MemoryArena(const MemoryArena &) = delete;
+		MemoryArena &operator=(const MemoryArena &) = delete;
+
+		// align2ݣҲдС鱾ж룩
+		void *Alloc(size_t nBytes, size_t align = 16);
+
+		template <typename T>
+		T *Alloc(size_t n = 1, bool runConstructor = true)
+		{
+			T *ret = (T *)Alloc(n * sizeof(T), alignof(T) > 16 ? alignof(T) : 16);
+			if (runConstructor)
+				for (size_t i = 0; i < n; ++i)
+					new (&ret[i]) T();
+			return ret;
+		}
+
+		// п´θã֮ǰȥָȫʧЧ
+		void Reset();
+
+		// Ӷֽ
+		size_t TotalAllocated() const;
+
+		// ϴReset֮ȥֽĿ϶
+		size_t BytesInUse() const;
+
+	private:
+		const size_t blockSize;
+		size_t currentBlockPos = 0, currentAllocSize = 0;
+		size_t bytesInUsedBlocks = 0;
+		uint8_t *currentBlock = nullptr;
+		std::list<std::pair<size_t, uint8_t *>> usedBlocks, availableBlocks;
+	};
+
+
+	// Ժֻ顣ݻԼvectorⲿڴmmapĳ棩
+	// storage֤ⲿڴڡ÷һӻصļٽṹøݡ
+	template <typename T>
+	class ReadOnlyArray
+	{
+	public:
+		ReadOnlyArray() {}
+		explicit ReadOnlyArray(AlignedVector<T> v) : owned(std::move(v)), ptr(owned.data()), count(owned.size()) {}
+		ReadOnlyArray(const T *data, size_t count, std::shared_ptr<const void> storage)
+			: ptr(data), count(count), storage(std::move(storage))
+		{
+		}
+		// ƶvectorıĻptrȻЧptrָ˵
+		ReadOnlyArray(ReadOnlyArray &&) = default;
+		ReadOnlyArray &operator=(ReadOnlyArray &&) = default;
+		ReadOnlyArray(const ReadOnlyArray &) = delete;
+		ReadOnlyArray &operator=(const ReadOnlyArray &) = delete;
+
+		const T &operator[](size_t i) const { return ptr[i]; }
+		const T *data() const { return ptr; }
+		size_t size() const { return count; }
+		bool empty() const { return count == 0; }
+		const T *begin() const { return ptr; }
+		const T *end() const { return ptr + count; }
+		size_t BytesUsed() const { return count * sizeof(T); }
+
+	private:
+		AlignedVector<T> owned;
+		const T *ptr = nullptr;
+		size_t count = 0;
+		std::shared_ptr<const void> storage;
+	};
+
+
+	// ǰ߳Լarenaһεʱ߳̽ʱͷš
+	// ȾѭÿReset()֮ķ䶼еĿ飬ٷʶѡ
+	MemoryArena &ThreadArena();
+}
@@ -0,0 +1,255 @@
+#include "parallel.h"
+#include "stats.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace pbrt
+{
+	// һ̴߳䡣ӵߴbeginȡ͵ȡߴendǰһ
+	struct WorkRange
+	{
+		std::mutex mutex;
+		int64_t begin = 0, end = 0;
+		char pad[64];
+	};
+
+	// һParallelFor̹߳״̬
+	struct ParallelJob
+	{
+		const std::function<void(int64_t, int64_t)> *func;
+		int chunkSize;
+		int nThreads;
+		bool allowStealing = true;
+		std::unique_ptr<WorkRange[]> ranges;
+		int workersRunning;   // poolMutex
+
+		bool TakeOwn(int index, int64_t *b, int64_t *e)
+		{
+			WorkRange &r = ranges[index];
+			std::lock_guard<std::mutex> lock(r.mutex);
+			if (r.begin >= r.end)
+				return false;
+			*b = r.begin;
+			*e = std::min(r.begin + chunkSize, r.end);
+			r.begin = *e;
+			return true;
+		}
+
+		// ̵߳ĩβ͵һ룬ŽԼ
+		bool Steal(int index)
+		{
+			for (int k = 1; k < nThreads; ++k)
+			{
+				WorkRange &victim = ranges[(index + k) % nThreads];
+				int64_t b, e;
+				{
+					std::lock_guard<std::mutex> lock(victim.mutex);
+					int64_t remaining = victim.end - victim.begin;
+					if (remaining <= 0)
+						continue;
+					int64_t n = std::max(remaining / 2, std::min((int64_t)chunkSize, remaining));
+					b = victim.end - n;
+					e = victim.end;
+					victim.end = b;
+				}
+				WorkRange &own = ranges[index];
+				std::lock_guard<std::mutex> lock(own.mutex);
+				own.begin = b;
+				own.end = e;
+				return true;
+			}
+			return false;
+		}
+
+		void Run(int index)
+		{
+			int64_t b, e;
+			do
+			{
+				while (TakeOwn(index, &b, &e))
+					(*func)(b, e);
+			} while (allowStealing && Steal(index));
+		}
+	};
+
+
+	static std::vector<std::thread> threads;
+	static std::mutex poolMutex;
+	static std::condition_variable workCondition, doneCondition;
+	static ParallelJob *currentJob = nullptr;
+	static uint64_t jobGeneration = 0;
+	static bool shutdownThreads = false;
+	static thread_local int threadIndex = 0;
+	static thread_local bool inParallelFor = false;
+
+	// seenΪ߳ʱţֻӦ֮
+	static void WorkerThreadFunc(int index, uint64_t seen)
+	{
+		threadIndex = index;
+		inParallelFor = true;
+		std::unique_lock<std::mutex> lock(poolMutex);
+		while (true)
+		{
+			workCondition.wait(lock, [&] { return shutdownThreads || jobGeneration != seen; });
+			if (shutdownThreads)
+			{
+				lock.unlock();
+				ReportThreadStats();
+				return;
+			}
+			seen = jobGeneration;
+			ParallelJob *job = currentJob;
+			lock.unlock();
+			job->Run(index);
+			lock.lock();
+			if (--job->workersRunning == 0)
+				doneCondition.notify_one();
+		}
+	}
+
+	void ParallelInit(int nThreads)
+	{
+		ParallelCleanup();
+		if (nThreads <= 0)
+			nThreads = NumSystemCores();
+		shutdownThreads = false;
+		for (int i = 1; i < nThreads; ++i)
+			threads.push_back(std::thread(WorkerThreadFunc, i, jobGeneration));
+	}
+
+	void ParallelCleanup()
+	{
+		if (threads.empty())
+			return;
+		{
+			std::lock_guard<std::mutex> lock(poolMutex);
+			shutdownThreads = true;
+		}
+		workCondition.notify_all();
+		for (std::thread &t : threads)
+			t.join();
+		threads.clear();
+		shutdownThreads = false;
+	}
+
+	int NumSystemCores()
+	{
+		return std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	int MaxThreadIndex()
+	{
+		return (int)threads.size() + 1;
+	}
+
+	int ThreadIndex()
+	{
+		return threadIndex;
+	}
+
+	// йִ߳job߳Ϊ0̲߳룬ȫɺ󷵻
+	static void RunJob(ParallelJob &job)
+	{
+		job.workersRunning = job.nThreads - 1;
+		{
+			std::lock_guard<std::mutex> lock(poolMutex);
+			currentJob = &job;
+			++jobGeneration;
+		}
+		workCondition.notify_all();
+
+		inParallelFor = true;
+		job.Run(0);
+		inParallelFor = false;
+
+		// jobջϣ̶߳뿪ܷ
+		std::unique_lock<std::mutex> lock(poolMutex);
+		doneCondition.wait(lock, [&] { return job.workersRunning == 0; });
+		currentJob = nullptr;
+	}
+
+	void ParallelForRange(const std::function<void(int64_t, int64_t)> &func, int64_t count, int chunkSize)
+	{
+		if (count <= 0)
+			return;
+		chunkSize = std::max(1, chunkSize);
+		int nThreads = MaxThreadIndex();
+		if (nThreads == 1 || count <= chunkSize || inParallelFor)
+		{
+			for (int64_t b = 0; b < count; b += chunkSize)
+				func(b, std::min(b + chunkSize, count));
+			return;
+		}
+
+		// ߳
+		ParallelJob job;
+		job.func = &func;
+		job.chunkSize = chunkSize;
+		job.nThreads = nThreads;
+		job.ranges.reset(new WorkRange[nThreads]);
+		for (int i = 0; i < nThreads; ++i)
+		{
+			job.ranges[i].begin = count * i / nThreads;
+			job.ranges[i].end = count * (i + 1) / nThreads;
+		}
+		RunJob(job);
+	}
+
+	void ParallelFor(const std::function<void(int64_t)> &func, int64_t count, int chunkSize)
+	{
+		ParallelForRange([&func](int64_t b, int64_t e) {
+			for (int64_t i = b; i < e; ++i)
+				func(i);
+		}, count, chunkSize);
+	}
+
+	void ParallelFor2D(const std::function<void(Bounds2i)> &func, const Bounds2i &bounds, int tileSize)
+	{
+		int width = bounds.pMax.x - bounds.pMin.x, height = bounds.pMax.y - bounds.pMin.y;
+		if (width <= 0 || height <= 0)
+			return;
+		tileSize = std::max(1, tileSize);
+		int nx = (width + tileSize - 1) / tileSize, ny = (height + tileSize - 1) / tileSize;
+		ParallelFor([&](int64_t tile) {
+			int tx = (int)(tile % nx), ty = (int)(tile / nx);
+			Bounds2i tileBounds;
+			tileBounds.pMin = Point2i(bounds.pMin.x + tx * tileSize, bounds.pMin.y + ty * tileSize);
+			tileBounds.pMax = Point2i(std::min(tileBounds.pMin.x + tileSize, bounds.pMax.x),
+				std::min(tileBounds.pMin.y + tileSize, bounds.pMax.y));
+			func(tileBounds);
+		}, (int64_t)nx * ny, 1);
+	}
+
+	void MergeWorkerThreadStats()
+	{
+		DCHECK(!inParallelFor);
+		ReportThreadStats();
+		int nThreads = MaxThreadIndex();
+		if (nThreads == 1)
+			return;
+
+		// ÿֵֻ߳Լŵһ͵ȡ֤ÿ̶߳ϱһ
+		std::function<void(int64_t, int64_t)> report = [](int64_t, int64_t) {
+			if (ThreadIndex() != 0)
+				ReportThreadStats();
+		};
+		ParallelJob job;
+		job.func = &report;
+		job.chunkSize = 1;
+		job.nThreads = nThreads;
+		job.allowStealing = false;
+		job.ranges.reset(new WorkRange[nThreads]);
+		for (int i = 0; i < nThreads; ++i)
+		{
+			job.ranges[i].begin = i;
+			job.ranges[i].end = i + 1;
+		}
+		RunJob(job);
+	}
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+
+#include "geometry.h"
+
+
+namespace pbrt
+{
+	// ̳߳ءnThreadsΪ0ʱӲ̱߳߳Ҳ㣬0̡߳
+	// ûеParallelInitʱParallelForڵ߳ϴִСͬһʱֻһ̷߳ParallelFor
+	void ParallelInit(int nThreads = 0);
+	void ParallelCleanup();
+
+	int NumSystemCores();
+	// ̣̱߳߳߳Ϊ[0, MaxThreadIndex())
+	int MaxThreadIndex();
+	// ǰ̵߳ıţ̶̺̳߳߳߳0
+	int ThreadIndex();
+
+	// [0, count)ָ̣߳ÿȡchunkSize
+	// ʼʱÿ̷ֵ߳һ䣬ǰȡԼӱ߳ĩβ͵һ루work stealing
+	// Ƕ׵ãParallelForĺٵParallelForʱڵǰ߳ϴִС
+	void ParallelFor(const std::function<void(int64_t)> &func, int64_t count, int chunkSize = 1);
+	// [begin, end)Ϊλãʡȥstd::functionĿ
+	void ParallelForRange(const std::function<void(int64_t, int64_t)> &func, int64_t count, int chunkSize = 1);
+
+	// boundsгtileSize x tileSizeĿ飨ϵĿܸСÿһfunc
+	// 鰴ȱţڵĿͬһ̴߳
+	void ParallelFor2D(const std::function<void(Bounds2i)> &func, const Bounds2i &bounds, int tileSize = 16);
+
+	// ỵ̈߳͵̣߳ԼͳReportThreadStatsϲstats.h
+	// ParallelForá߳˳ParallelCleanupʱҲԶϱ
+	void MergeWorkerThreadStats();
+
+
+	// ԭۼӵĸñȽϽʵ֡߳ͬһۼӣϲͼ顢splatʱ
+	class AtomicFloat
+	{
+	public:
+		explicit AtomicFloat(Float v = 0) { bits = FloatToBits(v); }
+		operator Float() const { return BitsToFloat(bits.load(std::memory_order_relaxed)); }
+		Float operator=(Float v)
+		{
+			bits.store(FloatToBits(v), std::memory_order_relaxed);
+			return v;
+		}
+		void Add(Float v)
+		{
+			uint32_t oldBits = bits.load(std::memory_order_relaxed), newBits;
+			do
+			{
+				newBits = FloatToBits(BitsToFloat(oldBits) + v);
+			} while (!bits.compare_exchange_weak(oldBits, newBits, std::memory_order_relaxed));
+		}
+
+	private:
+		static uint32_t FloatToBits(float f)
+		{
+			uint32_t ui;
+			memcpy(&ui, &f, sizeof(float));
+			return ui;
+		}
+		static float BitsToFloat(uint32_t ui)
+		{
+			float f;
+			memcpy(&f, &ui, sizeof(uint32_t));
+			return f;
+		}
+
+		std::atomic<uint32_t> bits;
+	};
+	static_assert(sizeof(Float) == sizeof(float), "AtomicFloat stores 32-bit floats");
+
+
+	// ÿ߳һݵʱݣ״̬ȣThreadIndex()ȡԼһݣ
+	// ֮ٸһУαParallelInit֮󴴽
+	template <typename T>
+	class PerThread
+	{
+	public:
+		PerThread() : n(MaxThreadIndex()), slots(new Slot[n]) {}
+		explicit PerThread(const T &init) : PerThread()
+		{
+			for (int i = 0; i < n; ++i)
+				slots[i].value = init;
+		}
+
+		T &Get() { DCHECK(ThreadIndex() < n); return slots[ThreadIndex()].value; }
+		T &operator[](int i) { DCHECK(i >= 0 && i < n); return slots[i].value; }
+		const T &operator[](int i) const { DCHECK(i >= 0 && i < n); return slots[i].value; }
+		int Size() const { return n; }
+
+		// ڲѭϲ̵߳Ľ
+		template <typename F>
+		void ForEach(F f) const
+		{
+			for (int i = 0; i < n; ++i)
+				f(slots[i].value);
+		}
+
+	private:
+		struct Slot
+		{
+			T value;
+			char pad[64];
+		};
+
+		int n;
+		std::unique_ptr<Slot[]> slots;
+	};
+}
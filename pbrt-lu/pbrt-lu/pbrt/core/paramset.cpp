@@ -0,0 +1,128 @@
+#include "paramset.h"
+
+#include <type_traits>
+
+
+namespace pbrt
+{
+	// Get*ArrayFloatֱӵɵͷߵ鷵
+	static_assert(sizeof(Point2f) == 2 * sizeof(Float) && sizeof(Point3f) == 3 * sizeof(Float) &&
+		sizeof(Normal3f) == 3 * sizeof(Float), "tuple types must be tightly packed Floats");
+	static_assert(std::is_standard_layout<Point3f>::value && std::is_standard_layout<Normal3f>::value,
+		"tuple types must be standard layout");
+
+	ParamStorage ParamStorageForType(const std::string & type)
+	{
+		static const char *floatTypes[] = { "float", "point", "point2", "point3", "vector", "vector2",
+			"vector3", "normal", "normal3", "color", "rgb", "blackbody" };
+		for (const char *t : floatTypes)
+			if (type == t)
+				return ParamStorage::Float;
+		if (type == "integer")
+			return ParamStorage::Int;
+		if (type == "string" || type == "texture" || type == "spectrum")
+			return ParamStorage::String;
+		if (type == "bool")
+			return ParamStorage::Bool;
+		return ParamStorage::Unknown;
+	}
+
+	void ParamSet::Add(ParamItem && item)
+	{
+		// ֵͬĸǰ
+		for (ParamItem &existing : items)
+		{
+			if (existing.name == item.name)
+			{
+				existing = std::move(item);
+				return;
+			}
+		}
+		items.push_back(std::move(item));
+	}
+
+	const ParamItem * ParamSet::Find(const std::string & name, ParamStorage storage) const
+	{
+		for (const ParamItem &item : items)
+		{
+			if (item.name == name && ParamStorageForType(item.type) == storage)
+			{
+				item.lookedUp = true;
+				return &item;
+			}
+		}
+		return nullptr;
+	}
+
+	Float ParamSet::GetOneFloat(const std::string & name, Float def) const
+	{
+		const ParamItem *item = Find(name, ParamStorage::Float);
+		return (item && item->floats.size() == 1) ? item->floats[0] : def;
+	}
+
+	int ParamSet::GetOneInt(const std::string & name, int def) const
+	{
+		const ParamItem *item = Find(name, ParamStorage::Int);
+		return (item && item->ints.size() == 1) ? item->ints[0] : def;
+	}
+
+	bool ParamSet::GetOneBool(const std::string & name, bool def) const
+	{
+		const ParamItem *item = Find(name, ParamStorage::Bool);
+		return (item && item->bools.size() == 1) ? item->bools[0] != 0 : def;
+	}
+
+	std::string ParamSet::GetOneString(const std::string & name, const std::string & def) const
+	{
+		const ParamItem *item = Find(name, ParamStorage::String);
+		return (item && item->strings.size() == 1) ? item->strings[0] : def;
+	}
+
+	const Float * ParamSet::GetFloatArray(const std::string & name, size_t * n) const
+	{
+		return GetTupleArray(name, 1, n);
+	}
+
+	const int * ParamSet::GetIntArray(const std::string & name, size_t * n) const
+	{
+		const ParamItem *item = Find(name, ParamStorage::Int);
+		*n = item ? item->ints.size() : 0;
+		return (item && !item->ints.empty()) ? item->ints.data() : nullptr;
+	}
+
+	const Float * ParamSet::GetTupleArray(const std::string & name, int nComponents, size_t * n) const
+	{
+		const ParamItem *item = Find(name, ParamStorage::Float);
+		if (!item || item->floats.empty() || item->floats.size() % nComponents != 0)
+		{
+			*n = 0;
+			return nullptr;
+		}
+		*n = item->floats.size() / nComponents;
+		return item->floats.data();
+	}
+
+	const Point2f * ParamSet::GetPoint2Array(const std::string & name, size_t * n) const
+	{
+		return reinterpret_cast<const Point2f *>(GetTupleArray(name, 2, n));
+	}
+
+	const Point3f * ParamSet::GetPoint3Array(const std::string & name, size_t * n) const
+	{
+		return reinterpret_cast<const Point3f *>(GetTupleArray(name, 3, n));
+	}
+
+	const Normal3f * ParamSet::GetNormal3Array(const std::string & name, size_t * n) const
+	{
+		return reinterpret_cast<const Normal3f *>(GetTupleArray(name, 3, n));
+	}
+
+	std::vector<std::string> ParamSet::UnusedParameters() const
+	{
+		std::vector<std::string> unused;
+		for (const ParamItem &item : items)
+			if (!item.lookedUp)
+				unused.push_back(item.name);
+		return unused;
+	}
+}
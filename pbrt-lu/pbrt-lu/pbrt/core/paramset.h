@@ -0,0 +1,58 @@
+#pragma once
+
+
+#include <string>
+#include <vector>
+
+#include "geometry.h"
+
+
+namespace pbrt
+{
+	// ļһ" "һֵ
+	// ֵͣfloatpoint3normalrgb...Float飬͵ķ͡
+	struct ParamItem
+	{
+		std::string type, name;
+		std::vector<Float> floats;
+		std::vector<int> ints;
+		std::vector<std::string> strings;
+		std::vector<uint8_t> bools;
+		mutable bool lookedUp = false;
+	};
+
+	// һֵ࣬ĸ
+	enum class ParamStorage { Float, Int, String, Bool, Unknown };
+	ParamStorage ParamStorageForType(const std::string &type);
+
+
+	// һָĲȡֵʱҲͲԾͷĬֵnullptr
+	// 鲻ƣGet*Arrayֱӷڲ洢ParamSet֮ǰЧ
+	class ParamSet
+	{
+	public:
+		void Add(ParamItem &&item);
+		const std::vector<ParamItem> &Items() const { return items; }
+
+		Float GetOneFloat(const std::string &name, Float def) const;
+		int GetOneInt(const std::string &name, int def) const;
+		bool GetOneBool(const std::string &name, bool def) const;
+		std::string GetOneString(const std::string &name, const std::string &def) const;
+
+		// *nΪԪظPoint3fΪĸ
+		const Float *GetFloatArray(const std::string &name, size_t *n) const;
+		const int *GetIntArray(const std::string &name, size_t *n) const;
+		const Point2f *GetPoint2Array(const std::string &name, size_t *n) const;
+		const Point3f *GetPoint3Array(const std::string &name, size_t *n) const;
+		const Normal3f *GetNormal3Array(const std::string &name, size_t *n) const;
+
+		// ûбȡֵĲʾƴдֵ߲֧Ĳ
+		std::vector<std::string> UnusedParameters() const;
+
+	private:
+		const ParamItem *Find(const std::string &name, ParamStorage storage) const;
+		const Float *GetTupleArray(const std::string &name, int nComponents, size_t *n) const;
+
+		std::vector<ParamItem> items;
+	};
+}
@@ -0,0 +1,1032 @@
+#include "parser.h"
+#include "profile.h"
+#include "stats.h"
+
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <set>
+#include <vector>
+
+#if defined(_MSC_VER)
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(PBRT_HAVE_SSE)
+#include <immintrin.h>
+#endif
+
+
+namespace pbrt
+{
+	STAT_COUNTER("Scene parsing/Bytes parsed", nBytesParsed);
+	STAT_COUNTER("Scene parsing/Numbers parsed", nNumbersParsed);
+	STAT_COUNTER("Scene parsing/Numbers handed to strtof", nSlowNumbers);
+	STAT_COUNTER("Scene parsing/Shapes", nShapesParsed);
+
+
+	// MappedFile
+
+	MappedFile::~MappedFile()
+	{
+		Close();
+	}
+
+	bool MappedFile::Open(const std::string & filename)
+	{
+		Close();
+#if defined(_MSC_VER)
+		HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+			FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			fprintf(stderr, "%s: unable to open file\n", filename.c_str());
+			return false;
+		}
+		LARGE_INTEGER fileSize;
+		GetFileSizeEx(file, &fileSize);
+		size = (size_t)fileSize.QuadPart;
+		if (size == 0)
+		{
+			CloseHandle(file);
+			return true;
+		}
+		HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		void *view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+		if (view)
+		{
+			fileHandle = file;
+			mappingHandle = mapping;
+			data = (const char *)view;
+			mapped = true;
+			return true;
+		}
+		if (mapping)
+			CloseHandle(mapping);
+		CloseHandle(file);
+#else
+		int fd = open(filename.c_str(), O_RDONLY);
+		if (fd < 0)
+		{
+			fprintf(stderr, "%s: unable to open file\n", filename.c_str());
+			return false;
+		}
+		struct stat st;
+		if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode))
+		{
+			size = (size_t)st.st_size;
+			if (size == 0)
+			{
+				close(fd);
+				return true;
+			}
+			void *p = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (p != MAP_FAILED)
+			{
+				// ͷβ˳ںǰ
+				madvise(p, size, MADV_SEQUENTIAL);
+				close(fd);
+				data = (const char *)p;
+				mapped = true;
+				return true;
+			}
+		}
+		close(fd);
+#endif
+
+		// ӳļ
+		FILE *fp = fopen(filename.c_str(), "rb");
+		if (!fp)
+		{
+			fprintf(stderr, "%s: unable to open file\n", filename.c_str());
+			return false;
+		}
+		std::vector<char> contents;
+		char chunk[65536];
+		size_t n;
+		while ((n = fread(chunk, 1, sizeof(chunk), fp)) > 0)
+			contents.insert(contents.end(), chunk, chunk + n);
+		bool ok = !ferror(fp);
+		fclose(fp);
+		if (!ok)
+		{
+			fprintf(stderr, "%s: error reading file\n", filename.c_str());
+			return false;
+		}
+		// ӳļһҳʼַ֤루һ㣩ﰴ64ֽڶ
+		size = contents.size();
+		buffer.reset(new char[size + 64]);
+		char *aligned = buffer.get() + (64 - (uintptr_t)buffer.get() % 64) % 64;
+		memcpy(aligned, contents.data(), size);
+		data = aligned;
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+		if (mapped)
+		{
+#if defined(_MSC_VER)
+			UnmapViewOfFile(data);
+			CloseHandle(mappingHandle);
+			CloseHandle(fileHandle);
+			mappingHandle = fileHandle = nullptr;
+#else
+			munmap((void *)data, size);
+#endif
+		}
+		buffer.reset();
+		data = nullptr;
+		size = 0;
+		mapped = false;
+	}
+
+
+	std::string FileLoc::ToString() const
+	{
+		std::string name = filename ? *filename : std::string("<unknown>");
+		if (line == 0)
+			return name;
+		return name + ":" + std::to_string(line) + ":" + std::to_string(column);
+	}
+
+
+	ParserTarget::~ParserTarget()
+	{
+	}
+
+
+	// ɨ
+
+	static const uint64_t Pow10Int[] = { 1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull,
+		10000000ull, 100000000ull };
+
+	// ྫȷ19λʮ֣С2^64
+	static const int MaxMantissaDigits = 19;
+
+	// 8ASCIIһתSWARp[0]λҪС
+	static inline uint32_t ParseEightDigits(const char *p)
+	{
+		uint64_t val;
+		memcpy(&val, p, sizeof(val));
+		val = (val & 0x0F0F0F0F0F0F0F0Full) * 2561 >> 8;
+		val = (val & 0x00FF00FF00FF00FFull) * 6553601 >> 16;
+		return (uint32_t)((val & 0x0000FFFF0000FFFFull) * 42949672960001ull >> 32);
+	}
+
+	// nۼӵ*mantissaϣMaxMantissaDigitsֲۼӣ*nDropped
+	static inline void AccumulateDigits(const char *p, int n, uint64_t *mantissa, int *nKept, int *nDropped)
+	{
+		int room = MaxMantissaDigits - *nKept;
+		if (n > room)
+		{
+			*nDropped += n - room;
+			n = std::max(room, 0);
+		}
+		*nKept += n;
+		uint64_t m = *mantissa;
+		for (; n >= 8; n -= 8, p += 8)
+			m = m * 100000000ull + ParseEightDigits(p);
+		for (; n > 0; --n, ++p)
+			m = m * 10 + (uint64_t)(*p - '0');
+		*mantissa = m;
+	}
+
+	static inline bool IsDigit(char c)
+	{
+		return (unsigned char)(c - '0') < 10;
+	}
+
+	// ɨpʼһִ֣֮λ
+	static inline const char *ScanDigits(const char *p, const char *end, uint64_t *mantissa, int *nKept,
+		int *nDropped)
+	{
+#if defined(PBRT_HAVE_SSE)
+		// һο16ֽڣñȽϵõִĳ
+		while (end - p >= 16)
+		{
+			__m128i c = _mm_sub_epi8(_mm_loadu_si128((const __m128i *)p), _mm_set1_epi8('0'));
+			__m128i isDigit = _mm_cmpeq_epi8(_mm_min_epu8(c, _mm_set1_epi8(9)), c);
+			uint32_t notDigit = ~(uint32_t)_mm_movemask_epi8(isDigit) & 0xffff;
+			int run = 16;
+			if (notDigit)
+			{
+#if defined(_MSC_VER)
+				unsigned long index;
+				_BitScanForward(&index, notDigit);
+				run = (int)index;
+#else
+				run = __builtin_ctz(notDigit);
+#endif
+			}
+			AccumulateDigits(p, run, mantissa, nKept, nDropped);
+			p += run;
+			if (run < 16)
+				return p;
+		}
+#endif
+		const char *start = p;
+		while (p < end && IsDigit(*p))
+			++p;
+		AccumulateDigits(start, (int)(p - start), mantissa, nKept, nDropped);
+		return p;
+	}
+
+	static const char *SlowScanFloat(const char *begin, const char *end, Float *v)
+	{
+		++nSlowNumbers;
+		char local[64];
+		std::string copy;
+		size_t n = end - begin;
+		const char *str;
+		if (n < sizeof(local))
+		{
+			memcpy(local, begin, n);
+			local[n] = '\0';
+			str = local;
+		}
+		else
+		{
+			copy.assign(begin, n);
+			str = copy.c_str();
+		}
+		*v = strtof(str, nullptr);
+		return end;
+	}
+
+	const char *ScanFloat(const char *p, const char *end, Float *v)
+	{
+		static const double Pow10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+			1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+		const char *start = p;
+		bool negative = false;
+		if (p < end && (*p == '-' || *p == '+'))
+			negative = *p++ == '-';
+
+		uint64_t mantissa = 0;
+		int nKept = 0, nDropped = 0;
+		const char *intBegin = p;
+		p = ScanDigits(p, end, &mantissa, &nKept, &nDropped);
+		int nIntDigits = (int)(p - intBegin);
+		int exp10 = nDropped;
+		int nFracDigits = 0;
+		if (p < end && *p == '.')
+		{
+			++p;
+			int keptBefore = nKept;
+			const char *fracBegin = p;
+			p = ScanDigits(p, end, &mantissa, &nKept, &nDropped);
+			nFracDigits = (int)(p - fracBegin);
+			exp10 -= nKept - keptBefore;
+		}
+		if (nIntDigits + nFracDigits == 0)
+			return nullptr;
+
+		if (p < end && (*p == 'e' || *p == 'E'))
+		{
+			const char *e = p + 1;
+			bool expNegative = false;
+			if (e < end && (*e == '-' || *e == '+'))
+				expNegative = *e++ == '-';
+			if (e < end && IsDigit(*e))
+			{
+				int exponent = 0;
+				for (; e < end && IsDigit(*e); ++e)
+					exponent = std::min(exponent * 10 + (*e - '0'), 100000);
+				exp10 += expNegative ? -exponent : exponent;
+				p = e;
+			}
+		}
+		++nNumbersParsed;
+
+		// ·Clingerβ2^5310ݲ22ʱdoubleĳ˳ֻһ룬ȷġ
+		// תfloatʱֻdoublefloatеϲſܳstrtof
+		if (nDropped == 0 && mantissa <= (1ull << 53) && exp10 >= -22 && exp10 <= 22)
+		{
+			double d = exp10 < 0 ? (double)mantissa / Pow10[-exp10] : (double)mantissa * Pow10[exp10];
+			uint64_t bits;
+			memcpy(&bits, &d, sizeof(bits));
+			bool floatMidpoint = (bits & 0x1fffffffull) == 0x10000000ull;
+			if (d == 0 || (d >= FLT_MIN && d <= FLT_MAX && !floatMidpoint))
+			{
+				*v = (Float)(negative ? -d : d);
+				return p;
+			}
+		}
+		return SlowScanFloat(start, p, v);
+	}
+
+	const char *ScanInt(const char *p, const char *end, int *v)
+	{
+		bool negative = false;
+		if (p < end && (*p == '-' || *p == '+'))
+			negative = *p++ == '-';
+		uint64_t value = 0;
+		int nKept = 0, nDropped = 0;
+		const char *begin = p;
+		p = ScanDigits(p, end, &value, &nKept, &nDropped);
+		if (p == begin || nDropped > 0 || value > (negative ? 2147483648ull : 2147483647ull))
+			return nullptr;
+		++nNumbersParsed;
+		*v = negative ? (int)(0 - value) : (int)value;
+		return p;
+	}
+
+
+	// ʷ
+
+	static inline bool IsSpace(char c)
+	{
+		return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\f' || c == '\v';
+	}
+
+	class Tokenizer;
+
+	// ָļݵһʣ
+	struct Token
+	{
+		const char *begin = nullptr;
+		size_t length = 0;
+		const Tokenizer *source = nullptr;
+
+		bool IsQuoted() const { return length >= 2 && begin[0] == '"'; }
+		template <size_t N>
+		bool Is(const char (&s)[N]) const { return length == N - 1 && memcmp(begin, s, N - 1) == 0; }
+		std::string ToString() const { return std::string(begin, length); }
+		// ȥŲת
+		std::string Dequoted() const;
+	};
+
+	std::string Token::Dequoted() const
+	{
+		std::string s;
+		s.reserve(length);
+		for (size_t i = 1; i + 1 < length; ++i)
+		{
+			char c = begin[i];
+			if (c == '\\' && i + 2 < length)
+			{
+				switch (begin[++i])
+				{
+				case 'b': c = '\b'; break;
+				case 'f': c = '\f'; break;
+				case 'n': c = '\n'; break;
+				case 'r': c = '\r'; break;
+				case 't': c = '\t'; break;
+				default: c = begin[i]; break;
+				}
+			}
+			s.push_back(c);
+		}
+		return s;
+	}
+
+	class Tokenizer
+	{
+	public:
+		Tokenizer(const char *begin, const char *end, const std::string &filename,
+			std::unique_ptr<MappedFile> file = nullptr)
+			: filename(filename), begin(begin), end(end), pos(begin), file(std::move(file)),
+			lineCursor(begin), lineStart(begin)
+		{
+			nBytesParsed += end - begin;
+		}
+
+		// ļʱfalse
+		bool Next(Token *tok)
+		{
+			SkipSpace();
+			if (pos >= end || failed)
+				return false;
+			const char *start = pos;
+			if (*pos == '"')
+			{
+				// Ҳбܵ
+				const char *q = pos + 1;
+				for (;;)
+				{
+					q = (const char *)memchr(q, '"', end - q);
+					if (!q)
+					{
+						Error(start, "unterminated string");
+						failed = true;
+						return false;
+					}
+					const char *b = q;
+					while (b > start + 1 && b[-1] == '\\')
+						--b;
+					if ((q - b) % 2 == 0)
+						break;
+					++q;
+				}
+				pos = q + 1;
+			}
+			else if (*pos == '[' || *pos == ']')
+				++pos;
+			else
+			{
+				while (pos < end && !IsSpace(*pos) && *pos != '"' && *pos != '[' && *pos != ']' && *pos != '#')
+					++pos;
+			}
+			tok->begin = start;
+			tok->length = pos - start;
+			tok->source = this;
+			return true;
+		}
+
+		// '['֮ãһֱ']'Ϊֹ
+		bool ScanFloatArray(std::vector<Float> *out)
+		{
+			for (;;)
+			{
+				SkipSpace();
+				if (pos >= end)
+					return Error(pos, "unterminated '['");
+				if (*pos == ']')
+				{
+					++pos;
+					return true;
+				}
+				Float v;
+				const char *next = ScanFloat(pos, end, &v);
+				if (!next || !IsNumberEnd(next))
+					return Error(pos, "expected a number");
+				out->push_back(v);
+				pos = next;
+			}
+		}
+
+		bool ScanIntArray(std::vector<int> *out)
+		{
+			for (;;)
+			{
+				SkipSpace();
+				if (pos >= end)
+					return Error(pos, "unterminated '['");
+				if (*pos == ']')
+				{
+					++pos;
+					return true;
+				}
+				int v;
+				const char *next = ScanInt(pos, end, &v);
+				if (!next || !IsNumberEnd(next))
+					return Error(pos, "expected an integer");
+				out->push_back(v);
+				pos = next;
+			}
+		}
+
+		// ÿָҪȡλãкŴϴĵطļֻɨһ顣
+		// ֻлͷλʱŴļͷ
+		FileLoc Loc(const char *p) const
+		{
+			if (p < lineCursor)
+			{
+				lineCursor = lineStart = begin;
+				line = 1;
+			}
+			while (const char *nl = (const char *)memchr(lineCursor, '\n', p - lineCursor))
+			{
+				++line;
+				lineCursor = lineStart = nl + 1;
+			}
+			lineCursor = p;
+
+			FileLoc loc;
+			loc.filename = &filename;
+			loc.line = line;
+			loc.column = (int)(p - lineStart) + 1;
+			return loc;
+		}
+
+		bool Error(const char *p, const char *message) const
+		{
+			fprintf(stderr, "%s: error: %s\n", Loc(p).ToString().c_str(), message);
+			return false;
+		}
+
+		bool Failed() const { return failed; }
+
+		const std::string filename;
+
+	private:
+		void SkipSpace()
+		{
+			for (;;)
+			{
+				while (pos < end && IsSpace(*pos))
+					++pos;
+				if (pos >= end || *pos != '#')
+					return;
+				const char *nl = (const char *)memchr(pos, '\n', end - pos);
+				pos = nl ? nl + 1 : end;
+			}
+		}
+
+		bool IsNumberEnd(const char *p) const
+		{
+			return p == end || IsSpace(*p) || *p == ']' || *p == '#';
+		}
+
+		const char *begin, *end, *pos;
+		std::unique_ptr<MappedFile> file;
+		bool failed = false;
+		// LocѾλãlineCursor֮ǰline - 1УһдlineStartʼ
+		mutable const char *lineCursor, *lineStart;
+		mutable int line = 1;
+	};
+
+
+	// ﷨
+
+	class Parser
+	{
+	public:
+		explicit Parser(ParserTarget *target) : target(target) {}
+
+		bool Parse();
+
+		// ļջIncludeļѹ棬󵯳
+		std::vector<std::unique_ptr<Tokenizer>> files;
+		std::vector<std::unique_ptr<Tokenizer>> finishedFiles;
+
+	private:
+		struct GraphicsState
+		{
+			Transform ctm;
+			bool reverseOrientation = false;
+			bool attribute;   // AttributeBeginѹģTransformBeginѹָֻ任
+		};
+
+		bool Next(Token *tok);
+		bool Peek(Token *tok);
+		bool NextOrError(Token *tok, const char *what);
+		bool ReadString(std::string *s, const char *what);
+		bool ReadFloats(Float *v, int n, const char *what);
+		bool ReadMatrix(Transform *t);
+		bool ParseParams(ParamSet *params);
+		bool ParseParamValue(ParamItem *item, ParamStorage storage, const Token &declToken);
+		bool Include(const Token &directive);
+		void ReportUnused(const Token &directive, const ParamSet &params, const FileLoc &loc);
+		void SkipDirective(const Token &directive);
+		bool Error(const Token &tok, const std::string &message) const;
+		void Warning(const Token &tok, const std::string &message) const;
+
+		ParserTarget *target;
+		Token unget;
+		bool hasUnget = false;
+
+		Transform ctm;
+		bool reverseOrientation = false;
+		std::vector<GraphicsState> stateStack;
+		std::map<std::string, Transform> namedCoordinateSystems;
+		std::set<std::string> warnedDirectives;
+		// Ѿ"ָ/"󳡾ͬĲڳǧָظ
+		std::set<std::string> warnedUnused;
+	};
+
+	bool Parser::Next(Token *tok)
+	{
+		if (hasUnget)
+		{
+			*tok = unget;
+			hasUnget = false;
+			return true;
+		}
+		while (!files.empty())
+		{
+			if (files.back()->Next(tok))
+				return true;
+			if (files.back()->Failed())
+				return false;
+			// IncludeļˡǰһʱǰָָܻļԵһָͷ
+			if (files.size() == 1)
+				return false;
+			finishedFiles.push_back(std::move(files.back()));
+			files.pop_back();
+		}
+		return false;
+	}
+
+	bool Parser::Peek(Token *tok)
+	{
+		if (!hasUnget)
+		{
+			if (!Next(&unget))
+				return false;
+			hasUnget = true;
+		}
+		*tok = unget;
+		return true;
+	}
+
+	bool Parser::Error(const Token &tok, const std::string &message) const
+	{
+		return tok.source->Error(tok.begin, message.c_str());
+	}
+
+	void Parser::Warning(const Token &tok, const std::string &message) const
+	{
+		fprintf(stderr, "%s: warning: %s\n", tok.source->Loc(tok.begin).ToString().c_str(), message.c_str());
+	}
+
+	bool Parser::NextOrError(Token *tok, const char *what)
+	{
+		if (Next(tok))
+			return true;
+		const Tokenizer &last = *files.back();
+		if (last.Failed())
+			return false;
+		fprintf(stderr, "%s: error: unexpected end of file, expected %s\n", last.filename.c_str(), what);
+		return false;
+	}
+
+	bool Parser::ReadString(std::string *s, const char *what)
+	{
+		Token tok;
+		if (!NextOrError(&tok, what))
+			return false;
+		if (!tok.IsQuoted())
+			return Error(tok, std::string("expected ") + what);
+		*s = tok.Dequoted();
+		return true;
+	}
+
+	bool Parser::ReadFloats(Float *v, int n, const char *what)
+	{
+		for (int i = 0; i < n; ++i)
+		{
+			Token tok;
+			if (!NextOrError(&tok, what))
+				return false;
+			const char *e = ScanFloat(tok.begin, tok.begin + tok.length, &v[i]);
+			if (!e || e != tok.begin + tok.length)
+				return Error(tok, std::string("expected ") + what);
+		}
+		return true;
+	}
+
+	// "[ 16 ]"ȴţpbrtԼתúǵľ
+	bool Parser::ReadMatrix(Transform *t)
+	{
+		Token tok;
+		if (!NextOrError(&tok, "'['"))
+			return false;
+		if (!tok.Is("["))
+			return Error(tok, "expected '[' before the 16 matrix elements");
+		std::vector<Float> m;
+		if (!files.back()->ScanFloatArray(&m))
+			return false;
+		if (m.size() != 16)
+			return Error(tok, "a transformation matrix needs 16 values");
+		Matrix4x4 mat(m[0], m[1], m[2], m[3], m[4], m[5], m[6], m[7], m[8], m[9], m[10], m[11], m[12], m[13],
+			m[14], m[15]);
+		Transform tm;
+		if (!Transform::FromMatrix(mat, &tm))
+			return Error(tok, "singular transformation matrix");
+		*t = Transpose(tm);
+		return true;
+	}
+
+	bool Parser::ParseParamValue(ParamItem *item, ParamStorage storage, const Token &declToken)
+	{
+		Token tok;
+		if (!NextOrError(&tok, "a parameter value"))
+			return false;
+		bool bracketed = tok.Is("[");
+		if (bracketed && storage == ParamStorage::Float)
+			return files.back()->ScanFloatArray(&item->floats);
+		if (bracketed && storage == ParamStorage::Int)
+			return files.back()->ScanIntArray(&item->ints);
+
+		// ַͲֵԼŵĵ֣ʴ
+		for (;;)
+		{
+			if (bracketed && !NextOrError(&tok, "']'"))
+				return false;
+			if (bracketed && tok.Is("]"))
+				return true;
+			switch (storage)
+			{
+			case ParamStorage::Float:
+			case ParamStorage::Int:
+			{
+				const char *e;
+				const char *tokEnd = tok.begin + tok.length;
+				if (storage == ParamStorage::Float)
+				{
+					Float v;
+					e = ScanFloat(tok.begin, tokEnd, &v);
+					item->floats.push_back(v);
+				}
+				else
+				{
+					int v;
+					e = ScanInt(tok.begin, tokEnd, &v);
+					item->ints.push_back(v);
+				}
+				if (e != tokEnd)
+					return Error(tok, "expected a number for parameter \"" + item->name + "\"");
+				break;
+			}
+			case ParamStorage::String:
+				if (!tok.IsQuoted())
+					return Error(tok, "expected a quoted string for parameter \"" + item->name + "\"");
+				item->strings.push_back(tok.Dequoted());
+				break;
+			case ParamStorage::Bool:
+			{
+				std::string s = tok.IsQuoted() ? tok.Dequoted() : tok.ToString();
+				if (s != "true" && s != "false")
+					return Error(tok, "expected true or false for parameter \"" + item->name + "\"");
+				item->bools.push_back(s == "true");
+				break;
+			}
+			default:
+				return Error(declToken, "unknown parameter type \"" + item->type + "\"");
+			}
+			if (!bracketed)
+				return true;
+		}
+	}
+
+	bool Parser::ParseParams(ParamSet *params)
+	{
+		for (;;)
+		{
+			Token decl;
+			if (!Peek(&decl) || !decl.IsQuoted())
+				return true;
+			Next(&decl);
+
+			// " "
+			std::string s = decl.Dequoted();
+			size_t typeBegin = s.find_first_not_of(" \t");
+			size_t typeEnd = s.find_first_of(" \t", typeBegin);
+			size_t nameBegin = s.find_first_not_of(" \t", typeEnd);
+			size_t nameEnd = s.find_first_of(" \t", nameBegin);
+			if (typeBegin == std::string::npos || nameBegin == std::string::npos ||
+				s.find_first_not_of(" \t", nameEnd) != std::string::npos)
+				return Error(decl, "expected \"type name\" in parameter declaration, got \"" + s + "\"");
+
+			ParamItem item;
+			item.type = s.substr(typeBegin, typeEnd - typeBegin);
+			item.name = s.substr(nameBegin, nameEnd - nameBegin);
+			ParamStorage storage = ParamStorageForType(item.type);
+			if (storage == ParamStorage::Unknown)
+				return Error(decl, "unknown parameter type \"" + item.type + "\"");
+			if (!ParseParamValue(&item, storage, decl))
+				return false;
+			params->Add(std::move(item));
+		}
+	}
+
+	void Parser::ReportUnused(const Token &directive, const ParamSet &params, const FileLoc &loc)
+	{
+		for (const std::string &name : params.UnusedParameters())
+			if (warnedUnused.insert(directive.ToString() + "/" + name).second)
+				fprintf(stderr, "%s: warning: parameter \"%s\" is not used (reported once per %s)\n",
+					loc.ToString().c_str(), name.c_str(), directive.ToString().c_str());
+	}
+
+	void Parser::SkipDirective(const Token &directive)
+	{
+		std::string name = directive.ToString();
+		if (warnedDirectives.insert(name).second)
+			Warning(directive, "\"" + name + "\" is not supported and is ignored");
+		// ָԴдĸͷֱһָ
+		Token tok;
+		while (Peek(&tok) && !(tok.begin[0] >= 'A' && tok.begin[0] <= 'Z'))
+			Next(&tok);
+	}
+
+	static std::string DirectoryOf(const std::string &filename)
+	{
+		size_t slash = filename.find_last_of("/\\");
+		return slash == std::string::npos ? std::string() : filename.substr(0, slash + 1);
+	}
+
+	static bool IsAbsolutePath(const std::string &filename)
+	{
+		if (filename.empty())
+			return false;
+		if (filename[0] == '/' || filename[0] == '\\')
+			return true;
+		return filename.size() > 1 && filename[1] == ':';
+	}
+
+	bool Parser::Include(const Token &directive)
+	{
+		std::string name;
+		if (!ReadString(&name, "a file name"))
+			return false;
+		// ·ڵǰļڵĿ¼
+		if (!IsAbsolutePath(name))
+			name = DirectoryOf(directive.source->filename) + name;
+		if (files.size() > 64)
+			return Error(directive, "Include nested too deeply");
+		std::unique_ptr<MappedFile> file(new MappedFile);
+		if (!file->Open(name))
+			return Error(directive, "unable to include \"" + name + "\"");
+		const char *data = file->Data();
+		size_t size = file->Size();
+		files.emplace_back(new Tokenizer(data, data + size, name, std::move(file)));
+		return true;
+	}
+
+	bool Parser::Parse()
+	{
+		Token tok;
+		while (Next(&tok))
+		{
+			if (!finishedFiles.empty() && tok.source == files.back().get())
+				finishedFiles.clear();
+			FileLoc loc = tok.source->Loc(tok.begin);
+			if (tok.Is("Shape"))
+			{
+				std::string name;
+				ParamSet params;
+				if (!ReadString(&name, "a shape name") || !ParseParams(&params))
+					return false;
+				++nShapesParsed;
+				target->Shape(name, params, ctm, reverseOrientation, loc);
+				ReportUnused(tok, params, loc);
+			}
+			else if (tok.Is("Transform") || tok.Is("ConcatTransform"))
+			{
+				Transform t;
+				if (!ReadMatrix(&t))
+					return false;
+				ctm = tok.Is("Transform") ? t : ctm * t;
+			}
+			else if (tok.Is("Identity"))
+				ctm = Transform();
+			else if (tok.Is("Translate"))
+			{
+				Float v[3];
+				if (!ReadFloats(v, 3, "3 numbers after Translate"))
+					return false;
+				ctm = ctm * Translate(Vector3f(v[0], v[1], v[2]));
+			}
+			else if (tok.Is("Scale"))
+			{
+				Float v[3];
+				if (!ReadFloats(v, 3, "3 numbers after Scale"))
+					return false;
+				ctm = ctm * Scale(v[0], v[1], v[2]);
+			}
+			else if (tok.Is("Rotate"))
+			{
+				Float v[4];
+				if (!ReadFloats(v, 4, "4 numbers after Rotate"))
+					return false;
+				ctm = ctm * Rotate(v[0], Vector3f(v[1], v[2], v[3]));
+			}
+			else if (tok.Is("LookAt"))
+			{
+				Float v[9];
+				if (!ReadFloats(v, 9, "9 numbers after LookAt"))
+					return false;
+				ctm = ctm * LookAt(Point3f(v[0], v[1], v[2]), Point3f(v[3], v[4], v[5]), Vector3f(v[6], v[7], v[8]));
+			}
+			else if (tok.Is("CoordinateSystem"))
+			{
+				std::string name;
+				if (!ReadString(&name, "a coordinate system name"))
+					return false;
+				namedCoordinateSystems[name] = ctm;
+			}
+			else if (tok.Is("CoordSysTransform"))
+			{
+				std::string name;
+				if (!ReadString(&name, "a coordinate system name"))
+					return false;
+				auto it = namedCoordinateSystems.find(name);
+				if (it == namedCoordinateSystems.end())
+					Warning(tok, "coordinate system \"" + name + "\" is not defined");
+				else
+					ctm = it->second;
+			}
+			else if (tok.Is("AttributeBegin") || tok.Is("TransformBegin"))
+			{
+				GraphicsState state;
+				state.ctm = ctm;
+				state.reverseOrientation = reverseOrientation;
+				state.attribute = tok.Is("AttributeBegin");
+				stateStack.push_back(state);
+			}
+			else if (tok.Is("AttributeEnd") || tok.Is("TransformEnd"))
+			{
+				if (stateStack.empty())
+				{
+					Warning(tok, "unmatched " + tok.ToString() + " ignored");
+					continue;
+				}
+				const GraphicsState &state = stateStack.back();
+				if (state.attribute != tok.Is("AttributeEnd"))
+					Warning(tok, tok.ToString() + " does not match the innermost " +
+						(state.attribute ? "AttributeBegin" : "TransformBegin"));
+				ctm = state.ctm;
+				if (state.attribute)
+					reverseOrientation = state.reverseOrientation;
+				stateStack.pop_back();
+			}
+			else if (tok.Is("ReverseOrientation"))
+				reverseOrientation = !reverseOrientation;
+			else if (tok.Is("ObjectBegin"))
+			{
+				std::string name;
+				if (!ReadString(&name, "an object name"))
+					return false;
+				// pbrt-v3һObjectBeginͬʱʼһԿ
+				GraphicsState state;
+				state.ctm = ctm;
+				state.reverseOrientation = reverseOrientation;
+				state.attribute = true;
+				stateStack.push_back(state);
+				target->ObjectBegin(name, loc);
+			}
+			else if (tok.Is("ObjectEnd"))
+			{
+				target->ObjectEnd(loc);
+				if (!stateStack.empty())
+				{
+					ctm = stateStack.back().ctm;
+					reverseOrientation = stateStack.back().reverseOrientation;
+					stateStack.pop_back();
+				}
+			}
+			else if (tok.Is("ObjectInstance"))
+			{
+				std::string name;
+				if (!ReadString(&name, "an object name"))
+					return false;
+				target->ObjectInstance(name, ctm, loc);
+			}
+			else if (tok.Is("Camera"))
+			{
+				std::string name;
+				ParamSet params;
+				if (!ReadString(&name, "a camera name") || !ParseParams(&params))
+					return false;
+				Transform cameraToWorld = Inverse(ctm);
+				namedCoordinateSystems["camera"] = cameraToWorld;
+				target->Camera(name, params, cameraToWorld, loc);
+				ReportUnused(tok, params, loc);
+			}
+			else if (tok.Is("WorldBegin"))
+			{
+				ctm = Transform();
+				namedCoordinateSystems["world"] = ctm;
+			}
+			else if (tok.Is("WorldEnd"))
+				;
+			else if (tok.Is("Include") || tok.Is("Import"))
+			{
+				if (!Include(tok))
+					return false;
+			}
+			else if (tok.begin[0] >= 'A' && tok.begin[0] <= 'Z')
+				SkipDirective(tok);
+			else
+				return Error(tok, "unexpected \"" + tok.ToString() + "\", expected a directive");
+		}
+		return !files.back()->Failed();
+	}
+
+
+	static bool ParseTokenizer(std::unique_ptr<Tokenizer> tokenizer, ParserTarget *target)
+	{
+		ProfilePhase _(Prof::SceneParsing);
+		Parser parser(target);
+		parser.files.push_back(std::move(tokenizer));
+		return parser.Parse();
+	}
+
+	bool ParseFile(const std::string &filename, ParserTarget *target)
+	{
+		std::unique_ptr<MappedFile> file(new MappedFile);
+		if (!file->Open(filename))
+			return false;
+		const char *data = file->Data();
+		size_t size = file->Size();
+		return ParseTokenizer(std::unique_ptr<Tokenizer>(new Tokenizer(data, data + size, filename,
+			std::move(file))), target);
+	}
+
+	bool ParseString(const std::string &text, const std::string &name, ParserTarget *target)
+	{
+		return ParseTokenizer(std::unique_ptr<Tokenizer>(new Tokenizer(text.data(), text.data() + text.size(),
+			name)), target);
+	}
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "paramset.h"
+#include "transform.h"
+
+
+// pbrt-v3ļĽ
+// ļmmapӳڴ棬ʷֱӳڴϽУʣTokenָֻļݵָͳȣ
+// Ϊÿʷַ㡢ߡ±Ĵ鲻гɴʣɨSSE2ִĳȣ
+// һת8λֱ֣ӽParamItemParserTargetShapeмûжĸơ
+//
+// ֵָ֧ShapeTransformConcatTransformIdentityTranslateScaleRotateLookAt
+// CoordinateSystemCoordSysTransformAttributeBegin/EndTransformBegin/EndReverseOrientation
+// ObjectBegin/EndObjectInstanceCameraWorldBegin/EndIncludepbrt-v4Import
+// ʡԴpbrtָͬһÿֻһΡ
+namespace pbrt
+{
+	// ֻӳļӳʧʱܵڴ
+	class MappedFile
+	{
+	public:
+		MappedFile() {}
+		~MappedFile();
+		MappedFile(const MappedFile &) = delete;
+		MappedFile &operator=(const MappedFile &) = delete;
+
+		// ʧʱϢ
+		bool Open(const std::string &filename);
+		void Close();
+
+		const char *Data() const { return data; }
+		size_t Size() const { return size; }
+
+	private:
+		const char *data = nullptr;
+		size_t size = 0;
+		bool mapped = false;
+		std::unique_ptr<char[]> buffer;
+#if defined(_MSC_VER)
+		void *fileHandle = nullptr, *mappingHandle = nullptr;
+#endif
+	};
+
+
+	// ļеλáкɴʷ߶filenameַָֻڻصڼЧ
+	struct FileLoc
+	{
+		const std::string *filename = nullptr;
+		int line = 0, column = 0;   // 1ʼ0ʾδ֪
+
+		std::string ToString() const;
+	};
+
+
+	// ѳParserTarget任Ѿռģʵռģ
+	// ûбõĲɽڻصغ档
+	class ParserTarget
+	{
+	public:
+		virtual ~ParserTarget();
+
+		// cameraToWorldΪCameraָǰ任
+		virtual void Camera(const std::string &name, const ParamSet &params, const Transform &cameraToWorld,
+			const FileLoc &loc) = 0;
+		virtual void Shape(const std::string &name, const ParamSet &params, const Transform &objectToWorld,
+			bool reverseOrientation, const FileLoc &loc) = 0;
+		virtual void ObjectBegin(const std::string &name, const FileLoc &loc) = 0;
+		virtual void ObjectEnd(const FileLoc &loc) = 0;
+		virtual void ObjectInstance(const std::string &name, const Transform &instanceToWorld,
+			const FileLoc &loc) = 0;
+	};
+
+
+	// ļIncludeļ﷨ʱ"ļ::: "false
+	bool ParseFile(const std::string &filename, ParserTarget *target);
+	// ڴınameֻڱIncludeڵǰĿ¼
+	bool ParseString(const std::string &text, const std::string &name, ParserTarget *target);
+
+
+	// ɨڲʹãΪܵ׼ԡ
+	// pʼһʮǰհףɹʱ֮λãʱnullptr
+	// Ľstrtofȫܾͬȷжϵ߿·ཻstrtof
+	const char *ScanFloat(const char *p, const char *end, Float *v);
+	const char *ScanInt(const char *p, const char *end, int *v);
+}
@@ -0,0 +1,148 @@
+#include "primitive.h"
+#include "Shape.h"
+#include "interaction.h"
+#include "profile.h"
+#include "raypacket.h"
+#include "shapedispatch.h"
+#include "stats.h"
+#include "transform.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+
+namespace pbrt
+{
+	STAT_GLOBAL_PERCENT("Intersections/Shape closest-hit tests", nShapeHits, nShapeTests);
+	STAT_GLOBAL_PERCENT("Intersections/Shape any-hit tests", nShapePHits, nShapePTests);
+
+	bool Primitive::Intersect(const Ray & r, SurfaceInteraction * isect) const
+	{
+		SurfaceHit hit;
+		if (!IntersectHit(r, &hit))
+			return false;
+		InteractionFromHit(r, hit, isect);
+		return true;
+	}
+
+	void Primitive::InteractionFromHit(const Ray & r, const SurfaceHit & hit, SurfaceInteraction * isect)
+	{
+		ProfilePhase _(Prof::ComputeSurfaceInteraction);
+		if (hit.worldToInstance)
+		{
+			// ʵĽ㣺ռ乹죬ٱ任ռ
+			Ray rayObj = (*hit.worldToInstance)(r);
+			SurfaceInteraction isectObj;
+			hit.primitive->ComputeSurfaceInteraction(rayObj, hit, &isectObj);
+			*isect = (*hit.instanceToWorld)(isectObj);
+		}
+		else
+			hit.primitive->ComputeSurfaceInteraction(r, hit, isect);
+	}
+
+	void Primitive::ComputeSurfaceInteraction(const Ray &, const SurfaceHit &, SurfaceInteraction *) const
+	{
+		// ֻҶͼԪhit.primitiveߵIntersectHitbugrelease汾Ҳܼ
+		fprintf(stderr, "Primitive::ComputeSurfaceInteraction called on a non-leaf primitive\n");
+		abort();
+	}
+
+	uint32_t Primitive::IntersectPacket(RayPacket & packet, uint32_t activeMask, SurfaceInteraction * isects) const
+	{
+		uint32_t hitMask = 0;
+		for (int i = 0; i < packet.size; ++i)
+		{
+			if (!(activeMask & (1u << i)))
+				continue;
+			Ray r = packet.GetRay(i);
+			if (Intersect(r, &isects[i]))
+			{
+				packet.tMax[i] = r.tMax;
+				hitMask |= 1u << i;
+			}
+		}
+		return hitMask;
+	}
+
+	uint32_t Primitive::IntersectPPacket(const RayPacket & packet, uint32_t activeMask) const
+	{
+		uint32_t hitMask = 0;
+		for (int i = 0; i < packet.size; ++i)
+			if ((activeMask & (1u << i)) && IntersectP(packet.GetRay(i)))
+				hitMask |= 1u << i;
+		return hitMask;
+	}
+
+	GeometricPrimitive::GeometricPrimitive(const std::shared_ptr<Shape> &shape)
+		: shape(shape), shapeHandle(ShapeHandle::FromShape(shape.get()))
+	{
+	}
+
+	Bounds3f GeometricPrimitive::WorldBound() const
+	{
+		return shapeHandle ? shapeHandle.WorldBound() : shape->WorldBound();
+	}
+
+	bool GeometricPrimitive::Intersect(const Ray & r, SurfaceInteraction * isect) const
+	{
+		ProfilePhase _(Prof::ShapeIntersect);
+		Float tHit;
+		++nShapeTests;
+		if (!shape->Intersect(r, &tHit, isect))
+			return false;
+		++nShapeHits;
+
+		r.tMax = tHit;
+		isect->primitive = this;
+		return true;
+	}
+
+	bool GeometricPrimitive::IntersectHit(const Ray & r, SurfaceHit * hit) const
+	{
+		return IntersectHitInline(r, hit);
+	}
+
+	void GeometricPrimitive::ComputeSurfaceInteraction(const Ray & r, const SurfaceHit & hit, SurfaceInteraction * isect) const
+	{
+		shape->ComputeSurfaceInteraction(r, hit, isect);
+		isect->primitive = this;
+	}
+
+	bool GeometricPrimitive::IntersectP(const Ray & r) const
+	{
+		return IntersectPInline(r);
+	}
+
+	uint32_t GeometricPrimitive::IntersectPacket(RayPacket & packet, uint32_t activeMask, SurfaceInteraction * isects) const
+	{
+		return IntersectPacketInline(packet, activeMask, isects);
+	}
+
+	uint32_t GeometricPrimitive::IntersectPPacket(const RayPacket & packet, uint32_t activeMask) const
+	{
+		return IntersectPPacketInline(packet, activeMask);
+	}
+
+	Bounds3f TransformedPrimitive::WorldBound() const
+	{
+		return (*PrimitiveToWorld)(primitive->WorldBound());
+	}
+
+	bool TransformedPrimitive::IntersectHit(const Ray & r, SurfaceHit * hit) const
+	{
+		// 任ʱһռеtռеt
+		Ray ray = (*WorldToPrimitive)(r);
+		if (!primitive->IntersectHit(ray, hit))
+			return false;
+
+		r.tMax = ray.tMax;
+		hit->instanceToWorld = PrimitiveToWorld;
+		hit->worldToInstance = WorldToPrimitive;
+		return true;
+	}
+
+	bool TransformedPrimitive::IntersectP(const Ray & r) const
+	{
+		return primitive->IntersectP((*WorldToPrimitive)(r));
+	}
+}
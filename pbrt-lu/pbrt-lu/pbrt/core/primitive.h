@@ -0,0 +1,126 @@
+#pragma once
+
+
+#include <cstdint>
+#include <memory>
+
+#include "geometry.h"
+#include "Shape.h"
+#include "taggedpointer.h"
+
+
+namespace pbrt
+{
+	class Transform;
+	class SurfaceInteraction;
+	struct SurfaceHit;
+	struct RayPacket;
+
+	// ٽṹĻԪShapeֻ𼸺ΣPrimitiveѼκͳϢԺĲʡԴȣһ
+	class Primitive
+	{
+	public:
+		virtual ~Primitive() {}
+
+		virtual Bounds3f WorldBound() const = 0;
+
+		// ҵʱray.tMaxΪtֵ
+		// ĬʵIntersectHitҵĽ㣬ֻΪһSurfaceInteraction
+		virtual bool Intersect(const Ray &r, SurfaceInteraction *isect) const;
+
+		// ֻ¼СĽϢhit->primitiveǱеǸҶͼԪͬray.tMax
+		virtual bool IntersectHit(const Ray &r, SurfaceHit *hit) const = 0;
+
+		// hit->primitiveãΪIntersectHitҵĽ㹹SurfaceInteraction
+		// ʵʱrǱ任ʵռߣĽɵٱ任ռ
+		virtual void ComputeSurfaceInteraction(const Ray &r, const SurfaceHit &hit,
+			SurfaceInteraction *isect) const;
+
+		// ΪռrĽhitSurfaceInteractionhit.primitive->ComputeSurfaceInteraction
+		// ʵʱȰr任ʵռ䣬ٰѽ任ռ
+		static void InteractionFromHit(const Ray &r, const SurfaceHit &hit, SurfaceInteraction *isect);
+
+		virtual bool IntersectP(const Ray &r) const = 0;
+
+		// ߰󽻣ֻactiveMaskеߣ롣
+		// ߵpacket.tMax£isects±һһӦ
+		// Ĭʵñ汾
+		virtual uint32_t IntersectPacket(RayPacket &packet, uint32_t activeMask,
+			SurfaceInteraction *isects) const;
+
+		virtual uint32_t IntersectPPacket(const RayPacket &packet, uint32_t activeMask) const;
+	};
+
+
+	class GeometricPrimitive : public Primitive
+	{
+	public:
+		GeometricPrimitive(const std::shared_ptr<Shape> &shape);
+
+		virtual Bounds3f WorldBound() const;
+		virtual bool Intersect(const Ray &r, SurfaceInteraction *isect) const;
+		virtual bool IntersectHit(const Ray &r, SurfaceHit *hit) const;
+		virtual void ComputeSurfaceInteraction(const Ray &r, const SurfaceHit &hit,
+			SurfaceInteraction *isect) const;
+		virtual bool IntersectP(const Ray &r) const;
+		virtual uint32_t IntersectPacket(RayPacket &packet, uint32_t activeMask,
+			SurfaceInteraction *isects) const;
+		virtual uint32_t IntersectPPacket(const RayPacket &packet, uint32_t activeMask) const;
+
+		const std::shared_ptr<Shape> &GetShape() const { return shape; }
+
+		// 漸麯ķ汾shapedispatch.hٽṹҶͨPrimitiveHandleֱӵá
+		// ״ShapeHandleֵ֧ʱ̬ɣShape麯
+		inline bool IntersectHitInline(const Ray &r, SurfaceHit *hit) const;
+		inline bool IntersectPInline(const Ray &r) const;
+		inline uint32_t IntersectPacketInline(RayPacket &packet, uint32_t activeMask,
+			SurfaceInteraction *isects) const;
+		inline uint32_t IntersectPPacketInline(const RayPacket &packet, uint32_t activeMask) const;
+
+	private:
+		std::shared_ptr<Shape> shape;
+		ShapeHandle shapeHandle;
+	};
+
+
+	// ٽṹҶͼԪGeometricPrimitiveֱӵķ汾
+	// ͼԪʵǶ׵ľۺȣȻPrimitive麯
+	// ֻһָ룬ͼԪɼٽṹshared_ptr֤ڡԱshapedispatch.h
+	class PrimitiveHandle : public TaggedPointer<GeometricPrimitive, Primitive>
+	{
+	public:
+		using TaggedPointer::TaggedPointer;
+
+		static PrimitiveHandle FromPrimitive(const Primitive *primitive);
+
+		bool IntersectHit(const Ray &r, SurfaceHit *hit) const;
+		bool IntersectP(const Ray &r) const;
+		uint32_t IntersectPPacket(const RayPacket &packet, uint32_t activeMask) const;
+	};
+
+
+	// ʵһͼԪͨһõײBVHټһԱ任ͬһڳظζøơ
+	// ߽ʱWorldToPrimitive任ռ䣬Ϣڹʱٱ任ռ䡣
+	// 任ӦTransformCacheʵáֻ֧һʵprimitiveﲻʵ
+	class TransformedPrimitive : public Primitive
+	{
+	public:
+		TransformedPrimitive(const std::shared_ptr<Primitive> &primitive,
+			const Transform *PrimitiveToWorld, const Transform *WorldToPrimitive)
+			: primitive(primitive), PrimitiveToWorld(PrimitiveToWorld), WorldToPrimitive(WorldToPrimitive) {}
+
+		virtual Bounds3f WorldBound() const;
+		virtual bool IntersectHit(const Ray &r, SurfaceHit *hit) const;
+		virtual bool IntersectP(const Ray &r) const;
+
+	private:
+		std::shared_ptr<Primitive> primitive;
+		const Transform *PrimitiveToWorld, *WorldToPrimitive;
+	};
+
+
+	// ۺ壨ٽṹҲһPrimitive
+	class Aggregate : public Primitive
+	{
+	};
+}
@@ -0,0 +1,303 @@
+#include "profile.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#if !defined(_MSC_VER)
+#include <signal.h>
+#include <sys/time.h>
+#define PBRT_HAVE_ITIMER
+#endif
+
+
+namespace pbrt
+{
+	PBRT_THREAD_LOCAL uint64_t ProfilerState;
+	bool ProfilerTracing = false;
+
+	static const char *ProfNames[] = {
+		"Scene construction",
+		"Scene parsing",
+		"Acceleration structure creation",
+		"Render tile",
+		"Film merge",
+		"Image write",
+		"Scene::Intersect()",
+		"Scene::IntersectP()",
+		"Accelerator::Intersect()",
+		"Accelerator::IntersectP()",
+		"Shape::Intersect()",
+		"Shape::IntersectP()",
+		"SurfaceInteraction construction",
+		"Shading",
+		"Film::AddSample()",
+	};
+	static_assert(sizeof(ProfNames) / sizeof(ProfNames[0]) == (int)Prof::NumProfCategories,
+		"ProfNames must match Prof");
+
+	const char *ProfName(Prof p)
+	{
+		return ProfNames[(int)p];
+	}
+
+
+	// ʱ
+
+	static const std::chrono::steady_clock::time_point profilerEpoch = std::chrono::steady_clock::now();
+
+	int64_t ProfilerTime()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now() - profilerEpoch).count();
+	}
+
+	struct TraceEvent
+	{
+		int64_t start, end;   // 
+		int32_t category;
+	};
+
+	// һ̵߳Ļλֻ߳д
+	struct TraceBuffer
+	{
+		static const int Capacity = 1 << 16;
+		int threadIndex;
+		uint64_t count = 0;   // д¼Capacityʱǰѱ
+		std::unique_ptr<TraceEvent[]> events{ new TraceEvent[Capacity] };
+	};
+
+	static PBRT_THREAD_LOCAL TraceBuffer *threadTraceBuffer;
+	static std::vector<std::unique_ptr<TraceBuffer>> traceBuffers;
+	static std::mutex traceBuffersMutex;
+
+	void RecordTraceEvent(Prof p, int64_t start, int64_t end)
+	{
+		TraceBuffer *buffer = threadTraceBuffer;
+		if (!buffer)
+		{
+			// ÿ̵߳һμ¼ʱ߳˳󻺳ȻʱҪ
+			std::lock_guard<std::mutex> lock(traceBuffersMutex);
+			traceBuffers.emplace_back(new TraceBuffer);
+			buffer = threadTraceBuffer = traceBuffers.back().get();
+			buffer->threadIndex = ThreadIndex();
+		}
+		TraceEvent &e = buffer->events[buffer->count++ % TraceBuffer::Capacity];
+		e.start = start;
+		e.end = end;
+		e.category = (int32_t)p;
+	}
+
+	bool WriteProfilerTrace(const std::string &name)
+	{
+		FILE *fp = fopen(name.c_str(), "w");
+		if (!fp)
+		{
+			fprintf(stderr, "pbrt-lu: %s: unable to open trace file\n", name.c_str());
+			return false;
+		}
+
+		std::lock_guard<std::mutex> lock(traceBuffersMutex);
+		fprintf(fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+		std::vector<bool> named;
+		bool first = true;
+		uint64_t dropped = 0;
+		for (const auto &buffer : traceBuffers)
+		{
+			int tid = buffer->threadIndex;
+			if (tid >= (int)named.size())
+				named.resize(tid + 1, false);
+			if (!named[tid])
+			{
+				named[tid] = true;
+				fprintf(fp, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+					"\"args\":{\"name\":\"%s %d\"}}", first ? "" : ",\n", tid, tid == 0 ? "main" : "worker", tid);
+				first = false;
+			}
+			uint64_t n = std::min<uint64_t>(buffer->count, TraceBuffer::Capacity);
+			dropped += buffer->count - n;
+			for (uint64_t i = buffer->count - n; i < buffer->count; ++i)
+			{
+				const TraceEvent &e = buffer->events[i % TraceBuffer::Capacity];
+				// ʱ䵥λ΢
+				fprintf(fp, ",\n{\"name\":\"%s\",\"cat\":\"pbrt\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,"
+					"\"ts\":%.3f,\"dur\":%.3f}", ProfNames[e.category], tid, e.start * 1e-3,
+					(e.end - e.start) * 1e-3);
+			}
+		}
+		fprintf(fp, "\n]}\n");
+
+		bool ok = !ferror(fp);
+		ok = (fclose(fp) == 0) && ok;
+		if (!ok)
+			fprintf(stderr, "pbrt-lu: %s: error writing trace\n", name.c_str());
+		if (dropped > 0)
+			fprintf(stderr, "pbrt-lu: trace ring buffers overflowed, oldest %llu events dropped\n",
+				(unsigned long long)dropped);
+		return ok;
+	}
+
+
+	// 
+
+	// Խ׶ΪĿŶַϣźŴֻԭӲڴ
+	struct ProfileSample
+	{
+		std::atomic<uint64_t> profilerState{ 0 };
+		std::atomic<uint64_t> count{ 0 };
+	};
+
+	static const int ProfileHashSize = 256;
+	static ProfileSample profileSamples[ProfileHashSize];
+	static std::atomic<uint64_t> profileSamplesOutside{ 0 };   // κν׶
+	static std::atomic<uint64_t> profileSamplesDropped{ 0 };
+	static bool profilerSampling = false;
+	static const int ProfileSamplingHz = 100;
+
+	static inline uint64_t MixBits(uint64_t v)
+	{
+		v ^= (v >> 31);
+		v *= 0x7fb5d329728ea185ull;
+		v ^= (v >> 27);
+		v *= 0x81dadef4bc2dd44dull;
+		v ^= (v >> 33);
+		return v;
+	}
+
+#ifdef PBRT_HAVE_ITIMER
+	static void ReportProfileSample(int, siginfo_t *, void *)
+	{
+		uint64_t state = ProfilerState;
+		if (state == 0)
+		{
+			++profileSamplesOutside;
+			return;
+		}
+		int index = (int)(MixBits(state) % ProfileHashSize);
+		for (int probes = 0; probes < ProfileHashSize; ++probes)
+		{
+			uint64_t expected = 0;
+			ProfileSample &s = profileSamples[index];
+			if (s.profilerState.load(std::memory_order_relaxed) == state ||
+				s.profilerState.compare_exchange_strong(expected, state) || expected == state)
+			{
+				++s.count;
+				return;
+			}
+			if (++index == ProfileHashSize)
+				index = 0;
+		}
+		++profileSamplesDropped;
+	}
+#endif
+
+	void InitProfiler(bool sample, bool trace)
+	{
+		ProfilerTracing = trace;
+		if (!sample)
+			return;
+		for (ProfileSample &s : profileSamples)
+		{
+			s.profilerState = 0;
+			s.count = 0;
+		}
+		profileSamplesOutside = 0;
+		profileSamplesDropped = 0;
+
+#ifdef PBRT_HAVE_ITIMER
+		struct sigaction sa;
+		memset(&sa, 0, sizeof(sa));
+		sa.sa_sigaction = ReportProfileSample;
+		sa.sa_flags = SA_RESTART | SA_SIGINFO;
+		sigemptyset(&sa.sa_mask);
+		sigaction(SIGPROF, &sa, nullptr);
+
+		// ITIMER_PROFĵCPUʱʱź͵е߳
+		struct itimerval timer;
+		timer.it_interval.tv_sec = 0;
+		timer.it_interval.tv_usec = 1000000 / ProfileSamplingHz;
+		timer.it_value = timer.it_interval;
+		if (setitimer(ITIMER_PROF, &timer, nullptr) == 0)
+			profilerSampling = true;
+		else
+			fprintf(stderr, "pbrt-lu: setitimer failed, phase sampling disabled\n");
+#else
+		fprintf(stderr, "pbrt-lu: phase sampling is not supported on this platform\n");
+#endif
+	}
+
+	void CleanupProfiler()
+	{
+#ifdef PBRT_HAVE_ITIMER
+		if (profilerSampling)
+		{
+			struct itimerval timer;
+			memset(&timer, 0, sizeof(timer));
+			setitimer(ITIMER_PROF, &timer, nullptr);
+			signal(SIGPROF, SIG_IGN);
+		}
+#endif
+		profilerSampling = false;
+		ProfilerTracing = false;
+	}
+
+	void ReportProfilerResults(FILE *dest)
+	{
+		uint64_t inclusive[(int)Prof::NumProfCategories] = {};
+		std::vector<std::pair<uint64_t, uint64_t>> states;   // (count, state)
+		uint64_t total = profileSamplesOutside;
+		for (const ProfileSample &s : profileSamples)
+		{
+			uint64_t count = s.count, state = s.profilerState;
+			if (count == 0)
+				continue;
+			total += count;
+			states.push_back(std::make_pair(count, state));
+			for (int c = 0; c < (int)Prof::NumProfCategories; ++c)
+				if (state & ProfToBits((Prof)c))
+					inclusive[c] += count;
+		}
+		if (total == 0)
+			return;
+
+		auto seconds = [](uint64_t count) { return (double)count / ProfileSamplingHz; };
+		fprintf(dest, "Profile (%llu samples, %.2f s CPU)\n", (unsigned long long)total, seconds(total));
+		for (int c = 0; c < (int)Prof::NumProfCategories; ++c)
+		{
+			if (inclusive[c] == 0)
+				continue;
+			fprintf(dest, "    %-40s %6.2f%% (%.2f s)\n", ProfNames[c], 100. * inclusive[c] / total,
+				seconds(inclusive[c]));
+		}
+
+		// ռ׶ϴ⵽ڰö˳г
+		std::sort(states.begin(), states.end(),
+			[](const std::pair<uint64_t, uint64_t> &a, const std::pair<uint64_t, uint64_t> &b) {
+			return a.first > b.first;
+		});
+		fprintf(dest, "  Exclusive\n");
+		for (const auto &s : states)
+		{
+			std::string name;
+			for (int c = 0; c < (int)Prof::NumProfCategories; ++c)
+			{
+				if (!(s.second & ProfToBits((Prof)c)))
+					continue;
+				if (!name.empty())
+					name += " / ";
+				name += ProfNames[c];
+			}
+			fprintf(dest, "    %6.2f%%  %s\n", 100. * s.first / total, name.c_str());
+		}
+		if (profileSamplesOutside > 0)
+			fprintf(dest, "    %6.2f%%  (outside any phase)\n", 100. * profileSamplesOutside / total);
+		if (profileSamplesDropped > 0)
+			fprintf(dest, "    %llu samples dropped, profile hash table full\n",
+				(unsigned long long)profileSamplesDropped);
+	}
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+#include "../pbrt.h"
+
+
+// ׶ڴProfilePhaseǰʲô
+// 1. ÿ߳һλ¼ԼڵĽ׶ΣǶףʱźţSIGPROFCPUʱ䣬100Hz
+//    ʱ±̵߳룬󱨸ÿ׶ռõʱֻ֧POSIX
+// 2. ʱߣȵĽ׶ΣBVHȾһͼдͼȣʱֹʱд
+//    ߳ԼĻλ˸ɵģ󵼳ΪChrome trace event JSON
+//    chrome://tracingPerfetto鿴̵߳ʱߡ
+// ϸȵĽ׶Σÿߵ󽻡ɫȣֲֻֻ̫࣬߳̾λ㡣
+namespace pbrt
+{
+	// ǰNumTracedCategoriesǴȽ׶Σ¼ʱ
+	enum class Prof
+	{
+		SceneConstruction,
+		SceneParsing,
+		AccelConstruction,
+		RenderTile,
+		FilmMerge,
+		ImageWrite,
+
+		SceneIntersect,
+		SceneIntersectP,
+		AccelIntersect,
+		AccelIntersectP,
+		ShapeIntersect,
+		ShapeIntersectP,
+		ComputeSurfaceInteraction,
+		Shading,
+		FilmAddSample,
+		NumProfCategories
+	};
+
+	static const int NumTracedCategories = (int)Prof::SceneIntersect;
+
+	static_assert((int)Prof::NumProfCategories <= 64, "profiler state is a 64-bit mask");
+
+	inline uint64_t ProfToBits(Prof p) { return 1ull << (int)p; }
+
+	const char *ProfName(Prof p);
+
+	// ǰ߳ڵĽ׶
+	extern PBRT_THREAD_LOCAL uint64_t ProfilerState;
+	// InitProfilerãȾв
+	extern bool ProfilerTracing;
+
+	int64_t ProfilerTime();
+	void RecordTraceEvent(Prof p, int64_t start, int64_t end);
+
+	class ProfilePhase
+	{
+	public:
+		explicit ProfilePhase(Prof p) : category(p)
+		{
+			categoryBit = ProfToBits(p);
+			// ͬһ׶Ƕʱֻ㸺
+			reset = (ProfilerState & categoryBit) == 0;
+			ProfilerState |= categoryBit;
+			start = ((int)p < NumTracedCategories && ProfilerTracing) ? ProfilerTime() : -1;
+		}
+
+		~ProfilePhase()
+		{
+			if (reset)
+				ProfilerState &= ~categoryBit;
+			if (start >= 0)
+				RecordTraceEvent(category, start, ProfilerTime());
+		}
+
+		ProfilePhase(const ProfilePhase &) = delete;
+		ProfilePhase &operator=(const ProfilePhase &) = delete;
+
+	private:
+		Prof category;
+		uint64_t categoryBit;
+		bool reset;
+		int64_t start;
+	};
+
+	// sampleΪtrueʱʱtraceΪtrueʱ¼ʱߡȾʼǰ߳ʱ
+	void InitProfiler(bool sample, bool trace);
+	// ֹͣʱ
+	void CleanupProfiler();
+	// ÿ׶εʱǶĽ׶ΣԼֽ׶ϵĶռ
+	void ReportProfilerResults(FILE *dest);
+	// ̻߳λ¼дChrome trace eventʽӦ̶߳ʱ
+	bool WriteProfilerTrace(const std::string &name);
+}
@@ -0,0 +1,79 @@
+#include "raypacket.h"
+#include "primitive.h"
+#include "interaction.h"
+
+#include <algorithm>
+
+
+namespace pbrt
+{
+	void RayStream::Reserve(size_t n)
+	{
+		for (std::vector<Float> *v : { &ox, &oy, &oz, &dx, &dy, &dz, &tMax, &time })
+			v->reserve(n);
+	}
+
+	void RayStream::Clear()
+	{
+		for (std::vector<Float> *v : { &ox, &oy, &oz, &dx, &dy, &dz, &tMax, &time })
+			v->clear();
+	}
+
+	void RayStream::Add(const Ray & r)
+	{
+		ox.push_back(r.o.x);
+		oy.push_back(r.o.y);
+		oz.push_back(r.o.z);
+		dx.push_back(r.d.x);
+		dy.push_back(r.d.y);
+		dz.push_back(r.d.z);
+		tMax.push_back(r.tMax);
+		time.push_back(r.time);
+	}
+
+	void RayStream::LoadPacket(size_t first, RayPacket * packet) const
+	{
+		DCHECK(first < Size());
+		int n = (int)std::min<size_t>(RayPacket::MaxSize, Size() - first);
+		std::copy_n(&ox[first], n, packet->ox);
+		std::copy_n(&oy[first], n, packet->oy);
+		std::copy_n(&oz[first], n, packet->oz);
+		std::copy_n(&dx[first], n, packet->dx);
+		std::copy_n(&dy[first], n, packet->dy);
+		std::copy_n(&dz[first], n, packet->dz);
+		std::copy_n(&tMax[first], n, packet->tMax);
+		std::copy_n(&time[first], n, packet->time);
+		packet->size = n;
+		packet->activeMask = (1u << n) - 1;
+	}
+
+	void RayStream::StorePacket(size_t first, const RayPacket & packet)
+	{
+		std::copy_n(packet.tMax, packet.size, &tMax[first]);
+	}
+
+	void IntersectStream(const Primitive & aggregate, RayStream & stream, SurfaceInteraction * isects, uint8_t * hit)
+	{
+		RayPacket packet;
+		for (size_t first = 0; first < stream.Size(); first += RayPacket::MaxSize)
+		{
+			stream.LoadPacket(first, &packet);
+			uint32_t hitMask = aggregate.IntersectPacket(packet, packet.activeMask, &isects[first]);
+			for (int i = 0; i < packet.size; ++i)
+				hit[first + i] = (hitMask >> i) & 1;
+			stream.StorePacket(first, packet);
+		}
+	}
+
+	void IntersectPStream(const Primitive & aggregate, const RayStream & stream, uint8_t * occluded)
+	{
+		RayPacket packet;
+		for (size_t first = 0; first < stream.Size(); first += RayPacket::MaxSize)
+		{
+			stream.LoadPacket(first, &packet);
+			uint32_t occludedMask = aggregate.IntersectPPacket(packet, packet.activeMask);
+			for (int i = 0; i < packet.size; ++i)
+				occluded[first + i] = (occludedMask >> i) & 1;
+		}
+	}
+}
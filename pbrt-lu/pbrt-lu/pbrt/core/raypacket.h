@@ -0,0 +1,87 @@
+#pragma once
+
+
+#include <cstdint>
+#include <vector>
+
+#include "geometry.h"
+
+
+namespace pbrt
+{
+	class Primitive;
+	class SurfaceInteraction;
+
+	// һߣߡӰߣSoAţٽṹʱһνڵʿԷߡ
+	// activeMaskĵiλʾiǷЧ
+	struct alignas(64) RayPacket
+	{
+		static constexpr int MaxSize = 16;
+
+		Float ox[MaxSize], oy[MaxSize], oz[MaxSize];
+		Float dx[MaxSize], dy[MaxSize], dz[MaxSize];
+		Float tMax[MaxSize];
+		Float time[MaxSize];
+		int size = 0;
+		uint32_t activeMask = 0;
+
+		void SetRay(int i, const Ray &r)
+		{
+			DCHECK(i >= 0 && i < MaxSize);
+			ox[i] = r.o.x; oy[i] = r.o.y; oz[i] = r.o.z;
+			dx[i] = r.d.x; dy[i] = r.d.y; dz[i] = r.d.z;
+			tMax[i] = r.tMax;
+			time[i] = r.time;
+		}
+
+		Ray GetRay(int i) const
+		{
+			DCHECK(i >= 0 && i < size);
+			return Ray(Point3f(ox[i], oy[i], oz[i]), Vector3f(dx[i], dy[i], dz[i]), tMax[i], time[i]);
+		}
+
+		void Add(const Ray &r)
+		{
+			DCHECK(size < MaxSize);
+			SetRay(size, r);
+			activeMask |= 1u << size;
+			++size;
+		}
+	};
+
+
+	// ߣͬSoAţRayPacket::MaxSizeһһ󽻡
+	class RayStream
+	{
+	public:
+		void Reserve(size_t n);
+		void Clear();
+		void Add(const Ray &r);
+		size_t Size() const { return tMax.size(); }
+
+		Ray GetRay(size_t i) const
+		{
+			return Ray(Point3f(ox[i], oy[i], oz[i]), Vector3f(dx[i], dy[i], dz[i]), tMax[i], time[i]);
+		}
+
+		// ȡ[first, first + RayPacket::MaxSize)
+		void LoadPacket(size_t first, RayPacket *packet) const;
+
+		// 󽻺̵tMaxд
+		void StorePacket(size_t first, const RayPacket &packet);
+
+		std::vector<Float> ox, oy, oz;
+		std::vector<Float> dx, dy, dz;
+		std::vector<Float> tMax;
+		std::vector<Float> time;
+	};
+
+
+	// aggregate󽻡isectshitĳȶstream.Size()
+	// е߶ӦtMaxᱻΪ롣
+	void IntersectStream(const Primitive &aggregate, RayStream &stream,
+		SurfaceInteraction *isects, uint8_t *hit);
+
+	void IntersectPStream(const Primitive &aggregate, const RayStream &stream,
+		uint8_t *occluded);
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+
+#include <algorithm>
+#include <cstdint>
+
+#include "../pbrt.h"
+
+
+namespace pbrt
+{
+	// С1float
+	static const Float OneMinusEpsilon = 0.99999994f;
+
+	// PCG32O'Neill, PCG: A Family of Simple Fast Space-Efficient Statistically
+	// Good Algorithms for Random Number Generation״ֻ̬64λ
+	// AdvanceO(log n)ʱnʵʡ
+	class RNG
+	{
+	public:
+		RNG() : state(0x853c49e6748fea9bULL), inc(0xda3e39cb94b95bdbULL) {}
+		RNG(uint64_t sequenceIndex, uint64_t seed) { SetSequence(sequenceIndex, seed); }
+		explicit RNG(uint64_t sequenceIndex) { SetSequence(sequenceIndex); }
+
+		// ͬsequenceIndexص
+		void SetSequence(uint64_t sequenceIndex, uint64_t seed)
+		{
+			state = 0u;
+			inc = (sequenceIndex << 1u) | 1u;
+			UniformUInt32();
+			state += seed;
+			UniformUInt32();
+		}
+		void SetSequence(uint64_t sequenceIndex) { SetSequence(sequenceIndex, MixBits(sequenceIndex)); }
+
+		uint32_t UniformUInt32()
+		{
+			uint64_t oldState = state;
+			state = oldState * PCG32_MULT + inc;
+			uint32_t xorShifted = (uint32_t)(((oldState >> 18u) ^ oldState) >> 27u);
+			uint32_t rot = (uint32_t)(oldState >> 59u);
+			return (xorShifted >> rot) | (xorShifted << ((~rot + 1u) & 31));
+		}
+
+		// [0, b)ϵľȷֲûȡģƫ
+		uint32_t UniformUInt32(uint32_t b)
+		{
+			uint32_t threshold = (~b + 1u) % b;
+			while (true)
+			{
+				uint32_t r = UniformUInt32();
+				if (r >= threshold)
+					return r % b;
+			}
+		}
+
+		// [0, 1)ϵľȷֲ
+		Float UniformFloat()
+		{
+			return std::min(OneMinusEpsilon, Float(UniformUInt32() * 2.3283064365386963e-10f));
+		}
+
+		// deltadelta2^64ȡģΪ""
+		void Advance(int64_t idelta)
+		{
+			uint64_t curMult = PCG32_MULT, curPlus = inc, accMult = 1u;
+			uint64_t accPlus = 0u, delta = (uint64_t)idelta;
+			while (delta > 0)
+			{
+				if (delta & 1)
+				{
+					accMult *= curMult;
+					accPlus = accPlus * curMult + curPlus;
+				}
+				curPlus = (curMult + 1) * curPlus;
+				curMult *= curMult;
+				delta /= 2;
+			}
+			state = accMult * state + accPlus;
+		}
+
+		static uint64_t MixBits(uint64_t v)
+		{
+			v ^= (v >> 31);
+			v *= 0x7fb5d329728ea185ULL;
+			v ^= (v >> 27);
+			v *= 0x81dadef4bc2dd44dULL;
+			v ^= (v >> 33);
+			return v;
+		}
+
+	private:
+		static const uint64_t PCG32_MULT = 0x5851f42d4c957f2dULL;
+
+		uint64_t state, inc;
+	};
+}
@@ -0,0 +1,23 @@
+#include "sampler.h"
+
+
+namespace pbrt
+{
+	Sampler::~Sampler()
+	{
+	}
+
+	void Sampler::GeneratePixel2DBatch(const Bounds2i & tile, int64_t sampleIndex, Float * u, Float * v)
+	{
+		for (int y = tile.pMin.y; y < tile.pMax.y; ++y)
+		{
+			for (int x = tile.pMin.x; x < tile.pMax.x; ++x)
+			{
+				StartPixelSample(Point2i(x, y), sampleIndex);
+				Point2f uv = GetPixel2D();
+				*u++ = uv.x;
+				*v++ = uv.y;
+			}
+		}
+	}
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+
+#include <memory>
+
+#include "geometry.h"
+
+
+namespace pbrt
+{
+	// pĵsampleIndexڸάϵꡣ
+	// в֧O(1)ʣStartPixelSample֮õֻ(p, sampleIndex, ά)
+	// ˳̺߳ͿĻֶ޹أκ߳Ⱦκһ鶼õͬͼ
+	// ǰάڵλã֮άGet1D/Get2Dȡ
+	// ¼ǰءάȣỵ̈߳ÿ飩CloneõԼһݣԤõıڸ乲
+	class Sampler
+	{
+	public:
+		virtual ~Sampler();
+
+		virtual void StartPixelSample(const Point2i &p, int64_t sampleIndex, int dimension = 0) = 0;
+		virtual Float Get1D() = 0;
+		virtual Point2f Get2D() = 0;
+		// ڵλã[0, 1)^2ǰάStartPixelSample֮һ
+		virtual Point2f GetPixel2D() { return Get2D(); }
+
+		// һأȣԵsampleIndexλãֱдuvtile.Area()
+		// صStartPixelSampleGetPixel2DȫͬĬʵ־ã
+		// SIMDһɶص
+		virtual void GeneratePixel2DBatch(const Bounds2i &tile, int64_t sampleIndex, Float *u, Float *v);
+
+		virtual std::unique_ptr<Sampler> Clone() const = 0;
+	};
+}
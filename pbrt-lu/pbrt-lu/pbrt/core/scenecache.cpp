@@ -0,0 +1,601 @@
+#include "scenecache.h"
+#include "profile.h"
+#include "stats.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <type_traits>
+#include <unordered_map>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+
+namespace pbrt
+{
+	STAT_COUNTER("Scene cache/Shapes loaded", nCachedShapes);
+	STAT_COUNTER("Scene cache/Instances loaded", nCachedInstances);
+
+	// 任ֱָӳļTransformûб
+	static_assert(sizeof(Transform) == 2 * sizeof(Matrix4x4) && std::is_trivially_copyable<Transform>::value,
+		"Transform must be two plain matrices to be mapped from the scene cache");
+
+	static const char SceneCacheMagic[8] = { 'P', 'B', 'R', 'T', 'L', 'U', 'S', 'C' };
+	static const uint32_t SceneCacheVersion = 1;
+	static const uint32_t ByteOrderMark = 0x01020304;
+	// ӳʼַҳ룬ÿٰ32ֽڶ룬LinearBVHNodeֱʹ
+	static const uint64_t SectionAlignment = 32;
+
+	namespace
+	{
+		// ļһ飺ļͷƫƺԪظ
+		struct Section
+		{
+			uint64_t offset, count;
+		};
+
+		enum ShapeType : uint32_t { TriangleMeshType = 0, SphereType = 1 };
+
+		struct SceneCacheHeader
+		{
+			char magic[8];
+			uint32_t version, byteOrder;
+			// ݲ֣͵ǰһʱ治
+			uint32_t headerSize, floatSize, transformSize, bvhNodeSize, triangleGroupSize, triangleGroupWidth;
+			uint64_t fileSize;
+			Section transforms;        // Transform
+			Section shapes;            // ShapeRecord
+			Section prototypes;        // PrototypeRecord
+			Section prototypeShapes;   // int32_tÿԭͰҶ˳״±
+			Section instances;         // InstanceRecordҶ˳򣬰ԭ͵ĵλʵ
+			Section instanceNodes;     // LinearBVHNode
+			int32_t worldPrototype;
+			int32_t cameraTransform;   // -1ʾû
+			float fov;
+			uint32_t pad;
+		};
+
+		struct ShapeRecord
+		{
+			uint32_t type;
+			uint32_t reverseOrientation;
+			// ռĶݺBVH
+			int32_t nTriangles, nVertices;
+			uint32_t transformSwapsHandedness, pad;
+			Section indices, p, n, uv, nodes, groups;
+			// 򣺱任±͹
+			int32_t objectToWorld, worldToObject;
+			float radius, zMin, zMax, phiMax;
+		};
+
+		// nodesΪʱԭֻһ״
+		struct PrototypeRecord
+		{
+			Section shapes, nodes;
+		};
+
+		struct InstanceRecord
+		{
+			int32_t instanceToWorld, worldToInstance, prototype;
+		};
+
+
+		// ˳дļÿǰ
+		class CacheWriter
+		{
+		public:
+			explicit CacheWriter(FILE *fp) : fp(fp) {}
+
+			template <typename T>
+			Section Write(const T *data, size_t count)
+			{
+				Align();
+				Section s = { pos, count };
+				if (count > 0 && fwrite(data, sizeof(T), count, fp) != count)
+					ok = false;
+				pos += count * sizeof(T);
+				return s;
+			}
+
+			void Align()
+			{
+				static const char zeros[SectionAlignment] = {};
+				size_t pad = (size_t)((SectionAlignment - pos % SectionAlignment) % SectionAlignment);
+				if (pad > 0 && fwrite(zeros, 1, pad, fp) != pad)
+					ok = false;
+				pos += pad;
+			}
+
+			FILE *fp;
+			uint64_t pos = 0;
+			bool ok = true;
+		};
+	}
+
+
+	int64_t SceneGeometry::PrimitiveCount() const
+	{
+		int64_t count = 0;
+		for (const ShapeEntry &shape : shapes)
+			count += shape.mesh ? shape.mesh->GetMesh()->nTriangles : 1;
+		if (instanceAccel)
+			count += instanceAccel->NumInstances();
+		return count;
+	}
+
+	size_t SceneGeometry::BytesUsed() const
+	{
+		size_t bytes = 0;
+		for (const ShapeEntry &shape : shapes)
+			bytes += shape.mesh ? shape.mesh->GetMesh()->BytesUsed() + shape.mesh->BytesUsed() : sizeof(Sphere);
+		for (const Prototype &prototype : prototypes)
+			if (prototype.bvh)
+				bytes += prototype.bvh->GetNodes().BytesUsed();
+		if (instanceAccel)
+			bytes += instanceAccel->BytesUsed();
+		return bytes;
+	}
+
+
+	void BuildSceneAggregates(SceneGeometry * geometry, TransformCache * transformCache, AccelType accel)
+	{
+		ProfilePhase _(Prof::AccelConstruction);
+		for (SceneGeometry::ShapeEntry &shape : geometry->shapes)
+		{
+			if (shape.mesh)
+				shape.primitive = std::make_shared<GeometricPrimitive>(shape.mesh);
+			else
+				shape.primitive = std::make_shared<GeometricPrimitive>(shape.sphere);
+		}
+
+		std::vector<std::shared_ptr<Primitive>> prototypeAggregates;
+		for (SceneGeometry::Prototype &prototype : geometry->prototypes)
+		{
+			if (prototype.shapes.size() == 1)
+				prototype.aggregate = geometry->shapes[prototype.shapes[0]].primitive;
+			else
+			{
+				std::vector<std::shared_ptr<Primitive>> prims;
+				for (int shape : prototype.shapes)
+					prims.push_back(geometry->shapes[shape].primitive);
+				prototype.aggregate = CreateAccel(accel, std::move(prims), &prototype.buildStats);
+				prototype.bvh = std::dynamic_pointer_cast<BVHAccel>(prototype.aggregate);
+			}
+			prototypeAggregates.push_back(prototype.aggregate);
+		}
+
+		if (geometry->instances.empty())
+		{
+			if (geometry->worldPrototype >= 0)
+				geometry->aggregate = geometry->prototypes[geometry->worldPrototype].aggregate;
+			return;
+		}
+
+		// ״Եλ任Ϊһʵ
+		std::vector<Instance> instances = geometry->instances;
+		if (geometry->worldPrototype >= 0)
+		{
+			Instance instance;
+			transformCache->Lookup(Transform(), &instance.InstanceToWorld, &instance.WorldToInstance);
+			instance.prototype = geometry->worldPrototype;
+			instances.push_back(instance);
+		}
+		geometry->instanceAccel = std::make_shared<InstanceAccel>(std::move(prototypeAggregates), std::move(instances));
+		geometry->aggregate = geometry->instanceAccel;
+	}
+
+
+	bool WriteSceneCache(const std::string & filename, const SceneGeometry & geometry)
+	{
+		for (const SceneGeometry::Prototype &prototype : geometry.prototypes)
+		{
+			if (prototype.shapes.size() > 1 && !prototype.bvh)
+			{
+				fprintf(stderr, "%s: scene caches can only store BVHAccel nodes\n", filename.c_str());
+				return false;
+			}
+		}
+
+		// 任ȥأTransformCacheͬľֻһָ
+		std::vector<Transform> transforms;
+		std::unordered_map<const Transform *, int> transformIndex;
+		auto indexOf = [&](const Transform *t) {
+			auto it = transformIndex.find(t);
+			if (it != transformIndex.end())
+				return it->second;
+			transforms.push_back(*t);
+			return transformIndex[t] = (int)transforms.size() - 1;
+		};
+
+		std::unordered_map<const Primitive *, int> shapeOfPrimitive;
+		for (size_t i = 0; i < geometry.shapes.size(); ++i)
+			shapeOfPrimitive[geometry.shapes[i].primitive.get()] = (int)i;
+
+		std::string tempName = filename + ".tmp";
+		FILE *fp = fopen(tempName.c_str(), "wb");
+		if (!fp)
+		{
+			fprintf(stderr, "%s: unable to open file for writing\n", tempName.c_str());
+			return false;
+		}
+		CacheWriter w(fp);
+		SceneCacheHeader header;
+		memset(&header, 0, sizeof(header));
+		w.Write(&header, 1);
+
+		// ݺBVH
+		std::vector<ShapeRecord> shapeRecords(geometry.shapes.size());
+		for (size_t i = 0; i < geometry.shapes.size(); ++i)
+		{
+			const SceneGeometry::ShapeEntry &shape = geometry.shapes[i];
+			ShapeRecord &r = shapeRecords[i];
+			memset(&r, 0, sizeof(r));
+			r.objectToWorld = r.worldToObject = -1;
+			if (shape.mesh)
+			{
+				const TriangleMesh &mesh = *shape.mesh->GetMesh();
+				r.type = TriangleMeshType;
+				// TriangleMeshShape任ԺϲreverseOrientationﻹԭɹʱĲ
+				r.reverseOrientation = shape.mesh->reverseOrientation ^ mesh.transformSwapsHandedness;
+				r.transformSwapsHandedness = mesh.transformSwapsHandedness;
+				r.nTriangles = mesh.nTriangles;
+				r.nVertices = mesh.nVertices;
+				r.indices = w.Write(mesh.vertexIndices, 3 * (size_t)mesh.nTriangles);
+				r.p = w.Write(mesh.p, mesh.nVertices);
+				r.n = w.Write(mesh.n, mesh.n ? mesh.nVertices : 0);
+				r.uv = w.Write(mesh.uv, mesh.uv ? mesh.nVertices : 0);
+				r.nodes = w.Write(shape.mesh->GetNodes().data(), shape.mesh->GetNodes().size());
+				r.groups = w.Write(shape.mesh->GetGroups().data(), shape.mesh->GetGroups().size());
+			}
+			else
+			{
+				r.type = SphereType;
+				r.reverseOrientation = shape.sphere->reverseOrientation;
+				r.objectToWorld = indexOf(shape.sphere->ObjectToWorld);
+				r.worldToObject = indexOf(shape.sphere->WorldToObject);
+				r.radius = shape.radius;
+				r.zMin = shape.zMin;
+				r.zMax = shape.zMax;
+				r.phiMax = shape.phiMax;
+			}
+		}
+
+		// ԭͣBVHAccelͼԪѾҶ˳򣬻״±
+		std::vector<PrototypeRecord> prototypeRecords(geometry.prototypes.size());
+		std::vector<int32_t> prototypeShapes;
+		for (size_t i = 0; i < geometry.prototypes.size(); ++i)
+		{
+			const SceneGeometry::Prototype &prototype = geometry.prototypes[i];
+			PrototypeRecord &r = prototypeRecords[i];
+			r.shapes.offset = prototypeShapes.size();
+			if (prototype.bvh)
+			{
+				for (const std::shared_ptr<Primitive> &prim : prototype.bvh->GetPrimitives())
+					prototypeShapes.push_back(shapeOfPrimitive[prim.get()]);
+				r.nodes = w.Write(prototype.bvh->GetNodes().data(), prototype.bvh->GetNodes().size());
+			}
+			else
+			{
+				prototypeShapes.push_back(prototype.shapes[0]);
+				r.nodes.offset = r.nodes.count = 0;
+			}
+			r.shapes.count = prototypeShapes.size() - r.shapes.offset;
+		}
+
+		std::vector<InstanceRecord> instanceRecords;
+		if (geometry.instanceAccel)
+		{
+			for (const Instance &instance : geometry.instanceAccel->GetInstances())
+				instanceRecords.push_back(InstanceRecord{ indexOf(instance.InstanceToWorld),
+					indexOf(instance.WorldToInstance), instance.prototype });
+			header.instanceNodes = w.Write(geometry.instanceAccel->GetNodes().data(),
+				geometry.instanceAccel->GetNodes().size());
+		}
+
+		header.cameraTransform = -1;
+		if (geometry.hasCamera)
+		{
+			transforms.push_back(geometry.cameraToWorld);
+			header.cameraTransform = (int32_t)transforms.size() - 1;
+		}
+		header.fov = geometry.fov;
+		header.worldPrototype = geometry.worldPrototype;
+
+		// Сԭ͵״ƫ֮ǰprototypeShapes±
+		header.transforms = w.Write(transforms.data(), transforms.size());
+		header.shapes = w.Write(shapeRecords.data(), shapeRecords.size());
+		header.prototypes = w.Write(prototypeRecords.data(), prototypeRecords.size());
+		header.prototypeShapes = w.Write(prototypeShapes.data(), prototypeShapes.size());
+		header.instances = w.Write(instanceRecords.data(), instanceRecords.size());
+		w.Align();
+
+		memcpy(header.magic, SceneCacheMagic, sizeof(header.magic));
+		header.version = SceneCacheVersion;
+		header.byteOrder = ByteOrderMark;
+		header.headerSize = sizeof(SceneCacheHeader);
+		header.floatSize = sizeof(Float);
+		header.transformSize = sizeof(Transform);
+		header.bvhNodeSize = sizeof(LinearBVHNode);
+		header.triangleGroupSize = sizeof(TriangleGroup<TriangleGroupWidth>);
+		header.triangleGroupWidth = TriangleGroupWidth;
+		header.fileSize = w.pos;
+		rewind(fp);
+		if (fwrite(&header, sizeof(header), 1, fp) != 1)
+			w.ok = false;
+		if (fclose(fp) != 0)
+			w.ok = false;
+		if (!w.ok)
+		{
+			fprintf(stderr, "%s: error writing scene cache\n", tempName.c_str());
+			remove(tempName.c_str());
+			return false;
+		}
+#ifdef _WIN32
+		// WindowsrenameܸеļPOSIXrenameԭӵ滻ļ߲ῴʧ
+		remove(filename.c_str());
+#endif
+		if (rename(tempName.c_str(), filename.c_str()) != 0)
+		{
+			fprintf(stderr, "%s: unable to rename to %s\n", tempName.c_str(), filename.c_str());
+			return false;
+		}
+		return true;
+	}
+
+
+	bool IsSceneCacheFile(const std::string & filename)
+	{
+		// ֮ܵļһξûˣֻǳļ
+		struct stat st;
+		if (stat(filename.c_str(), &st) != 0 || (st.st_mode & S_IFMT) != S_IFREG)
+			return false;
+		FILE *fp = fopen(filename.c_str(), "rb");
+		if (!fp)
+			return false;
+		char magic[sizeof(SceneCacheMagic)];
+		bool isCache = fread(magic, 1, sizeof(magic), fp) == sizeof(magic) &&
+			memcmp(magic, SceneCacheMagic, sizeof(magic)) == 0;
+		fclose(fp);
+		return isCache;
+	}
+
+
+	namespace
+	{
+		// ļΧڲҶ룬Լ±겻Խ硣
+		// ÿֻɨһΣ֮󽻺ͱ߽
+		class CacheReader
+		{
+		public:
+			CacheReader(const std::string &filename, const std::shared_ptr<MappedFile> &file)
+				: filename(filename), file(file)
+			{
+			}
+
+			template <typename T>
+			bool Get(const Section &s, const T **data, const char *what)
+			{
+				*data = nullptr;
+				if (s.count == 0)
+					return true;
+				if (s.offset % SectionAlignment != 0 || s.offset > file->Size() ||
+					s.count > (file->Size() - s.offset) / sizeof(T))
+					return Error(what);
+				*data = reinterpret_cast<const T *>(file->Data() + s.offset);
+				return true;
+			}
+
+			// ڲڵӶ沢ڣҶӵ[primitivesOffset, + nPrimitives)nItemsڣ
+			// Ȳջ64㡣ڵںǰ棬ɨһڵʱѾȷ
+			bool CheckNodes(const LinearBVHNode *nodes, const Section &s, uint64_t nItems, const char *what)
+			{
+				std::vector<uint8_t> depth((size_t)s.count, 0);
+				for (uint64_t i = 0; i < s.count; ++i)
+				{
+					const LinearBVHNode &node = nodes[i];
+					if (node.nPrimitives > 0)
+					{
+						if (node.primitivesOffset < 0 || (uint64_t)node.primitivesOffset + node.nPrimitives > nItems)
+							return Error(what);
+						continue;
+					}
+					if (node.axis > 2 || depth[i] >= 64 || i + 1 >= s.count || node.secondChildOffset < 0 ||
+						(uint64_t)node.secondChildOffset <= i + 1 || (uint64_t)node.secondChildOffset >= s.count)
+						return Error(what);
+					uint8_t childDepth = depth[i] + 1;
+					depth[i + 1] = std::max(depth[i + 1], childDepth);
+					depth[node.secondChildOffset] = std::max(depth[node.secondChildOffset], childDepth);
+				}
+				return true;
+			}
+
+			template <typename T>
+			ReadOnlyArray<T> Array(const T *data, const Section &s)
+			{
+				return ReadOnlyArray<T>(data, (size_t)s.count, file);
+			}
+
+			bool Error(const char *what)
+			{
+				fprintf(stderr, "%s: corrupt scene cache (%s)\n", filename.c_str(), what);
+				return false;
+			}
+
+			const std::string &filename;
+			std::shared_ptr<MappedFile> file;
+		};
+	}
+
+	bool ReadSceneCache(const std::string & filename, SceneGeometry * geometry)
+	{
+		ProfilePhase _(Prof::SceneParsing);
+		std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>();
+		if (!file->Open(filename))
+			return false;
+		CacheReader reader(filename, file);
+
+		SceneCacheHeader header;
+		if (file->Size() < sizeof(header) || memcmp(file->Data(), SceneCacheMagic, sizeof(SceneCacheMagic)) != 0)
+		{
+			fprintf(stderr, "%s: not a scene cache\n", filename.c_str());
+			return false;
+		}
+		memcpy(&header, file->Data(), sizeof(header));
+		if (header.version != SceneCacheVersion || header.byteOrder != ByteOrderMark ||
+			header.headerSize != sizeof(SceneCacheHeader) || header.floatSize != sizeof(Float) ||
+			header.transformSize != sizeof(Transform) || header.bvhNodeSize != sizeof(LinearBVHNode) ||
+			header.triangleGroupSize != sizeof(TriangleGroup<TriangleGroupWidth>) ||
+			header.triangleGroupWidth != TriangleGroupWidth)
+		{
+			fprintf(stderr, "%s: scene cache was written by an incompatible build (version %u, "
+				"triangle group width %u); rebuild it from the scene file\n", filename.c_str(), header.version,
+				header.triangleGroupWidth);
+			return false;
+		}
+		if (header.fileSize != file->Size())
+			return reader.Error("file size does not match, the file is truncated");
+
+		const Transform *transforms;
+		const ShapeRecord *shapeRecords;
+		const PrototypeRecord *prototypeRecords;
+		const int32_t *prototypeShapes;
+		const InstanceRecord *instanceRecords;
+		const LinearBVHNode *instanceNodes;
+		if (!reader.Get(header.transforms, &transforms, "transforms") ||
+			!reader.Get(header.shapes, &shapeRecords, "shapes") ||
+			!reader.Get(header.prototypes, &prototypeRecords, "prototypes") ||
+			!reader.Get(header.prototypeShapes, &prototypeShapes, "prototype shapes") ||
+			!reader.Get(header.instances, &instanceRecords, "instances") ||
+			!reader.Get(header.instanceNodes, &instanceNodes, "instance nodes"))
+			return false;
+		const uint64_t nTransforms = header.transforms.count;
+		auto validTransform = [&](int32_t i) { return i >= 0 && (uint64_t)i < nTransforms; };
+
+		*geometry = SceneGeometry();
+		geometry->cacheFile = file;
+		geometry->shapes.resize((size_t)header.shapes.count);
+		for (size_t i = 0; i < geometry->shapes.size(); ++i)
+		{
+			const ShapeRecord &r = shapeRecords[i];
+			SceneGeometry::ShapeEntry &shape = geometry->shapes[i];
+			if (r.type == TriangleMeshType)
+			{
+				const int *indices;
+				const Point3f *p;
+				const Normal3f *n;
+				const Point2f *uv;
+				const LinearBVHNode *nodes;
+				const TriangleGroup<TriangleGroupWidth> *groups;
+				if (!reader.Get(r.indices, &indices, "mesh indices") || !reader.Get(r.p, &p, "mesh positions") ||
+					!reader.Get(r.n, &n, "mesh normals") || !reader.Get(r.uv, &uv, "mesh uvs") ||
+					!reader.Get(r.nodes, &nodes, "mesh BVH nodes") || !reader.Get(r.groups, &groups, "mesh triangle groups"))
+					return false;
+				if (r.nTriangles < 0 || r.nVertices < 0 || r.indices.count != 3 * (uint64_t)r.nTriangles ||
+					r.p.count != (uint64_t)r.nVertices || (n && r.n.count != r.p.count) || (uv && r.uv.count != r.p.count))
+					return reader.Error("mesh sizes");
+				for (uint64_t j = 0; j < r.indices.count; ++j)
+					if (indices[j] < 0 || indices[j] >= r.nVertices)
+						return reader.Error("mesh vertex index");
+				for (uint64_t j = 0; j < r.groups.count; ++j)
+					for (int k = 0; k < TriangleGroupWidth; ++k)
+						if (groups[j].faceIndex[k] < 0 || groups[j].faceIndex[k] >= r.nTriangles)
+							return reader.Error("mesh triangle group face index");
+				if (!reader.CheckNodes(nodes, r.nodes, r.groups.count, "mesh BVH nodes"))
+					return false;
+				auto mesh = std::make_shared<TriangleMesh>(r.nTriangles, indices, r.nVertices, p, n, uv,
+					r.transformSwapsHandedness != 0, file);
+				shape.mesh = std::make_shared<TriangleMeshShape>(mesh, r.reverseOrientation != 0,
+					reader.Array(nodes, r.nodes), reader.Array(groups, r.groups));
+				shape.primitive = std::make_shared<GeometricPrimitive>(shape.mesh);
+			}
+			else if (r.type == SphereType)
+			{
+				if (!validTransform(r.objectToWorld) || !validTransform(r.worldToObject))
+					return reader.Error("sphere transform");
+				shape.radius = r.radius;
+				shape.zMin = r.zMin;
+				shape.zMax = r.zMax;
+				shape.phiMax = r.phiMax;
+				shape.sphere = std::make_shared<Sphere>(&transforms[r.objectToWorld], &transforms[r.worldToObject],
+					r.reverseOrientation != 0, r.radius, r.zMin, r.zMax, r.phiMax);
+				shape.primitive = std::make_shared<GeometricPrimitive>(shape.sphere);
+			}
+			else
+				return reader.Error("shape type");
+		}
+		nCachedShapes += (int64_t)geometry->shapes.size();
+
+		std::vector<std::shared_ptr<Primitive>> prototypeAggregates;
+		geometry->prototypes.resize((size_t)header.prototypes.count);
+		for (size_t i = 0; i < geometry->prototypes.size(); ++i)
+		{
+			const PrototypeRecord &r = prototypeRecords[i];
+			SceneGeometry::Prototype &prototype = geometry->prototypes[i];
+			if (r.shapes.count == 0 || r.shapes.offset > header.prototypeShapes.count ||
+				r.shapes.count > header.prototypeShapes.count - r.shapes.offset)
+				return reader.Error("prototype shapes");
+			std::vector<std::shared_ptr<Primitive>> prims;
+			for (uint64_t j = r.shapes.offset; j < r.shapes.offset + r.shapes.count; ++j)
+			{
+				int32_t shape = prototypeShapes[j];
+				if (shape < 0 || (size_t)shape >= geometry->shapes.size())
+					return reader.Error("prototype shape index");
+				prototype.shapes.push_back(shape);
+				prims.push_back(geometry->shapes[shape].primitive);
+			}
+			const LinearBVHNode *nodes;
+			if (!reader.Get(r.nodes, &nodes, "prototype BVH nodes") ||
+				!reader.CheckNodes(nodes, r.nodes, r.shapes.count, "prototype BVH nodes"))
+				return false;
+			if (nodes)
+			{
+				prototype.bvh = std::make_shared<BVHAccel>(std::move(prims), reader.Array(nodes, r.nodes));
+				prototype.aggregate = prototype.bvh;
+				prototype.buildStats = &prototype.bvh->GetBuildStats();
+			}
+			else if (prims.size() == 1)
+				prototype.aggregate = prims[0];
+			else
+				return reader.Error("prototype without BVH");
+			prototypeAggregates.push_back(prototype.aggregate);
+		}
+		if (header.worldPrototype < -1 || header.worldPrototype >= (int32_t)geometry->prototypes.size())
+			return reader.Error("world prototype");
+		geometry->worldPrototype = header.worldPrototype;
+
+		if (header.instances.count > 0)
+		{
+			// ΨһҪתݣʵ¼任±껻ָӳڴָ
+			std::vector<Instance> instances((size_t)header.instances.count);
+			for (size_t i = 0; i < instances.size(); ++i)
+			{
+				const InstanceRecord &r = instanceRecords[i];
+				if (!validTransform(r.instanceToWorld) || !validTransform(r.worldToInstance) ||
+					r.prototype < 0 || r.prototype >= (int32_t)geometry->prototypes.size())
+					return reader.Error("instance");
+				instances[i].InstanceToWorld = &transforms[r.instanceToWorld];
+				instances[i].WorldToInstance = &transforms[r.worldToInstance];
+				instances[i].prototype = r.prototype;
+			}
+			if (!reader.CheckNodes(instanceNodes, header.instanceNodes, header.instances.count, "instance nodes"))
+				return false;
+			nCachedInstances += (int64_t)instances.size();
+			geometry->instanceAccel = std::make_shared<InstanceAccel>(std::move(prototypeAggregates),
+				std::move(instances), reader.Array(instanceNodes, header.instanceNodes));
+			geometry->aggregate = geometry->instanceAccel;
+		}
+		else if (geometry->worldPrototype >= 0)
+			geometry->aggregate = geometry->prototypes[geometry->worldPrototype].aggregate;
+
+		if (header.cameraTransform >= 0)
+		{
+			if (!validTransform(header.cameraTransform))
+				return reader.Error("camera transform");
+			geometry->hasCamera = true;
+			geometry->cameraToWorld = transforms[header.cameraTransform];
+			geometry->fov = header.fov;
+		}
+		return true;
+	}
+}
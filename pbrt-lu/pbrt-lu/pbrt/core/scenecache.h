@@ -0,0 +1,88 @@
+#pragma once
+
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "parser.h"
+#include "transform.h"
+#include "transformcache.h"
+#include "../accelerators/bvh.h"
+#include "../accelerators/instance.h"
+#include "../accelerators/widebvh.h"
+#include "../shapes/sphere.h"
+#include "../shapes/triangle.h"
+
+
+// 棺ѹõĳΣ״ݡȥغı任͸BVHдһļ
+// ļֻļͷƫƣָ룬鶼32ֽڶ룻ʱļmmap
+// BVHڵ㡢ͱ任ֱָӳڴ棬ƣؽҲҪָ롣
+// ֻʵҪѱ任±껻ָ룬һԵĸơ
+// ʱԴ±飨±ꡢ顢BVHڵ㣩ɨһ飬±겻Խ磬𻵵ļ
+// ñ档ꡢߵݵҳڵһα߷ʱŶ롣
+//
+// ļͷ¼汾ֽԼFloatBVHڵ㡢TransformĴС
+// ͵ǰһ£SSEAVXĳȲͬʱܾء
+namespace pbrt
+{
+	// ΡӳļʱshapesprototypesinstancesٵBuildSceneAggregates
+	// ӻʱReadSceneCacheֱӸõĽṹ
+	struct SceneGeometry
+	{
+		// ״ֻ֧meshsphereֻһΪ
+		struct ShapeEntry
+		{
+			std::shared_ptr<TriangleMeshShape> mesh;
+			std::shared_ptr<Sphere> sphere;
+			// õĲphiMaxΪȣԭд棬ʱͬĲ죬λͬ
+			Float radius = 0, zMin = 0, zMax = 0, phiMax = 0;
+			std::shared_ptr<Primitive> primitive;
+		};
+
+		// ԭͣһ״һʱһBVHĬBVHAccelҲQBVH/OBVHʱbvhΪգ
+		// κζ״ҲһԭͣworldPrototype
+		struct Prototype
+		{
+			std::vector<int> shapes;
+			std::shared_ptr<BVHAccel> bvh;
+			std::shared_ptr<Primitive> aggregate;
+			const BVHBuildStats *buildStats = nullptr;   // ֻһ״ʱΪ
+		};
+
+		std::vector<ShapeEntry> shapes;
+		std::vector<Prototype> prototypes;
+		int worldPrototype = -1;
+		// ʵı任TransformCacheworldPrototypeṹʱԵλ任
+		std::vector<Instance> instances;
+
+		// õĽṹʵʱInstanceAccelworldPrototypeaggregate
+		std::shared_ptr<InstanceAccel> instanceAccel;
+		std::shared_ptr<Primitive> aggregate;
+
+		bool hasCamera = false;
+		Transform cameraToWorld;
+		Float fov = 90;
+
+		// ӻʱӳ䣬ṹͨReadOnlyArrayͬ
+		std::shared_ptr<MappedFile> cacheFile;
+
+		int64_t PrimitiveCount() const;
+		// ״ͼٽṹӻʱӳĲ
+		size_t BytesUsed() const;
+	};
+
+	// ΪÿԭͽͼԪaccel͵BVHʵʱٽInstanceAccel
+	void BuildSceneAggregates(SceneGeometry *geometry, TransformCache *transformCache,
+		AccelType accel = AccelType::BVH);
+
+	// дʱļɺٸ;ʧܲ²Ļ档
+	// ֻܴBVHAccelĽڵ㣬ԭQBVH/OBVHĳд
+	bool WriteSceneCache(const std::string &filename, const SceneGeometry &geometry);
+
+	// ͨļԳıǿͷಿ֣
+	bool IsSceneCacheFile(const std::string &filename);
+
+	// ʧʱļ汾ݲֲԭ򲢷false
+	bool ReadSceneCache(const std::string &filename, SceneGeometry *geometry);
+}
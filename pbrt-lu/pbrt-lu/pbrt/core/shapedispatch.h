@@ -0,0 +1,160 @@
+#pragma once
+
+
+#include <memory>
+#include <vector>
+
+#include "interaction.h"
+#include "primitive.h"
+#include "profile.h"
+#include "raypacket.h"
+#include "stats.h"
+#include "../shapes/sphere.h"
+#include "../shapes/spherecloud.h"
+#include "../shapes/triangle.h"
+
+
+// ShapeHandlePrimitiveHandleGeometricPrimitive汾Ķ塣
+// Ҫȫ״Ķ壬ֻڼٽṹprimitive.cppЩڲѭڵ.cpp
+// ״඼finalģptr->IntersectHit(...)ĵòֱͨӵá
+namespace pbrt
+{
+	STAT_EXTERN_PERCENT(nShapeHits, nShapeTests);
+	STAT_EXTERN_PERCENT(nShapePHits, nShapePTests);
+
+	inline ShapeHandle ShapeHandle::FromShape(const Shape *shape)
+	{
+		// ֻڹʱһ
+		if (const Sphere *sphere = dynamic_cast<const Sphere *>(shape))
+			return sphere;
+		if (const TriangleMeshShape *mesh = dynamic_cast<const TriangleMeshShape *>(shape))
+			return mesh;
+		if (const SphereCloud *cloud = dynamic_cast<const SphereCloud *>(shape))
+			return cloud;
+		return nullptr;
+	}
+
+	inline Bounds3f ShapeHandle::ObjectBound() const
+	{
+		return Dispatch([&](auto ptr) { return ptr->ObjectBound(); });
+	}
+
+	inline Bounds3f ShapeHandle::WorldBound() const
+	{
+		return Dispatch([&](auto ptr) { return ptr->WorldBound(); });
+	}
+
+	inline Float ShapeHandle::Area() const
+	{
+		return Dispatch([&](auto ptr) { return ptr->Area(); });
+	}
+
+	inline bool ShapeHandle::IntersectP(const Ray & ray) const
+	{
+		return Dispatch([&](auto ptr) { return ptr->IntersectP(ray); });
+	}
+
+	inline bool ShapeHandle::IntersectHit(const Ray & ray, SurfaceHit * hit) const
+	{
+		return Dispatch([&](auto ptr) { return ptr->IntersectHit(ray, hit); });
+	}
+
+	inline uint32_t ShapeHandle::IntersectPacket(const RayPacket & packet, uint32_t activeMask,
+		Float * tHit, SurfaceInteraction * isect) const
+	{
+		return Dispatch([&](auto ptr) { return ptr->IntersectPacket(packet, activeMask, tHit, isect); });
+	}
+
+	inline uint32_t ShapeHandle::IntersectPPacket(const RayPacket & packet, uint32_t activeMask) const
+	{
+		return Dispatch([&](auto ptr) { return ptr->IntersectPPacket(packet, activeMask); });
+	}
+
+
+	inline bool GeometricPrimitive::IntersectHitInline(const Ray & r, SurfaceHit * hit) const
+	{
+		ProfilePhase _(Prof::ShapeIntersect);
+		++nShapeTests;
+		if (!(shapeHandle ? shapeHandle.IntersectHit(r, hit) : shape->IntersectHit(r, hit)))
+			return false;
+		++nShapeHits;
+
+		r.tMax = hit->tHit;
+		hit->primitive = this;
+		// ֮ǰĳʵĺѡµı任Լʵʱʵ
+		hit->instanceToWorld = nullptr;
+		hit->worldToInstance = nullptr;
+		return true;
+	}
+
+	inline bool GeometricPrimitive::IntersectPInline(const Ray & r) const
+	{
+		ProfilePhase _(Prof::ShapeIntersectP);
+		++nShapePTests;
+		bool hit = shapeHandle ? shapeHandle.IntersectP(r) : shape->IntersectP(r);
+		nShapePHits += hit;
+		return hit;
+	}
+
+	inline uint32_t GeometricPrimitive::IntersectPacketInline(RayPacket & packet, uint32_t activeMask,
+		SurfaceInteraction * isects) const
+	{
+		Float tHit[RayPacket::MaxSize];
+		uint32_t hitMask = shapeHandle ? shapeHandle.IntersectPacket(packet, activeMask, tHit, isects) :
+			shape->IntersectPacket(packet, activeMask, tHit, isects);
+		for (int i = 0; i < packet.size; ++i)
+		{
+			if (hitMask & (1u << i))
+			{
+				packet.tMax[i] = tHit[i];
+				isects[i].primitive = this;
+			}
+		}
+		return hitMask;
+	}
+
+	inline uint32_t GeometricPrimitive::IntersectPPacketInline(const RayPacket & packet, uint32_t activeMask) const
+	{
+		return shapeHandle ? shapeHandle.IntersectPPacket(packet, activeMask) :
+			shape->IntersectPPacket(packet, activeMask);
+	}
+
+
+	inline PrimitiveHandle PrimitiveHandle::FromPrimitive(const Primitive * primitive)
+	{
+		if (const GeometricPrimitive *geometric = dynamic_cast<const GeometricPrimitive *>(primitive))
+			return geometric;
+		return primitive;
+	}
+
+	inline bool PrimitiveHandle::IntersectHit(const Ray & r, SurfaceHit * hit) const
+	{
+		if (const GeometricPrimitive *geometric = CastOrNullptr<GeometricPrimitive>())
+			return geometric->IntersectHitInline(r, hit);
+		return Cast<Primitive>()->IntersectHit(r, hit);
+	}
+
+	inline bool PrimitiveHandle::IntersectP(const Ray & r) const
+	{
+		if (const GeometricPrimitive *geometric = CastOrNullptr<GeometricPrimitive>())
+			return geometric->IntersectPInline(r);
+		return Cast<Primitive>()->IntersectP(r);
+	}
+
+	inline uint32_t PrimitiveHandle::IntersectPPacket(const RayPacket & packet, uint32_t activeMask) const
+	{
+		if (const GeometricPrimitive *geometric = CastOrNullptr<GeometricPrimitive>())
+			return geometric->IntersectPPacketInline(packet, activeMask);
+		return Cast<Primitive>()->IntersectPPacket(packet, activeMask);
+	}
+
+
+	// ٽṹꡢͼԪųҶ˳֮
+	inline std::vector<PrimitiveHandle> MakePrimitiveHandles(const std::vector<std::shared_ptr<Primitive>> &primitives)
+	{
+		std::vector<PrimitiveHandle> handles(primitives.size());
+		for (size_t i = 0; i < primitives.size(); ++i)
+			handles[i] = PrimitiveHandle::FromPrimitive(primitives[i].get());
+		return handles;
+	}
+}
@@ -0,0 +1,91 @@
+#include "sobolmatrices.h"
+
+
+// JoeKuonew-joe-kuo-6.21201ǰ16άɣ
+//   V[i] = m[i] << (32 - i)                                  i <= s
+//   V[i] = V[i - s] ^ (V[i - s] >> s) ^ (aĸλ * V[i - k])     i > s
+namespace pbrt
+{
+	const uint32_t SobolMatrices32[NumSobolDimensions * SobolMatrixSize] = {
+		// dimension 0
+		0x80000000u, 0x40000000u, 0x20000000u, 0x10000000u, 0x08000000u, 0x04000000u, 0x02000000u, 0x01000000u,
+		0x00800000u, 0x00400000u, 0x00200000u, 0x00100000u, 0x00080000u, 0x00040000u, 0x00020000u, 0x00010000u,
+		0x00008000u, 0x00004000u, 0x00002000u, 0x00001000u, 0x00000800u, 0x00000400u, 0x00000200u, 0x00000100u,
+		0x00000080u, 0x00000040u, 0x00000020u, 0x00000010u, 0x00000008u, 0x00000004u, 0x00000002u, 0x00000001u,
+		// dimension 1
+		0x80000000u, 0xc0000000u, 0xa0000000u, 0xf0000000u, 0x88000000u, 0xcc000000u, 0xaa000000u, 0xff000000u,
+		0x80800000u, 0xc0c00000u, 0xa0a00000u, 0xf0f00000u, 0x88880000u, 0xcccc0000u, 0xaaaa0000u, 0xffff0000u,
+		0x80008000u, 0xc000c000u, 0xa000a000u, 0xf000f000u, 0x88008800u, 0xcc00cc00u, 0xaa00aa00u, 0xff00ff00u,
+		0x80808080u, 0xc0c0c0c0u, 0xa0a0a0a0u, 0xf0f0f0f0u, 0x88888888u, 0xccccccccu, 0xaaaaaaaau, 0xffffffffu,
+		// dimension 2
+		0x80000000u, 0xc0000000u, 0x60000000u, 0x90000000u, 0xe8000000u, 0x5c000000u, 0x8e000000u, 0xc5000000u,
+		0x68800000u, 0x9cc00000u, 0xee600000u, 0x55900000u, 0x80680000u, 0xc09c0000u, 0x60ee0000u, 0x90550000u,
+		0xe8808000u, 0x5cc0c000u, 0x8e606000u, 0xc5909000u, 0x6868e800u, 0x9c9c5c00u, 0xeeee8e00u, 0x5555c500u,
+		0x8000e880u, 0xc0005cc0u, 0x60008e60u, 0x9000c590u, 0xe8006868u, 0x5c009c9cu, 0x8e00eeeeu, 0xc5005555u,
+		// dimension 3
+		0x80000000u, 0xc0000000u, 0x20000000u, 0x50000000u, 0xf8000000u, 0x74000000u, 0xa2000000u, 0x93000000u,
+		0xd8800000u, 0x25400000u, 0x59e00000u, 0xe6d00000u, 0x78080000u, 0xb40c0000u, 0x82020000u, 0xc3050000u,
+		0x208f8000u, 0x51474000u, 0xfbea2000u, 0x75d93000u, 0xa0858800u, 0x914e5400u, 0xdbe79e00u, 0x25db6d00u,
+		0x58800080u, 0xe54000c0u, 0x79e00020u, 0xb6d00050u, 0x800800f8u, 0xc00c0074u, 0x200200a2u, 0x50050093u,
+		// dimension 4
+		0x80000000u, 0x40000000u, 0x20000000u, 0xb0000000u, 0xf8000000u, 0xdc000000u, 0x7a000000u, 0x9d000000u,
+		0x5a800000u, 0x2fc00000u, 0xa1600000u, 0xf0b00000u, 0xda880000u, 0x6fc40000u, 0x81620000u, 0x40bb0000u,
+		0x22878000u, 0xb3c9c000u, 0xfb65a000u, 0xddb2d000u, 0x78022800u, 0x9c0b3c00u, 0x5a0fb600u, 0x2d0ddb00u,
+		0xa2878080u, 0xf3c9c040u, 0xdb65a020u, 0x6db2d0b0u, 0x800228f8u, 0x400b3cdcu, 0x200fb67au, 0xb00ddb9du,
+		// dimension 5
+		0x80000000u, 0x40000000u, 0x60000000u, 0x30000000u, 0xc8000000u, 0x24000000u, 0x56000000u, 0xfb000000u,
+		0xe0800000u, 0x70400000u, 0xa8600000u, 0x14300000u, 0x9ec80000u, 0xdf240000u, 0xb6d60000u, 0x8bbb0000u,
+		0x48008000u, 0x64004000u, 0x36006000u, 0xcb003000u, 0x2880c800u, 0x54402400u, 0xfe605600u, 0xef30fb00u,
+		0x7e48e080u, 0xaf647040u, 0x1eb6a860u, 0x9f8b1430u, 0xd6c81ec8u, 0xbb249f24u, 0x80d6d6d6u, 0x40bbbbbbu,
+		// dimension 6
+		0x80000000u, 0xc0000000u, 0xa0000000u, 0xd0000000u, 0x58000000u, 0x94000000u, 0x3e000000u, 0xe3000000u,
+		0xbe800000u, 0x23c00000u, 0x1e200000u, 0xf3100000u, 0x46780000u, 0x67840000u, 0x78460000u, 0x84670000u,
+		0xc6788000u, 0xa784c000u, 0xd846a000u, 0x5467d000u, 0x9e78d800u, 0x33845400u, 0xe6469e00u, 0xb7673300u,
+		0x20f86680u, 0x104477c0u, 0xf8668020u, 0x4477c010u, 0x668020f8u, 0x77c01044u, 0x8020f866u, 0xc0104477u,
+		// dimension 7
+		0x80000000u, 0x40000000u, 0xa0000000u, 0x50000000u, 0x88000000u, 0x24000000u, 0x12000000u, 0x2d000000u,
+		0x76800000u, 0x9e400000u, 0x08200000u, 0x64100000u, 0xb2280000u, 0x7d140000u, 0xfea20000u, 0xba490000u,
+		0x1a248000u, 0x491b4000u, 0xc4b5a000u, 0xe3739000u, 0xf6800800u, 0xde400400u, 0xa8200a00u, 0x34100500u,
+		0x3a280880u, 0x59140240u, 0xeca20120u, 0x974902d0u, 0x6ca48768u, 0xd75b49e4u, 0xcc95a082u, 0x87639641u,
+		// dimension 8
+		0x80000000u, 0x40000000u, 0xa0000000u, 0x50000000u, 0x28000000u, 0xd4000000u, 0x6a000000u, 0x71000000u,
+		0x38800000u, 0x58400000u, 0xea200000u, 0x31100000u, 0x98a80000u, 0x08540000u, 0xc22a0000u, 0xe5250000u,
+		0xf2b28000u, 0x79484000u, 0xfaa42000u, 0xbd731000u, 0x18a80800u, 0x48540400u, 0x622a0a00u, 0xb5250500u,
+		0xdab28280u, 0xad484d40u, 0x90a426a0u, 0xcc731710u, 0x20280b88u, 0x10140184u, 0x880a04a2u, 0x84350611u,
+		// dimension 9
+		0x80000000u, 0x40000000u, 0xe0000000u, 0xb0000000u, 0x98000000u, 0x94000000u, 0x8a000000u, 0x5b000000u,
+		0x33800000u, 0xd9c00000u, 0x72200000u, 0x3f100000u, 0xc1b80000u, 0xa6ec0000u, 0x53860000u, 0x29f50000u,
+		0x0a3a8000u, 0x1b2ac000u, 0xd392e000u, 0x69ff7000u, 0xea380800u, 0xab2c0400u, 0x4ba60e00u, 0xfde50b00u,
+		0x60028980u, 0xf006c940u, 0x7834e8a0u, 0x241a75b0u, 0x123a8b38u, 0xcf2ac99cu, 0xb992e922u, 0x82ff78f1u,
+		// dimension 10
+		0x80000000u, 0x40000000u, 0xa0000000u, 0x10000000u, 0x08000000u, 0x6c000000u, 0x9e000000u, 0x23000000u,
+		0x57800000u, 0xadc00000u, 0x7fa00000u, 0x91d00000u, 0x49880000u, 0xced40000u, 0x880a0000u, 0x2c0f0000u,
+		0x3e0d8000u, 0x3317c000u, 0x5fb06000u, 0xc1f8b000u, 0xe18d8800u, 0xb2d7c400u, 0x1e106a00u, 0x6328b100u,
+		0xf7858880u, 0xbdc3c2c0u, 0x77ba63e0u, 0xfdf7b330u, 0xd7800df8u, 0xedc0081cu, 0xdfa0041au, 0x81d00a2du,
+		// dimension 11
+		0x80000000u, 0x40000000u, 0x20000000u, 0x30000000u, 0x58000000u, 0xac000000u, 0x96000000u, 0x2b000000u,
+		0xd4800000u, 0x09400000u, 0xe2a00000u, 0x52500000u, 0x4e280000u, 0xc71c0000u, 0x629e0000u, 0x12670000u,
+		0x6e138000u, 0xf731c000u, 0x3a98a000u, 0xbe449000u, 0xf83b8800u, 0xdc2dc400u, 0xee06a200u, 0xb7239300u,
+		0x1aa80d80u, 0x8e5c0ec0u, 0xa03e0b60u, 0x703701b0u, 0x783b88c8u, 0x9c2dca54u, 0xce06a74au, 0x87239795u,
+		// dimension 12
+		0x80000000u, 0xc0000000u, 0xa0000000u, 0x50000000u, 0xf8000000u, 0x8c000000u, 0xe2000000u, 0x33000000u,
+		0x0f800000u, 0x21400000u, 0x95a00000u, 0x5e700000u, 0xd8080000u, 0x1c240000u, 0xba160000u, 0xef370000u,
+		0x15868000u, 0x9e6fc000u, 0x781b6000u, 0x4c349000u, 0x420e8800u, 0x630bcc00u, 0xf7ad6a00u, 0xad739500u,
+		0x77800780u, 0x6d4004c0u, 0xd7a00420u, 0x3d700630u, 0x2f880f78u, 0xb1640ad4u, 0xcdb6077au, 0x824706d7u,
+		// dimension 13
+		0x80000000u, 0xc0000000u, 0x60000000u, 0x90000000u, 0x38000000u, 0xc4000000u, 0x42000000u, 0xa3000000u,
+		0xf1800000u, 0xaa400000u, 0xfce00000u, 0x85100000u, 0xe0080000u, 0x500c0000u, 0x58060000u, 0x54090000u,
+		0x7a038000u, 0x670c4000u, 0xb3842000u, 0x094a3000u, 0x0d6f1800u, 0x2f5aa400u, 0x1ce7ce00u, 0xd5145100u,
+		0xb8000080u, 0x040000c0u, 0x22000060u, 0x33000090u, 0xc9800038u, 0x6e4000c4u, 0xbee00042u, 0x261000a3u,
+		// dimension 14
+		0x80000000u, 0x40000000u, 0x20000000u, 0xf0000000u, 0xa8000000u, 0x54000000u, 0x9a000000u, 0x9d000000u,
+		0x1e800000u, 0x5cc00000u, 0x7d200000u, 0x8d100000u, 0x24880000u, 0x71c40000u, 0xeba20000u, 0x75df0000u,
+		0x6ba28000u, 0x35d14000u, 0x4ba3a000u, 0xc5d2d000u, 0xe3a16800u, 0x91db8c00u, 0x79aef200u, 0x0cdf4100u,
+		0x672a8080u, 0x50154040u, 0x1a01a020u, 0xdd0dd0f0u, 0x3e83e8a8u, 0xaccacc54u, 0xd52d529au, 0xd91d919du,
+		// dimension 15
+		0x80000000u, 0xc0000000u, 0x20000000u, 0xd0000000u, 0xd8000000u, 0xc4000000u, 0x46000000u, 0x85000000u,
+		0xa5800000u, 0x76c00000u, 0xada00000u, 0x6ab00000u, 0x2da80000u, 0xaabc0000u, 0x0daa0000u, 0x7ab10000u,
+		0xd5a78000u, 0xbebd4000u, 0x93a3e000u, 0x3bb51000u, 0x3629b800u, 0x4d727c00u, 0x9b836200u, 0x27c4d700u,
+		0xb629b880u, 0x8d727cc0u, 0xbb836220u, 0xf7c4d7d0u, 0x6e29b858u, 0x49727c04u, 0xfd836266u, 0x72c4d755u,
+	};
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+
+#include <cstdint>
+
+
+namespace pbrt
+{
+	// Sobolеɾÿһά32УiŵiλӦķλǰ
+	// 0άvan der CorputУ֮άJoeKuo2008ıԭʽͳʼ
+	// 01ά(0, 2)-СɽűԤãsobolmatrices.cpp
+	static const int NumSobolDimensions = 16;
+	static const int SobolMatrixSize = 32;
+	extern const uint32_t SobolMatrices32[NumSobolDimensions * SobolMatrixSize];
+}
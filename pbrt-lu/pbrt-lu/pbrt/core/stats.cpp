@@ -0,0 +1,137 @@
+#include "stats.h"
+
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
+
+namespace pbrt
+{
+	// úڵľ̬֤ļStatRegistererھ̬ʼʱ
+	static std::vector<void(*)(StatsAccumulator &)> &StatFuncs()
+	{
+		static std::vector<void(*)(StatsAccumulator &)> funcs;
+		return funcs;
+	}
+
+	static StatsAccumulator statsAccumulator;
+	static std::mutex statsMutex;
+
+	StatRegisterer::StatRegisterer(void(*func)(StatsAccumulator &))
+	{
+		StatFuncs().push_back(func);
+	}
+
+	void ReportThreadStats()
+	{
+		std::lock_guard<std::mutex> lock(statsMutex);
+		for (auto func : StatFuncs())
+			func(statsAccumulator);
+	}
+
+	void PrintStats(FILE *dest)
+	{
+		ReportThreadStats();
+		std::lock_guard<std::mutex> lock(statsMutex);
+		statsAccumulator.Print(dest);
+	}
+
+	void ClearStats()
+	{
+		ReportThreadStats();
+		std::lock_guard<std::mutex> lock(statsMutex);
+		statsAccumulator.Clear();
+	}
+
+
+	void StatsAccumulator::ReportIntDistribution(const std::string &name, int64_t sum, int64_t count,
+		int64_t min, int64_t max)
+	{
+		Distribution &d = intDistributions[name];
+		d.sum += sum;
+		d.count += count;
+		d.min = std::min(d.min, min);
+		d.max = std::max(d.max, max);
+	}
+
+	void StatsAccumulator::Clear()
+	{
+		counters.clear();
+		intDistributions.clear();
+		percentages.clear();
+		ratios.clear();
+	}
+
+	// "/"
+	static void SplitTitle(const std::string &title, std::string *category, std::string *name)
+	{
+		size_t slash = title.find('/');
+		if (slash == std::string::npos)
+		{
+			*category = "";
+			*name = title;
+		}
+		else
+		{
+			*category = title.substr(0, slash);
+			*name = title.substr(slash + 1);
+		}
+	}
+
+	void StatsAccumulator::Print(FILE *dest) const
+	{
+		// ÿµУ
+		std::map<std::string, std::vector<std::string>> lines;
+		char buf[256];
+		std::string category, name;
+
+		for (const auto &c : counters)
+		{
+			if (c.second == 0)
+				continue;
+			SplitTitle(c.first, &category, &name);
+			snprintf(buf, sizeof(buf), "%-42s               %12lld", name.c_str(), (long long)c.second);
+			lines[category].push_back(buf);
+		}
+		for (const auto &d : intDistributions)
+		{
+			if (d.second.count == 0)
+				continue;
+			SplitTitle(d.first, &category, &name);
+			snprintf(buf, sizeof(buf), "%-42s                 %.3f avg [range %lld - %lld]", name.c_str(),
+				(double)d.second.sum / d.second.count, (long long)d.second.min, (long long)d.second.max);
+			lines[category].push_back(buf);
+		}
+		for (const auto &p : percentages)
+		{
+			if (p.second.second == 0)
+				continue;
+			SplitTitle(p.first, &category, &name);
+			snprintf(buf, sizeof(buf), "%-42s%12lld / %12lld (%.2f%%)", name.c_str(),
+				(long long)p.second.first, (long long)p.second.second,
+				100. * p.second.first / p.second.second);
+			lines[category].push_back(buf);
+		}
+		for (const auto &r : ratios)
+		{
+			if (r.second.second == 0)
+				continue;
+			SplitTitle(r.first, &category, &name);
+			snprintf(buf, sizeof(buf), "%-42s%12lld / %12lld (%.2fx)", name.c_str(),
+				(long long)r.second.first, (long long)r.second.second,
+				(double)r.second.first / r.second.second);
+			lines[category].push_back(buf);
+		}
+
+		if (lines.empty())
+			return;
+		fprintf(dest, "Statistics:\n");
+		for (auto &category : lines)
+		{
+			fprintf(dest, "  %s\n", category.first.c_str());
+			std::sort(category.second.begin(), category.second.end());
+			for (const std::string &line : category.second)
+				fprintf(dest, "    %s\n", line.c_str());
+		}
+	}
+}
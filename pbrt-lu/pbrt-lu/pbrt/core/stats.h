@@ -0,0 +1,168 @@
+#pragma once
+
+
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <map>
+#include <string>
+
+#include "../pbrt.h"
+
+
+// Ⱦͳƣͷֲ
+// ÿͳֲ߳̾·ֻһͨļӷҲԭӲ
+// ̰߳ԼֵReportThreadStatsϲ߳˳ʱMergeWorkerThreadStatsʱ֮㡣
+// д"/"PrintStatsͬļͬͳһ
+// PBRT_NO_STATSʱͳɿն󣬸䱻ɾ
+//
+// ÷.cppռ
+//   STAT_COUNTER("Intersections/Regular ray intersection tests", nIntersectionTests);
+//   STAT_PERCENT("Intersections/Ray-triangle hits", nTriHits, nTriTests);
+//   STAT_INT_DISTRIBUTION("BVH/Nodes visited per query", nodesPerQuery);
+//   ++nIntersectionTests;  ReportValue(nodesPerQuery, n);
+// ͷļҪͳʱͷļдSTAT_EXTERN_*ĳһ.cppдSTAT_GLOBAL_*塣
+
+namespace pbrt
+{
+	// ̵߳ͳƽ
+	class StatsAccumulator
+	{
+	public:
+		void ReportCounter(const std::string &name, int64_t val) { counters[name] += val; }
+
+		void ReportIntDistribution(const std::string &name, int64_t sum, int64_t count, int64_t min,
+			int64_t max);
+
+		void ReportPercentage(const std::string &name, int64_t num, int64_t denom)
+		{
+			percentages[name].first += num;
+			percentages[name].second += denom;
+		}
+
+		void ReportRatio(const std::string &name, int64_t num, int64_t denom)
+		{
+			ratios[name].first += num;
+			ratios[name].second += denom;
+		}
+
+		void Print(FILE *dest) const;
+		void Clear();
+
+	private:
+		struct Distribution
+		{
+			int64_t sum = 0, count = 0;
+			int64_t min = std::numeric_limits<int64_t>::max();
+			int64_t max = std::numeric_limits<int64_t>::lowest();
+		};
+
+		std::map<std::string, int64_t> counters;
+		std::map<std::string, Distribution> intDistributions;
+		std::map<std::string, std::pair<int64_t, int64_t>> percentages, ratios;
+	};
+
+	// ̬ʼʱǼһͳϱϱǰ̵ֵ߳
+	class StatRegisterer
+	{
+	public:
+		explicit StatRegisterer(void(*func)(StatsAccumulator &));
+	};
+
+	// ѵ̵߳ͳӵ߳Լֵ
+	void ReportThreadStats();
+	// ϱ̵߳ͳ
+	void PrintStats(FILE *dest);
+	void ClearStats();
+
+
+	// ͳƹرʱͳĿնвǿյ
+	struct StatDummy
+	{
+		StatDummy &operator++() { return *this; }
+		StatDummy &operator++(int) { return *this; }
+		template <typename T>
+		StatDummy &operator+=(const T &) { return *this; }
+	};
+}
+
+
+#ifndef PBRT_NO_STATS
+
+#define STAT_COUNTER(title, var)                                          \
+	static PBRT_THREAD_LOCAL int64_t var;                                 \
+	static void STATS_FUNC##var(pbrt::StatsAccumulator &accum)            \
+	{                                                                     \
+		accum.ReportCounter(title, var);                                  \
+		var = 0;                                                          \
+	}                                                                     \
+	static pbrt::StatRegisterer STATS_REG##var(STATS_FUNC##var)
+
+#define STAT_INT_DISTRIBUTION(title, var)                                 \
+	static PBRT_THREAD_LOCAL int64_t var##sum;                            \
+	static PBRT_THREAD_LOCAL int64_t var##count;                          \
+	static PBRT_THREAD_LOCAL int64_t var##min = INT64_MAX;                \
+	static PBRT_THREAD_LOCAL int64_t var##max = INT64_MIN;                \
+	static void STATS_FUNC##var(pbrt::StatsAccumulator &accum)            \
+	{                                                                     \
+		accum.ReportIntDistribution(title, var##sum, var##count,          \
+			var##min, var##max);                                          \
+		var##sum = 0;                                                     \
+		var##count = 0;                                                   \
+		var##min = INT64_MAX;                                             \
+		var##max = INT64_MIN;                                             \
+	}                                                                     \
+	static pbrt::StatRegisterer STATS_REG##var(STATS_FUNC##var)
+
+#define ReportValue(var, value)                                           \
+	do                                                                    \
+	{                                                                     \
+		int64_t statValue = (value);                                      \
+		var##sum += statValue;                                            \
+		var##count += 1;                                                  \
+		var##min = statValue < var##min ? statValue : var##min;           \
+		var##max = statValue > var##max ? statValue : var##max;           \
+	} while (0)
+
+#define STAT_PERCENT(title, numVar, denomVar)                             \
+	static PBRT_THREAD_LOCAL int64_t numVar, denomVar;                    \
+	static void STATS_FUNC##numVar(pbrt::StatsAccumulator &accum)         \
+	{                                                                     \
+		accum.ReportPercentage(title, numVar, denomVar);                  \
+		numVar = denomVar = 0;                                            \
+	}                                                                     \
+	static pbrt::StatRegisterer STATS_REG##numVar(STATS_FUNC##numVar)
+
+#define STAT_RATIO(title, numVar, denomVar)                               \
+	static PBRT_THREAD_LOCAL int64_t numVar, denomVar;                    \
+	static void STATS_FUNC##numVar(pbrt::StatsAccumulator &accum)         \
+	{                                                                     \
+		accum.ReportRatio(title, numVar, denomVar);                       \
+		numVar = denomVar = 0;                                            \
+	}                                                                     \
+	static pbrt::StatRegisterer STATS_REG##numVar(STATS_FUNC##numVar)
+
+// ͷļõԼӦĶ壨ֻһ.cpp
+#define STAT_EXTERN_PERCENT(numVar, denomVar)                             \
+	extern PBRT_THREAD_LOCAL int64_t numVar, denomVar
+
+#define STAT_GLOBAL_PERCENT(title, numVar, denomVar)                      \
+	PBRT_THREAD_LOCAL int64_t numVar, denomVar;                           \
+	static void STATS_FUNC##numVar(pbrt::StatsAccumulator &accum)         \
+	{                                                                     \
+		accum.ReportPercentage(title, numVar, denomVar);                  \
+		numVar = denomVar = 0;                                            \
+	}                                                                     \
+	static pbrt::StatRegisterer STATS_REG##numVar(STATS_FUNC##numVar)
+
+#else
+
+#define STAT_COUNTER(title, var) static pbrt::StatDummy var
+#define STAT_INT_DISTRIBUTION(title, var) static pbrt::StatDummy var
+#define ReportValue(var, value) ((void)(var), (void)sizeof(value))
+#define STAT_PERCENT(title, numVar, denomVar) static pbrt::StatDummy numVar, denomVar
+#define STAT_RATIO(title, numVar, denomVar) static pbrt::StatDummy numVar, denomVar
+#define STAT_EXTERN_PERCENT(numVar, denomVar) extern pbrt::StatDummy numVar, denomVar
+#define STAT_GLOBAL_PERCENT(title, numVar, denomVar) pbrt::StatDummy numVar, denomVar
+
+#endif  // PBRT_NO_STATS
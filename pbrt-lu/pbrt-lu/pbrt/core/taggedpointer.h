@@ -0,0 +1,169 @@
+#pragma once
+
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include "../pbrt.h"
+
+
+// ͱǵָ룺ָTsĳһ͵Ķ͵ıŷָĵλ⼸λ0
+// ָͨһDispatchswitchϵãõÿ֧õĺ
+// ֱӵþ0ʾָ롣
+// λܷµȡڶ룺32λﺬָఴ4ֽڶ룬3͡
+namespace pbrt
+{
+	namespace detail
+	{
+		// TTsеλã0ʼʱΪ-1
+		template <typename T, typename... Ts>
+		struct TypeIndex
+		{
+			static constexpr int value = -1;
+		};
+
+		template <typename T, typename... Ts>
+		struct TypeIndex<T, T, Ts...>
+		{
+			static constexpr int value = 0;
+		};
+
+		template <typename T, typename U, typename... Ts>
+		struct TypeIndex<T, U, Ts...>
+		{
+			static constexpr int value = TypeIndex<T, Ts...>::value < 0 ? -1 : 1 + TypeIndex<T, Ts...>::value;
+		};
+
+		template <typename T, typename... Ts>
+		struct FirstType
+		{
+			typedef T type;
+		};
+
+		// 0..nЩҪλ
+		constexpr int TagBitsFor(int n, int bits = 0)
+		{
+			return (1 << bits) > n ? bits : TagBitsFor(n, bits + 1);
+		}
+
+		// indexΪTsеλá͸չswitch3ʱÿչ3
+		template <typename F, typename R, typename T>
+		R Dispatch(F &&func, const void *ptr, int index)
+		{
+			DCHECK(index == 0);
+			return func(static_cast<const T *>(ptr));
+		}
+
+		template <typename F, typename R, typename T0, typename T1>
+		R Dispatch(F &&func, const void *ptr, int index)
+		{
+			switch (index)
+			{
+			case 0:
+				return func(static_cast<const T0 *>(ptr));
+			default:
+				DCHECK(index == 1);
+				return func(static_cast<const T1 *>(ptr));
+			}
+		}
+
+		template <typename F, typename R, typename T0, typename T1, typename T2>
+		R Dispatch(F &&func, const void *ptr, int index)
+		{
+			switch (index)
+			{
+			case 0:
+				return func(static_cast<const T0 *>(ptr));
+			case 1:
+				return func(static_cast<const T1 *>(ptr));
+			default:
+				DCHECK(index == 2);
+				return func(static_cast<const T2 *>(ptr));
+			}
+		}
+
+		template <typename F, typename R, typename T0, typename T1, typename T2, typename T3, typename... Ts>
+		R Dispatch(F &&func, const void *ptr, int index)
+		{
+			switch (index)
+			{
+			case 0:
+				return func(static_cast<const T0 *>(ptr));
+			case 1:
+				return func(static_cast<const T1 *>(ptr));
+			case 2:
+				return func(static_cast<const T2 *>(ptr));
+			default:
+				return Dispatch<F, R, T3, Ts...>(std::forward<F>(func), ptr, index - 3);
+			}
+		}
+	}
+
+
+	template <typename... Ts>
+	class TaggedPointer
+	{
+	public:
+		static constexpr int TagBits = detail::TagBitsFor(sizeof...(Ts));
+		static constexpr uintptr_t TagMask = (uintptr_t(1) << TagBits) - 1;
+
+		TaggedPointer() {}
+		TaggedPointer(std::nullptr_t) {}
+
+		// ֻ飬ʱTsԻǲ
+		template <typename T>
+		TaggedPointer(const T *ptr)
+		{
+			static_assert(detail::TypeIndex<T, Ts...>::value >= 0, "T is not one of the tagged types");
+			static_assert(alignof(T) > TagMask, "T is not aligned enough to hold the tag in the low bits");
+			uintptr_t iptr = reinterpret_cast<uintptr_t>(ptr);
+			DCHECK((iptr & TagMask) == 0);
+			bits = ptr ? (iptr | uintptr_t(TypeIndex<T>())) : 0;
+		}
+
+		// Tıţ1ʼ
+		template <typename T>
+		static constexpr int TypeIndex()
+		{
+			return detail::TypeIndex<T, Ts...>::value + 1;
+		}
+
+		int Tag() const { return int(bits & TagMask); }
+
+		template <typename T>
+		bool Is() const { return Tag() == TypeIndex<T>(); }
+
+		template <typename T>
+		const T *Cast() const
+		{
+			DCHECK(Is<T>());
+			return reinterpret_cast<const T *>(bits & ~TagMask);
+		}
+
+		template <typename T>
+		const T *CastOrNullptr() const
+		{
+			return Is<T>() ? Cast<T>() : nullptr;
+		}
+
+		const void *Ptr() const { return reinterpret_cast<const void *>(bits & ~TagMask); }
+
+		explicit operator bool() const { return bits != 0; }
+		bool operator==(const TaggedPointer &tp) const { return bits == tp.bits; }
+		bool operator!=(const TaggedPointer &tp) const { return bits != tp.bits; }
+
+		// const T *funcÿ͵ķֵҪָͬ벻Ϊ
+		template <typename F>
+		auto Dispatch(F &&func) const
+			-> decltype(func(static_cast<const typename detail::FirstType<Ts...>::type *>(nullptr)))
+		{
+			DCHECK(bits != 0);
+			typedef decltype(func(static_cast<const typename detail::FirstType<Ts...>::type *>(nullptr))) R;
+			return detail::Dispatch<F, R, Ts...>(std::forward<F>(func), Ptr(), Tag() - 1);
+		}
+
+	private:
+		uintptr_t bits = 0;
+	};
+}
@@ -1,6 +1,15 @@
 #include "transform.h"
+#include "interaction.h"
+#include "raypacket.h"
+
+#include <algorithm>
+#include <cstring>
 #include <memory>
 
+#ifdef PBRT_HAVE_SSE
+#include <immintrin.h>
+#endif
+
 
 namespace pbrt
 {
@@ -32,7 +41,7 @@ namespace pbrt
 	}
 
 	// ת
-	Matrix4x4 Matrix4x4::Transpose(const Matrix4x4 &m)
+	Matrix4x4 Matrix4x4::TransposeScalar(const Matrix4x4 &m)
 	{
 		return Matrix4x4(m.m[0][0], m.m[1][0], m.m[2][0], m.m[3][0], m.m[0][1],
 			m.m[1][1], m.m[2][1], m.m[3][1], m.m[0][2], m.m[1][2],
@@ -40,8 +49,220 @@ namespace pbrt
 			m.m[3][3]);
 	}
 
+	Matrix4x4 Matrix4x4::Transpose(const Matrix4x4 &m)
+	{
+#ifdef PBRT_HAVE_SSE
+		__m128 r0 = _mm_loadu_ps(m.m[0]), r1 = _mm_loadu_ps(m.m[1]);
+		__m128 r2 = _mm_loadu_ps(m.m[2]), r3 = _mm_loadu_ps(m.m[3]);
+		_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+		Matrix4x4 r;
+		_mm_storeu_ps(r.m[0], r0);
+		_mm_storeu_ps(r.m[1], r1);
+		_mm_storeu_ps(r.m[2], r2);
+		_mm_storeu_ps(r.m[3], r3);
+		return r;
+#else
+		return TransposeScalar(m);
+#endif
+	}
+
+	bool Matrix4x4::Inverse(const Matrix4x4 &m, Matrix4x4 *mInv)
+	{
+		// [m | I]ԪÿһѡʣӾоֵԪԪ
+		// нֱн¼򻻻ء
+		int indxc[4], indxr[4];
+		int ipiv[4] = { 0, 0, 0, 0 };
+		double minv[4][4];
+		for (int i = 0; i < 4; ++i)
+			for (int j = 0; j < 4; ++j)
+				minv[i][j] = m.m[i][j];
+
+		for (int i = 0; i < 4; ++i)
+		{
+			int irow = 0, icol = 0;
+			double big = 0.;
+			for (int j = 0; j < 4; ++j)
+			{
+				if (ipiv[j] != 1)
+				{
+					for (int k = 0; k < 4; ++k)
+					{
+						if (ipiv[k] == 0)
+						{
+							if (std::abs(minv[j][k]) >= big)
+							{
+								big = std::abs(minv[j][k]);
+								irow = j;
+								icol = k;
+							}
+						}
+						else if (ipiv[k] > 1)
+							return false;
+					}
+				}
+			}
+			++ipiv[icol];
+
+			// ԪԽ
+			if (irow != icol)
+				for (int k = 0; k < 4; ++k)
+					std::swap(minv[irow][k], minv[icol][k]);
+			indxr[i] = irow;
+			indxc[i] = icol;
+			if (minv[icol][icol] == 0.)
+				return false;
+
+			double pivinv = 1. / minv[icol][icol];
+			minv[icol][icol] = 1.;
+			for (int j = 0; j < 4; ++j)
+				minv[icol][j] *= pivinv;
+
+			// мȥԪеı
+			for (int j = 0; j < 4; ++j)
+			{
+				if (j != icol)
+				{
+					double save = minv[j][icol];
+					minv[j][icol] = 0;
+					for (int k = 0; k < 4; ++k)
+						minv[j][k] -= minv[icol][k] * save;
+				}
+			}
+		}
+
+		// н
+		for (int j = 3; j >= 0; j--)
+		{
+			if (indxr[j] != indxc[j])
+			{
+				for (int k = 0; k < 4; k++)
+					std::swap(minv[k][indxr[j]], minv[k][indxc[j]]);
+			}
+		}
+
+		for (int i = 0; i < 4; ++i)
+			for (int j = 0; j < 4; ++j)
+				mInv->m[i][j] = (Float)minv[i][j];
+		return true;
+	}
+
+
+	bool Transform::FromMatrix(const Matrix4x4 & m, Transform * t)
+	{
+		Matrix4x4 mInv;
+		if (!Matrix4x4::Inverse(m, &mInv))
+			return false;
+		*t = Transform(m, mInv);
+		return true;
+	}
+
+	Transform Transform::operator*(const Transform & t2) const
+	{
+		return Transform(Matrix4x4::Mul(m, t2.m), Matrix4x4::Mul(t2.mInv, mInv));
+	}
+
+	Transform Translate(const Vector3f & delta)
+	{
+		Matrix4x4 m(1, 0, 0, delta.x, 0, 1, 0, delta.y, 0, 0, 1, delta.z, 0, 0, 0, 1);
+		Matrix4x4 minv(1, 0, 0, -delta.x, 0, 1, 0, -delta.y, 0, 0, 1, -delta.z, 0, 0, 0, 1);
+		return Transform(m, minv);
+	}
+
+	Transform Scale(Float x, Float y, Float z)
+	{
+		Matrix4x4 m(x, 0, 0, 0, 0, y, 0, 0, 0, 0, z, 0, 0, 0, 0, 1);
+		Matrix4x4 minv(1 / x, 0, 0, 0, 0, 1 / y, 0, 0, 0, 0, 1 / z, 0, 0, 0, 0, 1);
+		return Transform(m, minv);
+	}
+
+	// תת
+	Transform RotateX(Float theta)
+	{
+		Float sinTheta = std::sin(Radians(theta));
+		Float cosTheta = std::cos(Radians(theta));
+		Matrix4x4 m(1, 0, 0, 0, 0, cosTheta, -sinTheta, 0, 0, sinTheta, cosTheta, 0,
+			0, 0, 0, 1);
+		return Transform(m, Matrix4x4::Transpose(m));
+	}
+
+	Transform RotateY(Float theta)
+	{
+		Float sinTheta = std::sin(Radians(theta));
+		Float cosTheta = std::cos(Radians(theta));
+		Matrix4x4 m(cosTheta, 0, sinTheta, 0, 0, 1, 0, 0, -sinTheta, 0, cosTheta, 0,
+			0, 0, 0, 1);
+		return Transform(m, Matrix4x4::Transpose(m));
+	}
+
+	Transform RotateZ(Float theta)
+	{
+		Float sinTheta = std::sin(Radians(theta));
+		Float cosTheta = std::cos(Radians(theta));
+		Matrix4x4 m(cosTheta, -sinTheta, 0, 0, sinTheta, cosTheta, 0, 0, 0, 0, 1, 0,
+			0, 0, 0, 1);
+		return Transform(m, Matrix4x4::Transpose(m));
+	}
+
+	// תRodriguesʽ
+	Transform Rotate(Float theta, const Vector3f & axis)
+	{
+		Vector3f a = Normalize(axis);
+		Float sinTheta = std::sin(Radians(theta));
+		Float cosTheta = std::cos(Radians(theta));
+		Matrix4x4 m;
+		m.m[0][0] = a.x * a.x + (1 - a.x * a.x) * cosTheta;
+		m.m[0][1] = a.x * a.y * (1 - cosTheta) - a.z * sinTheta;
+		m.m[0][2] = a.x * a.z * (1 - cosTheta) + a.y * sinTheta;
+		m.m[0][3] = 0;
+
+		m.m[1][0] = a.x * a.y * (1 - cosTheta) + a.z * sinTheta;
+		m.m[1][1] = a.y * a.y + (1 - a.y * a.y) * cosTheta;
+		m.m[1][2] = a.y * a.z * (1 - cosTheta) - a.x * sinTheta;
+		m.m[1][3] = 0;
+
+		m.m[2][0] = a.x * a.z * (1 - cosTheta) - a.y * sinTheta;
+		m.m[2][1] = a.y * a.z * (1 - cosTheta) + a.x * sinTheta;
+		m.m[2][2] = a.z * a.z + (1 - a.z * a.z) * cosTheta;
+		m.m[2][3] = 0;
+		return Transform(m, Matrix4x4::Transpose(m));
+	}
+
+	Transform LookAt(const Point3f & pos, const Point3f & look, const Vector3f & up)
+	{
+		// ȹռ䵽ռľΪrightnewUpdirλ
+		Matrix4x4 cameraToWorld;
+		cameraToWorld.m[0][3] = pos.x;
+		cameraToWorld.m[1][3] = pos.y;
+		cameraToWorld.m[2][3] = pos.z;
+		cameraToWorld.m[3][3] = 1;
+
+		Vector3f dir = Normalize(look - pos);
+		if (Cross(Normalize(up), dir).Length() == 0)
+		{
+			// up߷ƽУ޷ȷ
+			DCHECK(false);
+			return Transform();
+		}
+		Vector3f right = Normalize(Cross(Normalize(up), dir));
+		Vector3f newUp = Cross(dir, right);
+		cameraToWorld.m[0][0] = right.x;
+		cameraToWorld.m[1][0] = right.y;
+		cameraToWorld.m[2][0] = right.z;
+		cameraToWorld.m[3][0] = 0.;
+		cameraToWorld.m[0][1] = newUp.x;
+		cameraToWorld.m[1][1] = newUp.y;
+		cameraToWorld.m[2][1] = newUp.z;
+		cameraToWorld.m[3][1] = 0.;
+		cameraToWorld.m[0][2] = dir.x;
+		cameraToWorld.m[1][2] = dir.y;
+		cameraToWorld.m[2][2] = dir.z;
+		cameraToWorld.m[3][2] = 0.;
+
+		Matrix4x4 worldToCamera;
+		Matrix4x4::Inverse(cameraToWorld, &worldToCamera);
+		return Transform(worldToCamera, cameraToWorld);
+	}
 
-	 
 
 	Point3f Transform::operator()(const Point3f & p) const
 	{
@@ -55,19 +276,407 @@ namespace pbrt
 		return Point3f(xp, yp, zp);
 	}
 
+	Vector3f Transform::operator()(const Vector3f & v) const
+	{
+		Float x = v.x, y = v.y, z = v.z;
+		return Vector3f(m.m[0][0] * x + m.m[0][1] * y + m.m[0][2] * z,
+			m.m[1][0] * x + m.m[1][1] * y + m.m[1][2] * z,
+			m.m[2][0] * x + m.m[2][1] * y + m.m[2][2] * z);
+	}
+
+	Normal3f Transform::operator()(const Normal3f & n) const
+	{
+		Float x = n.x, y = n.y, z = n.z;
+		return Normal3f(mInv.m[0][0] * x + mInv.m[1][0] * y + mInv.m[2][0] * z,
+			mInv.m[0][1] * x + mInv.m[1][1] * y + mInv.m[2][1] * z,
+			mInv.m[0][2] * x + mInv.m[1][2] * y + mInv.m[2][2] * z);
+	}
+
+	Ray Transform::operator()(const Ray & r) const
+	{
+		Vector3f oError;
+		Point3f o = (*this)(r.o, &oError);
+		Vector3f d = (*this)(r.d);
+
+		// ԭطǰŲ䣬任ԭ䵽һཻ
+		Float lengthSquared = d.LengthSquared();
+		Float tMax = r.tMax;
+		if (lengthSquared > 0)
+		{
+			Float dt = Dot(Abs(d), oError) / lengthSquared;
+			o += d * dt;
+			tMax -= dt;
+		}
+		return Ray(o, d, tMax, r.time);
+	}
+
+	Point3f Transform::operator()(const Point3f & p, Vector3f * pError) const
+	{
+		Float x = p.x, y = p.y, z = p.z;
+		Float xp = (m.m[0][0] * x + m.m[0][1] * y) + (m.m[0][2] * z + m.m[0][3]);
+		Float yp = (m.m[1][0] * x + m.m[1][1] * y) + (m.m[1][2] * z + m.m[1][3]);
+		Float zp = (m.m[2][0] * x + m.m[2][1] * y) + (m.m[2][2] * z + m.m[2][3]);
+		Float wp = (m.m[3][0] * x + m.m[3][1] * y) + (m.m[3][2] * z + m.m[3][3]);
+
+		// ÿ4˻֮ͣļӷ˳gamma(3)
+		Float xAbsSum = (std::abs(m.m[0][0] * x) + std::abs(m.m[0][1] * y) +
+			std::abs(m.m[0][2] * z) + std::abs(m.m[0][3]));
+		Float yAbsSum = (std::abs(m.m[1][0] * x) + std::abs(m.m[1][1] * y) +
+			std::abs(m.m[1][2] * z) + std::abs(m.m[1][3]));
+		Float zAbsSum = (std::abs(m.m[2][0] * x) + std::abs(m.m[2][1] * y) +
+			std::abs(m.m[2][2] * z) + std::abs(m.m[2][3]));
+		*pError = gamma(3) * Vector3f(xAbsSum, yAbsSum, zAbsSum);
+
+		DCHECK(wp != 0);
+		if (wp == 1)
+			return Point3f(xp, yp, zp);
+		else
+			return Point3f(xp, yp, zp) / wp;
+	}
+
+	Point3f Transform::operator()(const Point3f & pt, const Vector3f & ptError, Vector3f * absError) const
+	{
+		Float x = pt.x, y = pt.y, z = pt.z;
+		Float xp = (m.m[0][0] * x + m.m[0][1] * y) + (m.m[0][2] * z + m.m[0][3]);
+		Float yp = (m.m[1][0] * x + m.m[1][1] * y) + (m.m[1][2] * z + m.m[1][3]);
+		Float zp = (m.m[2][0] * x + m.m[2][1] * y) + (m.m[2][2] * z + m.m[2][3]);
+		Float wp = (m.m[3][0] * x + m.m[3][1] * y) + (m.m[3][2] * z + m.m[3][3]);
+
+		absError->x =
+			(gamma(3) + (Float)1) *
+			(std::abs(m.m[0][0]) * ptError.x + std::abs(m.m[0][1]) * ptError.y +
+				std::abs(m.m[0][2]) * ptError.z) +
+			gamma(3) * (std::abs(m.m[0][0] * x) + std::abs(m.m[0][1] * y) +
+				std::abs(m.m[0][2] * z) + std::abs(m.m[0][3]));
+		absError->y =
+			(gamma(3) + (Float)1) *
+			(std::abs(m.m[1][0]) * ptError.x + std::abs(m.m[1][1]) * ptError.y +
+				std::abs(m.m[1][2]) * ptError.z) +
+			gamma(3) * (std::abs(m.m[1][0] * x) + std::abs(m.m[1][1] * y) +
+				std::abs(m.m[1][2] * z) + std::abs(m.m[1][3]));
+		absError->z =
+			(gamma(3) + (Float)1) *
+			(std::abs(m.m[2][0]) * ptError.x + std::abs(m.m[2][1]) * ptError.y +
+				std::abs(m.m[2][2]) * ptError.z) +
+			gamma(3) * (std::abs(m.m[2][0] * x) + std::abs(m.m[2][1] * y) +
+				std::abs(m.m[2][2] * z) + std::abs(m.m[2][3]));
+
+		DCHECK(wp != 0);
+		if (wp == 1.)
+			return Point3f(xp, yp, zp);
+		else
+			return Point3f(xp, yp, zp) / wp;
+	}
+
+	Vector3f Transform::operator()(const Vector3f & v, Vector3f * absError) const
+	{
+		Float x = v.x, y = v.y, z = v.z;
+		absError->x = gamma(3) * (std::abs(m.m[0][0] * v.x) + std::abs(m.m[0][1] * v.y) +
+			std::abs(m.m[0][2] * v.z));
+		absError->y = gamma(3) * (std::abs(m.m[1][0] * v.x) + std::abs(m.m[1][1] * v.y) +
+			std::abs(m.m[1][2] * v.z));
+		absError->z = gamma(3) * (std::abs(m.m[2][0] * v.x) + std::abs(m.m[2][1] * v.y) +
+			std::abs(m.m[2][2] * v.z));
+		return Vector3f(m.m[0][0] * x + m.m[0][1] * y + m.m[0][2] * z,
+			m.m[1][0] * x + m.m[1][1] * y + m.m[1][2] * z,
+			m.m[2][0] * x + m.m[2][1] * y + m.m[2][2] * z);
+	}
+
+	Ray Transform::operator()(const Ray & r, Vector3f * oError, Vector3f * dError) const
+	{
+		Point3f o = (*this)(r.o, oError);
+		Vector3f d = (*this)(r.d, dError);
+		Float tMax = r.tMax;
+		Float lengthSquared = d.LengthSquared();
+		if (lengthSquared > 0)
+		{
+			Float dt = Dot(Abs(d), *oError) / lengthSquared;
+			o += d * dt;
+		}
+		return Ray(o, d, tMax, r.time);
+	}
+
+	SurfaceInteraction Transform::operator()(const SurfaceInteraction & si) const
+	{
+		SurfaceInteraction ret;
+		const Transform &t = *this;
+		ret.p = t(si.p, si.pError, &ret.pError);
+		ret.n = Normalize(t(si.n));
+		ret.wo = Normalize(t(si.wo));
+		ret.time = si.time;
+		ret.mediumInterface = si.mediumInterface;
+		ret.uv = si.uv;
+		ret.shape = si.shape;
+		ret.primitive = si.primitive;
+		ret.dpdu = t(si.dpdu);
+		ret.dpdv = t(si.dpdv);
+		ret.dndu = t(si.dndu);
+		ret.dndv = t(si.dndv);
+		ret.shading.n = Normalize(t(si.shading.n));
+		ret.shading.dpdu = t(si.shading.dpdu);
+		ret.shading.dpdv = t(si.shading.dpdv);
+		ret.shading.dndu = t(si.shading.dndu);
+		ret.shading.dndv = t(si.shading.dndv);
+		ret.shading.n = Faceforward(ret.shading.n, ret.n);
+		ret.faceIndex = si.faceIndex;
+		return ret;
+	}
+
 	Bounds3f Transform::operator()(const Bounds3f & b) const
 	{
 		const Transform &M = *this;
-		Bounds3f ret(M(Point3f(b.pMin.x, b.pMin.y, b.pMin.z)));
-		ret = Union(ret, M(Point3f(b.pMax.x, b.pMin.y, b.pMin.z)));
-		ret = Union(ret, M(Point3f(b.pMin.x, b.pMax.y, b.pMin.z)));
-		ret = Union(ret, M(Point3f(b.pMin.x, b.pMin.y, b.pMax.z)));
-		ret = Union(ret, M(Point3f(b.pMin.x, b.pMax.y, b.pMax.z)));
-		ret = Union(ret, M(Point3f(b.pMax.x, b.pMax.y, b.pMin.z)));
-		ret = Union(ret, M(Point3f(b.pMax.x, b.pMin.y, b.pMax.z)));
-		ret = Union(ret, M(Point3f(b.pMax.x, b.pMax.y, b.pMax.z)));
+		if (!IsAffine())
+		{
+			// ͶӰʱֻܱ任8ǵ
+			Bounds3f ret(M(Point3f(b.pMin.x, b.pMin.y, b.pMin.z)));
+			ret = Union(ret, M(Point3f(b.pMax.x, b.pMin.y, b.pMin.z)));
+			ret = Union(ret, M(Point3f(b.pMin.x, b.pMax.y, b.pMin.z)));
+			ret = Union(ret, M(Point3f(b.pMin.x, b.pMin.y, b.pMax.z)));
+			ret = Union(ret, M(Point3f(b.pMin.x, b.pMax.y, b.pMax.z)));
+			ret = Union(ret, M(Point3f(b.pMax.x, b.pMax.y, b.pMin.z)));
+			ret = Union(ret, M(Point3f(b.pMax.x, b.pMin.y, b.pMax.z)));
+			ret = Union(ret, M(Point3f(b.pMax.x, b.pMax.y, b.pMax.z)));
+			return ret;
+		}
+
+		// Arvoķÿƽ m[i][j] * pMin[j]  m[i][j] * pMax[j]
+		// нСϴ֮͡ӷ˳任ǵʱͬFMAʱ8ǵĲλһ¡
+		Bounds3f ret;
+		for (int i = 0; i < 3; ++i)
+		{
+			Float lo[3], hi[3];
+			for (int j = 0; j < 3; ++j)
+			{
+				Float a = m.m[i][j] * b.pMin[j], c = m.m[i][j] * b.pMax[j];
+				lo[j] = std::min(a, c);
+				hi[j] = std::max(a, c);
+			}
+			ret.pMin[i] = lo[0] + lo[1] + lo[2] + m.m[i][3];
+			ret.pMax[i] = hi[0] + hi[1] + hi[2] + m.m[i][3];
+		}
 		return ret;
 	}
+
+
+	// ŵnԪ out = R * (x, y, z) + tRΪ3x3tΪƽƣͷΪ0
+	// SSE汾һδ43μصõ12floatųxyzĴŻȥ
+	// ӷ˳뵥任operator()һ£FMAʱλͬ
+	static void TransformTriples(const Float R[3][3], const Float t[3], const Float *in,
+		Float *out, size_t n)
+	{
+		size_t i = 0;
+#ifdef PBRT_HAVE_SSE
+		__m128 r[3][3], tr[3];
+		for (int a = 0; a < 3; ++a)
+		{
+			for (int b = 0; b < 3; ++b)
+				r[a][b] = _mm_set1_ps(R[a][b]);
+			tr[a] = _mm_set1_ps(t[a]);
+		}
+		for (; i + 4 <= n; i += 4)
+		{
+			const Float *src = in + 3 * i;
+			__m128 a = _mm_loadu_ps(src), b = _mm_loadu_ps(src + 4), c = _mm_loadu_ps(src + 8);
+
+			// a = x0 y0 z0 x1, b = y1 z1 x2 y2, c = z2 x3 y3 z3
+			__m128 x = _mm_shuffle_ps(a, _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2)), _MM_SHUFFLE(2, 0, 3, 0));
+			__m128 y = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)),
+				_mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+			__m128 z = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)),
+				_mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+
+			__m128 p[3];
+			for (int k = 0; k < 3; ++k)
+				p[k] = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(r[k][0], x), _mm_mul_ps(r[k][1], y)),
+					_mm_mul_ps(r[k][2], z)), tr[k]);
+
+			// ת x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3
+			a = _mm_shuffle_ps(_mm_shuffle_ps(p[0], p[1], _MM_SHUFFLE(0, 0, 0, 0)),
+				_mm_shuffle_ps(p[2], p[0], _MM_SHUFFLE(1, 1, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+			b = _mm_shuffle_ps(_mm_shuffle_ps(p[1], p[2], _MM_SHUFFLE(1, 1, 1, 1)),
+				_mm_shuffle_ps(p[0], p[1], _MM_SHUFFLE(2, 2, 2, 2)), _MM_SHUFFLE(2, 0, 2, 0));
+			c = _mm_shuffle_ps(_mm_shuffle_ps(p[2], p[0], _MM_SHUFFLE(3, 3, 2, 2)),
+				_mm_shuffle_ps(p[1], p[2], _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+			Float *dst = out + 3 * i;
+			_mm_storeu_ps(dst, a);
+			_mm_storeu_ps(dst + 4, b);
+			_mm_storeu_ps(dst + 8, c);
+		}
+#endif  // PBRT_HAVE_SSE
+		for (; i < n; ++i)
+		{
+			Float x = in[3 * i], y = in[3 * i + 1], z = in[3 * i + 2];
+			for (int k = 0; k < 3; ++k)
+				out[3 * i + k] = R[k][0] * x + R[k][1] * y + R[k][2] * z + t[k];
+		}
+	}
+
+	void Transform::TransformPoints(const Point3f * in, Point3f * out, size_t n) const
+	{
+		static_assert(sizeof(Point3f) == 3 * sizeof(Float), "Point3f must be tightly packed");
+		if (!IsAffine())
+		{
+			for (size_t i = 0; i < n; ++i)
+				out[i] = (*this)(in[i]);
+			return;
+		}
+		Float R[3][3], t[3];
+		for (int a = 0; a < 3; ++a)
+		{
+			for (int b = 0; b < 3; ++b)
+				R[a][b] = m.m[a][b];
+			t[a] = m.m[a][3];
+		}
+		TransformTriples(R, t, &in[0].x, &out[0].x, n);
+	}
+
+	void Transform::TransformVectors(const Vector3f * in, Vector3f * out, size_t n) const
+	{
+		static_assert(sizeof(Vector3f) == 3 * sizeof(Float), "Vector3f must be tightly packed");
+		Float R[3][3], t[3] = { 0, 0, 0 };
+		for (int a = 0; a < 3; ++a)
+			for (int b = 0; b < 3; ++b)
+				R[a][b] = m.m[a][b];
+		TransformTriples(R, t, &in[0].x, &out[0].x, n);
+	}
+
+	void Transform::TransformNormals(const Normal3f * in, Normal3f * out, size_t n) const
+	{
+		static_assert(sizeof(Normal3f) == 3 * sizeof(Float), "Normal3f must be tightly packed");
+		// ת
+		Float R[3][3], t[3] = { 0, 0, 0 };
+		for (int a = 0; a < 3; ++a)
+			for (int b = 0; b < 3; ++b)
+				R[a][b] = mInv.m[b][a];
+		TransformTriples(R, t, &in[0].x, &out[0].x, n);
+	}
+
+	// SoAߵı任operator()(const Ray &)ļȫͬԭطŲԭ㡢tMax
+	// ѭûзֱֻ֧ڷ任
+	static void TransformRaysSoA(const Matrix4x4 &M, Float *ox, Float *oy, Float *oz,
+		Float *dx, Float *dy, Float *dz, Float *tMax, size_t n)
+	{
+		const Float (*m)[4] = M.m;
+		const Float g3 = gamma(3);
+		for (size_t i = 0; i < n; ++i)
+		{
+			Float x = ox[i], y = oy[i], z = oz[i];
+			Float xp = (m[0][0] * x + m[0][1] * y) + (m[0][2] * z + m[0][3]);
+			Float yp = (m[1][0] * x + m[1][1] * y) + (m[1][2] * z + m[1][3]);
+			Float zp = (m[2][0] * x + m[2][1] * y) + (m[2][2] * z + m[2][3]);
+			Float ex = g3 * (std::abs(m[0][0] * x) + std::abs(m[0][1] * y) +
+				std::abs(m[0][2] * z) + std::abs(m[0][3]));
+			Float ey = g3 * (std::abs(m[1][0] * x) + std::abs(m[1][1] * y) +
+				std::abs(m[1][2] * z) + std::abs(m[1][3]));
+			Float ez = g3 * (std::abs(m[2][0] * x) + std::abs(m[2][1] * y) +
+				std::abs(m[2][2] * z) + std::abs(m[2][3]));
+
+			Float u = dx[i], v = dy[i], w = dz[i];
+			Float up = m[0][0] * u + m[0][1] * v + m[0][2] * w;
+			Float vp = m[1][0] * u + m[1][1] * v + m[1][2] * w;
+			Float wp = m[2][0] * u + m[2][1] * v + m[2][2] * w;
+
+			Float lengthSquared = up * up + vp * vp + wp * wp;
+			Float dt = (std::abs(up) * ex + std::abs(vp) * ey + std::abs(wp) * ez) / lengthSquared;
+			dt = lengthSquared > 0 ? dt : 0;
+
+			ox[i] = xp + up * dt;
+			oy[i] = yp + vp * dt;
+			oz[i] = zp + wp * dt;
+			dx[i] = up;
+			dy[i] = vp;
+			dz[i] = wp;
+			tMax[i] -= dt;
+		}
+	}
+
+	void Transform::TransformRays(const Ray * in, Ray * out, size_t n) const
+	{
+		if (!IsAffine())
+		{
+			for (size_t i = 0; i < n; ++i)
+				out[i] = (*this)(in[i]);
+			return;
+		}
+
+		// ÿȡһСתSoA任д
+		constexpr int ChunkSize = 16;
+		Float ox[ChunkSize], oy[ChunkSize], oz[ChunkSize];
+		Float dx[ChunkSize], dy[ChunkSize], dz[ChunkSize], tMax[ChunkSize];
+		for (size_t first = 0; first < n; first += ChunkSize)
+		{
+			int count = (int)std::min<size_t>(ChunkSize, n - first);
+			for (int i = 0; i < count; ++i)
+			{
+				const Ray &r = in[first + i];
+				ox[i] = r.o.x; oy[i] = r.o.y; oz[i] = r.o.z;
+				dx[i] = r.d.x; dy[i] = r.d.y; dz[i] = r.d.z;
+				tMax[i] = r.tMax;
+			}
+			TransformRaysSoA(m, ox, oy, oz, dx, dy, dz, tMax, count);
+			for (int i = 0; i < count; ++i)
+				out[first + i] = Ray(Point3f(ox[i], oy[i], oz[i]), Vector3f(dx[i], dy[i], dz[i]),
+					tMax[i], in[first + i].time);
+		}
+	}
+
+	void Transform::TransformRays(RayStream * stream) const
+	{
+		size_t n = stream->Size();
+		if (!IsAffine())
+		{
+			for (size_t i = 0; i < n; ++i)
+			{
+				Ray r = (*this)(stream->GetRay(i));
+				stream->ox[i] = r.o.x; stream->oy[i] = r.o.y; stream->oz[i] = r.o.z;
+				stream->dx[i] = r.d.x; stream->dy[i] = r.d.y; stream->dz[i] = r.d.z;
+				stream->tMax[i] = r.tMax;
+			}
+			return;
+		}
+		TransformRaysSoA(m, stream->ox.data(), stream->oy.data(), stream->oz.data(),
+			stream->dx.data(), stream->dy.data(), stream->dz.data(), stream->tMax.data(), n);
+	}
+
+	void Transform::TransformBounds(const Bounds3f * in, Bounds3f * out, size_t n) const
+	{
+		if (!IsAffine())
+		{
+			for (size_t i = 0; i < n; ++i)
+				out[i] = (*this)(in[i]);
+			return;
+		}
+#ifdef PBRT_HAVE_SSE
+		// ÿһзŽһĴһΧֻҪ3˷min/max
+		__m128 col[4];
+		for (int j = 0; j < 4; ++j)
+			col[j] = _mm_setr_ps(m.m[0][j], m.m[1][j], m.m[2][j], 0);
+		for (size_t i = 0; i < n; ++i)
+		{
+			const Bounds3f &b = in[i];
+			__m128 lo[3], hi[3];
+			for (int j = 0; j < 3; ++j)
+			{
+				__m128 a = _mm_mul_ps(col[j], _mm_set1_ps(b.pMin[j]));
+				__m128 c = _mm_mul_ps(col[j], _mm_set1_ps(b.pMax[j]));
+				lo[j] = _mm_min_ps(a, c);
+				hi[j] = _mm_max_ps(a, c);
+			}
+			__m128 pMin = _mm_add_ps(_mm_add_ps(_mm_add_ps(lo[0], lo[1]), lo[2]), col[3]);
+			__m128 pMax = _mm_add_ps(_mm_add_ps(_mm_add_ps(hi[0], hi[1]), hi[2]), col[3]);
+
+			// pMinд4floatḲpMax.xpMaxǣpMaxֻд3Խ
+			Float *dst = &out[i].pMin.x;
+			_mm_storeu_ps(dst, pMin);
+			_mm_storel_pi((__m64 *)(dst + 3), pMax);
+			_mm_store_ss(dst + 5, _mm_movehl_ps(pMax, pMax));
+		}
+#else
+		for (size_t i = 0; i < n; ++i)
+			out[i] = (*this)(in[i]);
+#endif  // PBRT_HAVE_SSE
+	}
+
 	bool Transform::SwapsHandedness() const
 	{
 		//Ͻ3x3ʽΪ˵ת仯ϵԡ
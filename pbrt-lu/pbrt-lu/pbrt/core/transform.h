@@ -4,8 +4,15 @@
 //#include "../pbrt.h"
 #include "geometry.h"
 
+#ifdef PBRT_HAVE_SSE
+#include <immintrin.h>
+#endif
+
 namespace pbrt
 {
+	class SurfaceInteraction;
+	class RayStream;
+
 	struct Matrix4x4
 	{
 		//ʼΪλ
@@ -36,9 +43,15 @@ namespace pbrt
 			return false;
 		}
 
+		// SSE/AVXʱSIMDʵ֣ͬScalar汾
 		static Matrix4x4 Transpose(const Matrix4x4 &);
 
-		static Matrix4x4 Mul(const Matrix4x4 &m1, const Matrix4x4 &m2) 
+		static Matrix4x4 Mul(const Matrix4x4 &m1, const Matrix4x4 &m2);
+
+		// οʵ֣УSIMD汾
+		static Matrix4x4 TransposeScalar(const Matrix4x4 &);
+
+		static Matrix4x4 MulScalar(const Matrix4x4 &m1, const Matrix4x4 &m2)
 		{
 			Matrix4x4 r;
 			for (int i = 0; i < 4; ++i)
@@ -48,9 +61,35 @@ namespace pbrt
 			return r;
 		}
 
+		// ȫԪGauss-JordanԪdouble㡣ʱfalse*mInv䡣
+		static bool Inverse(const Matrix4x4 &m, Matrix4x4 *mInv);
+
 		Float m[4][4];
 	};
 
+	// ĵi = sum_k m1[i][k] * (m2ĵk)m24зڼĴ︴á
+	// ӷ˳MulScalarͬͷļÿȳ˷
+	inline Matrix4x4 Matrix4x4::Mul(const Matrix4x4 &m1, const Matrix4x4 &m2)
+	{
+#if defined(PBRT_HAVE_SSE)
+		__m128 b0 = _mm_loadu_ps(m2.m[0]), b1 = _mm_loadu_ps(m2.m[1]);
+		__m128 b2 = _mm_loadu_ps(m2.m[2]), b3 = _mm_loadu_ps(m2.m[3]);
+		Matrix4x4 r;
+		for (int i = 0; i < 4; ++i)
+		{
+			__m128 row = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+				_mm_mul_ps(_mm_set1_ps(m1.m[i][0]), b0),
+				_mm_mul_ps(_mm_set1_ps(m1.m[i][1]), b1)),
+				_mm_mul_ps(_mm_set1_ps(m1.m[i][2]), b2)),
+				_mm_mul_ps(_mm_set1_ps(m1.m[i][3]), b3));
+			_mm_storeu_ps(r.m[i], row);
+		}
+		return r;
+#else
+		return MulScalar(m1, m2);
+#endif
+	}
+
 
 
 	class Transform
@@ -64,11 +103,78 @@ namespace pbrt
 
 		Transform(const Matrix4x4 &m, const Matrix4x4 &mInv) : m(m), mInv(mInv) {}
 
+		// Matrix4x4::Inversemʱfalse*t䣬ɵ߱
+		static bool FromMatrix(const Matrix4x4 &m, Transform *t);
+
+		const Matrix4x4 &GetMatrix() const { return m; }
+		const Matrix4x4 &GetInverseMatrix() const { return mInv; }
+
+		bool operator==(const Transform &t) const { return t.m == m && t.mInv == mInv; }
+		bool operator!=(const Transform &t) const { return t.m != m || t.mInv != mInv; }
+
+		bool IsIdentity() const { return m == Matrix4x4(); }
+
+		// t2*this
+		Transform operator*(const Transform &t2) const;
+
+		friend Transform Inverse(const Transform &t) { return Transform(t.mInv, t.m); }
+		friend Transform Transpose(const Transform &t)
+		{
+			return Transform(Matrix4x4::Transpose(t.m), Matrix4x4::Transpose(t.mInv));
+		}
+
 		Point3f operator()(const Point3f& p) const;
 
+		Vector3f operator()(const Vector3f &v) const;
+
+		// Ҫת任ܱƽ洹ֱ
+		Normal3f operator()(const Normal3f &n) const;
+
+		Ray operator()(const Ray &r) const;
+
 		Bounds3f operator()(const Bounds3f &b) const;
 
+		SurfaceInteraction operator()(const SurfaceInteraction &si) const;
+
+		// İ汾*pErrorر任ıظ
+		Point3f operator()(const Point3f &p, Vector3f *pError) const;
+
+		// pѾpErrorʱۼƺ
+		Point3f operator()(const Point3f &p, const Vector3f &pError,
+			Vector3f *pTransError) const;
+
+		Vector3f operator()(const Vector3f &v, Vector3f *vTransError) const;
+
+		Ray operator()(const Ray &r, Vector3f *oError, Vector3f *dError) const;
+
+		// 任operator()ͬinoutͬһ飨ԭر任
+		void TransformPoints(const Point3f *in, Point3f *out, size_t n) const;
+		void TransformVectors(const Vector3f *in, Vector3f *out, size_t n) const;
+		void TransformNormals(const Normal3f *in, Normal3f *out, size_t n) const;
+		void TransformRays(const Ray *in, Ray *out, size_t n) const;
+		void TransformBounds(const Bounds3f *in, Bounds3f *out, size_t n) const;
+
+		// SoAԭر任
+		void TransformRays(RayStream *stream) const;
+
+		// һ(0, 0, 0, 1)ûͶӰ
+		bool IsAffine() const
+		{
+			return m.m[3][0] == 0 && m.m[3][1] == 0 && m.m[3][2] == 0 && m.m[3][3] == 1;
+		}
+
 		bool SwapsHandedness() const;
 
 	};
+
+
+	Transform Translate(const Vector3f &delta);
+	Transform Scale(Float x, Float y, Float z);
+	// ǶȶԶΪλ
+	Transform RotateX(Float theta);
+	Transform RotateY(Float theta);
+	Transform RotateZ(Float theta);
+	Transform Rotate(Float theta, const Vector3f &axis);
+	// ռ䵽ռı任λposlook
+	Transform LookAt(const Point3f &pos, const Point3f &look, const Vector3f &up);
 }
\ No newline at end of file
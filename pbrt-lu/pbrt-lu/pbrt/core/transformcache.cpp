@@ -0,0 +1,147 @@
+#include "transformcache.h"
+
+#include <cstring>
+
+
+namespace pbrt
+{
+	// Ծ64ֽMurmurHash64Aɾϣ
+	static uint64_t HashMatrix(const Matrix4x4 &m)
+	{
+		// ȱȽΪ-0.0 == 0.0ߵֽȴͬÿԪؼ0.0f-0.0+0.0ȵľŻͬһͰ
+		Float canonical[4][4];
+		for (int i = 0; i < 4; ++i)
+			for (int j = 0; j < 4; ++j)
+				canonical[i][j] = m.m[i][j] + 0.0f;
+
+		const uint64_t mul = 0xc6a4a7935bd1e995ull;
+		const int r = 47;
+		const size_t len = sizeof(canonical);
+		uint64_t h = 0x5bd1e995ull ^ (len * mul);
+
+		const uint8_t *data = (const uint8_t *)canonical;
+		for (size_t i = 0; i < len; i += 8)
+		{
+			uint64_t k;
+			memcpy(&k, data + i, sizeof(k));
+			k *= mul;
+			k ^= k >> r;
+			k *= mul;
+			h ^= k;
+			h *= mul;
+		}
+		h ^= h >> r;
+		h *= mul;
+		h ^= h >> r;
+		return h;
+	}
+
+
+	TransformCache::TransformCache()
+		: hashTable(512, nullptr)
+	{
+	}
+
+	const Transform * TransformCache::Lookup(const Transform & t)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return &LookupLocked(t)->t;
+	}
+
+	void TransformCache::Lookup(const Transform & t, const Transform ** tCached, const Transform ** tCachedInv)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		Entry *entry = LookupLocked(t);
+		*tCached = &entry->t;
+		if (!tCachedInv)
+			return;
+		++nInverseLookups;
+		if (entry->inverse)
+			++nInverseHits;
+		else
+		{
+			Transform *tInv = arena.Alloc<Transform>(1, false);
+			new (tInv) Transform(Inverse(entry->t));
+			entry->inverse = tInv;
+		}
+		*tCachedInv = entry->inverse;
+	}
+
+	TransformCache::Entry * TransformCache::LookupLocked(const Transform & t)
+	{
+		++nLookups;
+		size_t mask = hashTable.size() - 1;
+		size_t offset = HashMatrix(t.GetMatrix()) & mask;
+		while (hashTable[offset])
+		{
+			if (hashTable[offset]->t == t)
+			{
+				++nHits;
+				return hashTable[offset];
+			}
+			offset = (offset + 1) & mask;
+		}
+
+		Entry *entry = arena.Alloc<Entry>(1, false);
+		new (entry) Entry{ t, nullptr };
+		hashTable[offset] = entry;
+
+		// سһݣ֤̽кܶ
+		if (++hashTableOccupancy * 2 > hashTable.size())
+			Grow();
+		return entry;
+	}
+
+	void TransformCache::Grow()
+	{
+		std::vector<Entry *> newTable(2 * hashTable.size(), nullptr);
+		size_t mask = newTable.size() - 1;
+		for (Entry *tEntry : hashTable)
+		{
+			if (!tEntry) continue;
+			size_t offset = HashMatrix(tEntry->t.GetMatrix()) & mask;
+			while (newTable[offset])
+				offset = (offset + 1) & mask;
+			newTable[offset] = tEntry;
+		}
+		hashTable.swap(newTable);
+	}
+
+	void TransformCache::Clear()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		// TransformƽģֱӸarenaڴ
+		hashTable.assign(512, nullptr);
+		hashTableOccupancy = 0;
+		arena.Reset();
+		nLookups = nHits = 0;
+		nInverseLookups = nInverseHits = 0;
+	}
+
+	TransformCacheStats TransformCache::GetStats() const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		TransformCacheStats stats;
+		stats.lookups = nLookups;
+		stats.hits = nHits;
+		stats.uniqueTransforms = (int64_t)hashTableOccupancy;
+		stats.inverseLookups = nInverseLookups;
+		stats.inverseHits = nInverseHits;
+		stats.arenaBytes = arena.TotalAllocated();
+		return stats;
+	}
+
+	void TransformCache::ReportStats(FILE * dest) const
+	{
+		TransformCacheStats stats = GetStats();
+		fprintf(dest, "Transform cache\n");
+		fprintf(dest, "    Lookups                          %12lld\n", (long long)stats.lookups);
+		fprintf(dest, "    Hits                             %12lld (%.2f%%)\n", (long long)stats.hits,
+			100. * stats.HitRate());
+		fprintf(dest, "    Unique transforms                %12lld\n", (long long)stats.uniqueTransforms);
+		fprintf(dest, "    Inverse lookups                  %12lld (%lld already computed)\n",
+			(long long)stats.inverseLookups, (long long)stats.inverseHits);
+		fprintf(dest, "    Arena memory                     %12.2f MiB\n", stats.arenaBytes / (1024. * 1024.));
+		fprintf(dest, "    Memory saved                     %12.2f MiB\n", stats.BytesSaved() / (1024. * 1024.));
+	}
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <vector>
+
+#include "memory.h"
+#include "transform.h"
+
+
+namespace pbrt
+{
+	struct TransformCacheStats
+	{
+		int64_t lookups = 0;
+		int64_t hits = 0;
+		int64_t uniqueTransforms = 0;
+		// 任Transformͬһռϣλ
+		int64_t inverseLookups = 0;
+		int64_t inverseHits = 0;
+		size_t arenaBytes = 0;
+
+		double HitRate() const { return lookups ? (double)hits / lookups : 0; }
+		// ÿжٴһTransform
+		size_t BytesSaved() const { return (size_t)(hits + inverseHits) * sizeof(Transform); }
+	};
+
+
+	// ͬTransformֻһݡShapeֻTransformָ룬ɻ渺ǵڣ
+	// صָClear()򻺴֮ǰһֱЧ̰߳ȫ
+	class TransformCache
+	{
+	public:
+		TransformCache();
+
+		const Transform *Lookup(const Transform &t);
+
+		// ͬʱt任ShapeObjectToWorld/WorldToObject
+		// 任һαҪʱŴtı֮ͬһֱӷ
+		void Lookup(const Transform &t, const Transform **tCached, const Transform **tCachedInv);
+
+		void Clear();
+
+		TransformCacheStats GetStats() const;
+		void ReportStats(FILE *dest) const;
+
+	private:
+		// һTransformͰ任ûҪʱΪnullptr
+		struct Entry
+		{
+			Transform t;
+			const Transform *inverse;
+		};
+
+		Entry *LookupLocked(const Transform &t);
+		void Grow();
+
+		mutable std::mutex mutex;
+		// Ŷַ̽Ĺϣ2
+		std::vector<Entry *> hashTable;
+		size_t hashTableOccupancy = 0;
+		MemoryArena arena;
+
+		int64_t nLookups = 0, nHits = 0;
+		int64_t nInverseLookups = 0, nInverseHits = 0;
+	};
+}
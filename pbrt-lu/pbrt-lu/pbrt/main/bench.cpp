@@ -0,0 +1,1014 @@
+// ΢׼ԣΡ任㹹졢״󽻺ͳļֽЩȵĺ
+// ù̶ɣÿжһдJSONȽϲͬ汾ܱ֮仯
+
+#include "../pbrt.h"
+#include "../accelerators/bvh.h"
+#include "../accelerators/widebvh.h"
+#include "../core/geometry.h"
+#include "../core/interaction.h"
+#include "../core/memory.h"
+#include "../core/parser.h"
+#include "../core/primitive.h"
+#include "../core/raypacket.h"
+#include "../core/transform.h"
+#include "../samplers/halton.h"
+#include "../samplers/random.h"
+#include "../samplers/sobol.h"
+#include "../shapes/sphere.h"
+#include "../shapes/triangle.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+using namespace pbrt;
+
+
+struct BenchOptions
+{
+	std::string filter;
+	std::string jsonFile;
+	double minTime = 0.1;   // ÿμʱе
+	int repetitions = 5;
+	uint64_t seed = 1;
+	bool list = false;
+};
+
+static void Usage(const char *msg = nullptr)
+{
+	if (msg)
+		fprintf(stderr, "pbrt-lu-bench: %s\n\n", msg);
+	fprintf(stderr, R"(usage: pbrt-lu-bench [<options>]
+  --help               Print this help text.
+  --list               List the benchmark names and exit.
+  --filter <text>      Only run benchmarks whose name contains <text>.
+  --json <file>        Also write the results as JSON ("-" for stdout).
+  --mintime <seconds>  Minimum duration of one timed run (default 0.1).
+  --repetitions <num>  Timed runs per benchmark; the median is reported (default 5).
+  --seed <num>         Seed for the random inputs (default 1).
+)");
+	exit(msg ? 1 : 0);
+}
+
+
+// ֹѽûõļɾͬGoogle BenchmarkDoNotOptimize
+template <typename T>
+static inline void DoNotOptimize(const T &value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	asm volatile("" : : "r,m"(value) : "memory");
+#else
+	static const volatile char *sink;
+	sink = &reinterpret_cast<const volatile char &>(value);
+	_ReadWriteBarrier();
+#endif
+}
+
+// ƽ̨޹ص<random>ķֲͬ׼Ľһ
+struct BenchRNG
+{
+	explicit BenchRNG(uint64_t seed) : state(seed * 2862933555777941757ULL + 3037000493ULL) {}
+	Float Uniform()
+	{
+		state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+		return (Float)((state >> 40) * (1.0 / 16777216.0));
+	}
+	Float Uniform(Float a, Float b) { return a + (b - a) * Uniform(); }
+	Point3f UniformPoint(Float a, Float b) { return Point3f(Uniform(a, b), Uniform(a, b), Uniform(a, b)); }
+	Vector3f UniformVector(Float a, Float b) { return Vector3f(Uniform(a, b), Uniform(a, b), Uniform(a, b)); }
+	uint64_t state;
+};
+
+// ĸȡ2Ա&ơܷŽL1/L2ǼǷô
+static const int InputCount = 1024;
+static const int InputMask = InputCount - 1;
+
+static Vector3f RandomDirection(BenchRNG &rng)
+{
+	Vector3f d;
+	do
+	{
+		d = rng.UniformVector(-1, 1);
+	} while (d.LengthSquared() < 1e-4f || d.LengthSquared() > 1);
+	return Normalize(d);
+}
+
+static Bounds3f RandomBounds(BenchRNG &rng, Float extent)
+{
+	Point3f p = rng.UniformPoint(-extent, extent);
+	return Union(Bounds3f(p), p + rng.UniformVector(0.1f, 2));
+}
+
+static Transform RandomTransform(BenchRNG &rng)
+{
+	return Translate(rng.UniformVector(-10, 10)) * Rotate(rng.Uniform(0, 360), RandomDirection(rng)) *
+		Scale(rng.Uniform(0.5f, 2), rng.Uniform(0.5f, 2), rng.Uniform(0.5f, 2));
+}
+
+// [-20, 20]^3еλԭ㸽Լһܴ[-5, 5]^3
+static Ray RandomRay(BenchRNG &rng)
+{
+	Point3f o = rng.UniformPoint(-20, 20);
+	Point3f target = rng.UniformPoint(-5, 5);
+	return Ray(o, Normalize(target - o));
+}
+
+
+// һ׼ԣsetup׼룬صĺִnα
+// itemsPerOpһβԪظһΣÿԪصĺʱ
+typedef std::function<void(int64_t n)> BenchLoop;
+
+struct Benchmark
+{
+	std::string name;
+	std::function<BenchLoop(BenchRNG &rng)> setup;
+	int itemsPerOp;
+};
+
+static std::vector<Benchmark> &Registry()
+{
+	static std::vector<Benchmark> benchmarks;
+	return benchmarks;
+}
+
+static void AddBenchmark(const std::string &name, std::function<BenchLoop(BenchRNG &)> setup,
+	int itemsPerOp = 1)
+{
+	Registry().push_back(Benchmark{ name, std::move(setup), itemsPerOp });
+}
+
+
+static void RegisterGeometryBenchmarks()
+{
+	AddBenchmark("Bounds3::IntersectP", [](BenchRNG &rng) -> BenchLoop {
+		auto boxes = std::make_shared<std::vector<Bounds3f>>();
+		auto rays = std::make_shared<std::vector<Ray>>();
+		for (int i = 0; i < InputCount; ++i)
+		{
+			boxes->push_back(RandomBounds(rng, 5));
+			rays->push_back(RandomRay(rng));
+		}
+		return [=](int64_t n) {
+			for (int64_t i = 0; i < n; ++i)
+			{
+				Float t0, t1;
+				bool hit = (*boxes)[i & InputMask].IntersectP((*rays)[(i * 7) & InputMask], &t0, &t1);
+				DoNotOptimize(hit);
+			}
+		};
+	});
+
+	AddBenchmark("Bounds3::IntersectP/invDir", [](BenchRNG &rng) -> BenchLoop {
+		struct RayData
+		{
+			Ray ray;
+			Vector3f invDir;
+			int dirIsNeg[3];
+		};
+		auto boxes = std::make_shared<std::vector<Bounds3f>>();
+		auto rays = std::make_shared<std::vector<RayData>>();
+		for (int i = 0; i < InputCount; ++i)
+		{
+			boxes->push_back(RandomBounds(rng, 5));
+			RayData r;
+			r.ray = RandomRay(rng);
+			r.invDir = Vector3f(1 / r.ray.d.x, 1 / r.ray.d.y, 1 / r.ray.d.z);
+			r.dirIsNeg[0] = r.invDir.x < 0;
+			r.dirIsNeg[1] = r.invDir.y < 0;
+			r.dirIsNeg[2] = r.invDir.z < 0;
+			rays->push_back(r);
+		}
+		return [=](int64_t n) {
+			for (int64_t i = 0; i < n; ++i)
+			{
+				const RayData &r = (*rays)[(i * 7) & InputMask];
+				bool hit = (*boxes)[i & InputMask].IntersectP(r.ray, r.invDir, r.dirIsNeg);
+				DoNotOptimize(hit);
+			}
+		};
+	});
+
+	AddBenchmark("Union(Bounds3f, Bounds3f)", [](BenchRNG &rng) -> BenchLoop {
+		auto boxes = std::make_shared<std::vector<Bounds3f>>();
+		for (int i = 0; i < InputCount; ++i)
+			boxes->push_back(RandomBounds(rng, 10));
+		return [=](int64_t n) {
+			for (int64_t i = 0; i < n; ++i)
+			{
+				Bounds3f b = Union((*boxes)[i & InputMask], (*boxes)[(i + 1) & InputMask]);
+				DoNotOptimize(b);
+			}
+		};
+	});
+
+	AddBenchmark("Union(Bounds3f, Point3f)", [](BenchRNG &rng) -> BenchLoop {
+		auto boxes = std::make_shared<std::vector<Bounds3f>>();
+		auto points = std::make_shared<std::vector<Point3f>>();
+		for (int i = 0; i < InputCount; ++i)
+		{
+			boxes->push_back(RandomBounds(rng, 10));
+			points->push_back(rng.UniformPoint(-10, 10));
+		}
+		return [=](int64_t n) {
+			for (int64_t i = 0; i < n; ++i)
+			{
+				Bounds3f b = Union((*boxes)[i & InputMask], (*points)[(i * 3) & InputMask]);
+				DoNotOptimize(b);
+			}
+		};
+	});
+
+	AddBenchmark("Cross", [](BenchRNG &rng) -> BenchLoop {
+		auto v = std::make_shared<std::vector<Vector3f>>();
+		for (int i = 0; i < InputCount; ++i)
+			v->push_back(rng.UniformVector(-1, 1));
+		return [=](int64_t n) {
+			for (int64_t i = 0; i < n; ++i)
+			{
+				Vector3f c = Cross((*v)[i & InputMask], (*v)[(i + 1) & InputMask]);
+				DoNotOptimize(c);
+			}
+		};
+	});
+
+	AddBenchmark("Normalize", [](BenchRNG &rng) -> BenchLoop {
+		auto v = std::make_shared<std::vector<Vector3f>>();
+		for (int i = 0; i < InputCount; ++i)
+			v->push_back(rng.UniformVector(-10, 10));
+		return [=](int64_t n) {
+			for (int64_t i = 0; i < n; ++i)
+			{
+				Vector3f c = Normalize((*v)[i & InputMask]);
+				DoNotOptimize(c);
+			}
+		};
+	});
+}
+
+
+static void RegisterTransformBenchmarks()
+{
+	AddBenchmark("Transform::operator()(Point3f)", [](BenchRNG &rng) -> BenchLoop {
+		auto transforms = std::make_shared<std::vector<Transform>>();
+		auto points = std::make_shared<std::vector<Point3f>>();
+		for (int i = 0; i < 16; ++i)
+			transforms->push_back(RandomTransform(rng));
+		for (int i = 0; i < InputCount; ++i)
+			points->push_back(rng.UniformPoint(-10, 10));
+		return [=](int64_t n) {
+			for (int64_t i = 0; i < n; ++i)
+			{
+				Point3f p = (*transforms)[i & 15]((*points)[i & InputMask]);
+				DoNotOptimize(p);
+			}
+		};
+	});
+
+	AddBenchmark("Transform::operator()(Bounds3f)", [](BenchRNG &rng) -> BenchLoop {
+		auto transforms = std::make_shared<std::vector<Transform>>();
+		auto boxes = std::make_shared<std::vector<Bounds3f>>();
+		for (int i = 0; i < 16; ++i)
+			transforms->push_back(RandomTransform(rng));
+		for (int i = 0; i < InputCount; ++i)
+			boxes->push_back(RandomBounds(rng, 10));
+		return [=](int64_t n) {
+			for (int64_t i = 0; i < n; ++i)
+			{
+				Bounds3f b = (*transforms)[i & 15]((*boxes)[i & InputMask]);
+				DoNotOptimize(b);
+			}
+		};
+	});
+
+	// 汾һα任InputCountÿĺʱ
+	AddBenchmark("Transform::TransformPoints", [](BenchRNG &rng) -> BenchLoop {
+		auto transform = std::make_shared<Transform>(RandomTransform(rng));
+		auto in = std::make_shared<std::vector<Point3f>>();
+		auto out = std::make_shared<std::vector<Point3f>>(InputCount);
+		for (int i = 0; i < InputCount; ++i)
+			in->push_back(rng.UniformPoint(-10, 10));
+		return [=](int64_t n) {
+			for (int64_t i = 0; i < n; ++i)
+			{
+				transform->TransformPoints(in->data(), out->data(), InputCount);
+				DoNotOptimize((*out)[0]);
+			}
+		};
+	}, InputCount);
+
+	AddBenchmark("Transform::TransformBounds", [](BenchRNG &rng) -> BenchLoop {
+		auto transform = std::make_shared<Transform>(RandomTransform(rng));
+		auto in = std::make_shared<std::vector<Bounds3f>>();
+		auto out = std::make_shared<std::vector<Bounds3f>>(InputCount);
+		for (int i = 0; i < InputCount; ++i)
+			in->push_back(RandomBounds(rng, 10));
+		return [=](int64_t n) {
+			for (int64_t i = 0; i < n; ++i)
+			{
+				transform->TransformBounds(in->data(), out->data(), InputCount);
+				DoNotOptimize((*out)[0]);
+			}
+		};
+	}, InputCount);
+
+	AddBenchmark("Matrix4x4::Mul", [](BenchRNG &rng) -> BenchLoop {
+		auto m = std::make_shared<std::vector<Matrix4x4>>();
+		for (int i = 0; i < 64; ++i)
+			m->push_back(RandomTransform(rng).GetMatrix());
+		return [=](int64_t n) {
+			for (int64_t i = 0; i < n; ++i)
+			{
+				Matrix4x4 r = Matrix4x4::Mul((*m)[i & 63], (*m)[(i + 1) & 63]);
+				DoNotOptimize(r);
+			}
+		};
+	});
+
+	AddBenchmark("Matrix4x4::MulScalar", [](BenchRNG &rng) -> BenchLoop {
+		auto m = std::make_shared<std::vector<Matrix4x4>>();
+		for (int i = 0; i < 64; ++i)
+			m->push_back(RandomTransform(rng).GetMatrix());
+		return [=](int64_t n) {
+			for (int64_t i = 0; i < n; ++i)
+			{
+				Matrix4x4 r = Matrix4x4::MulScalar((*m)[i & 63], (*m)[(i + 1) & 63]);
+				DoNotOptimize(r);
+			}
+		};
+	});
+}
+
+
+static void RegisterInteractionBenchmarks()
+{
+	AddBenchmark("SurfaceInteraction::SurfaceInteraction", [](BenchRNG &rng) -> BenchLoop {
+		struct Input
+		{
+			Point3f p;
+			Vector3f pError, wo, dpdu, dpdv;
+			Point2f uv;
+		};
+		auto inputs = std::make_shared<std::vector<Input>>();
+		for (int i = 0; i < InputCount; ++i)
+		{
+			Input in;
+			in.p = rng.UniformPoint(-10, 10);
+			in.pError = rng.UniformVector(0, 1e-5f);
+			in.wo = RandomDirection(rng);
+			in.dpdu = rng.UniformVector(-1, 1);
+			in.dpdv = rng.UniformVector(-1, 1);
+			in.uv = Point2f(rng.Uniform(), rng.Uniform());
+			inputs->push_back(in);
+		}
+		return [=](int64_t n) {
+			for (int64_t i = 0; i < n; ++i)
+			{
+				const Input &in = (*inputs)[i & InputMask];
+				SurfaceInteraction si(in.p, in.pError, in.uv, in.wo, in.dpdu, in.dpdv,
+					Normal3f(), Normal3f(), 0, nullptr);
+				DoNotOptimize(si);
+			}
+		};
+	});
+}
+
+
+// ȡһһ飨16 x 16ıȽ
+static void RegisterSamplerBenchmarks()
+{
+	struct SamplerFactory
+	{
+		const char *name;
+		std::function<Sampler *()> create;
+	};
+	static const SamplerFactory factories[] = {
+		{ "SobolSampler", []() -> Sampler * { return new SobolSampler; } },
+		{ "HaltonSampler", []() -> Sampler * { return new HaltonSampler(Point2i(1920, 1080)); } },
+		{ "RandomSampler", []() -> Sampler * { return new RandomSampler; } },
+	};
+	for (const SamplerFactory &factory : factories)
+	{
+		std::function<Sampler *()> create = factory.create;
+		AddBenchmark(std::string(factory.name) + "::GetPixel2D", [create](BenchRNG &) -> BenchLoop {
+			std::shared_ptr<Sampler> sampler(create());
+			return [=](int64_t n) {
+				for (int64_t i = 0; i < n; ++i)
+				{
+					// ߹16 x 16Ŀ飬ÿȡһ
+					sampler->StartPixelSample(Point2i((int)(i & 15), (int)((i >> 4) & 15)), i >> 8);
+					DoNotOptimize(sampler->GetPixel2D());
+				}
+			};
+		});
+
+		const int TileSize = 16;
+		AddBenchmark(std::string(factory.name) + "::GeneratePixel2DBatch (16x16 tile)",
+			[create](BenchRNG &) -> BenchLoop {
+			std::shared_ptr<Sampler> sampler(create());
+			auto u = std::make_shared<std::vector<Float>>(TileSize * TileSize);
+			auto v = std::make_shared<std::vector<Float>>(TileSize * TileSize);
+			Bounds2i tile;
+			tile.pMin = Point2i(0, 0);
+			tile.pMax = Point2i(TileSize, TileSize);
+			return [=](int64_t n) {
+				for (int64_t i = 0; i < n; ++i)
+				{
+					sampler->GeneratePixel2DBatch(tile, i, u->data(), v->data());
+					DoNotOptimize((*u)[0]);
+				}
+			};
+		}, TileSize * TileSize);
+	}
+}
+
+
+static void RegisterParserBenchmarks()
+{
+	// ͳļĶһոֿġ%gʽ
+	auto makeText = [](BenchRNG &rng) {
+		std::string text;
+		char buf[32];
+		for (int i = 0; i < InputCount; ++i)
+		{
+			snprintf(buf, sizeof(buf), "%.6g ", rng.Uniform(-100, 100));
+			text += buf;
+		}
+		return std::make_shared<std::string>(text);
+	};
+
+	AddBenchmark("ScanFloat", [=](BenchRNG &rng) -> BenchLoop {
+		std::shared_ptr<std::string> text = makeText(rng);
+		return [=](int64_t n) {
+			const char *end = text->data() + text->size();
+			for (int64_t i = 0; i < n; ++i)
+			{
+				Float sum = 0, v;
+				for (const char *p = text->data(); p < end; ++p)
+				{
+					p = ScanFloat(p, end, &v);
+					sum += v;
+				}
+				DoNotOptimize(sum);
+			}
+		};
+	}, InputCount);
+
+	AddBenchmark("strtof", [=](BenchRNG &rng) -> BenchLoop {
+		std::shared_ptr<std::string> text = makeText(rng);
+		return [=](int64_t n) {
+			const char *end = text->data() + text->size();
+			for (int64_t i = 0; i < n; ++i)
+			{
+				Float sum = 0;
+				for (const char *p = text->data(); p < end; ++p)
+				{
+					char *next;
+					sum += strtof(p, &next);
+					p = next;
+				}
+				DoNotOptimize(sum);
+			}
+		};
+	}, InputCount);
+}
+
+// һ[-5, 5]^3õС
+static std::shared_ptr<TriangleMesh> RandomTriangleSoup(BenchRNG &rng, int nTriangles)
+{
+	std::vector<Point3f> P;
+	std::vector<int> indices;
+	for (int i = 0; i < nTriangles; ++i)
+	{
+		Point3f c = rng.UniformPoint(-5, 5);
+		for (int j = 0; j < 3; ++j)
+		{
+			P.push_back(c + rng.UniformVector(-0.5f, 0.5f));
+			indices.push_back(3 * i + j);
+		}
+	}
+	return std::make_shared<TriangleMesh>(Transform(), nTriangles, indices.data(), (int)P.size(),
+		P.data(), nullptr, nullptr);
+}
+
+static void RegisterShapeBenchmarks()
+{
+	struct SphereScene
+	{
+		std::vector<Transform> objectToWorld, worldToObject;
+		std::vector<std::unique_ptr<Sphere>> spheres;
+		AlignedVector<SphereBatch<SphereBatchWidth>> batches;   // ͬ16
+		std::vector<Ray> rays;
+	};
+	// 16任򣬱任֮ǰźãָֻ
+	auto makeSpheres = [](BenchRNG &rng) {
+		auto scene = std::make_shared<SphereScene>();
+		for (int i = 0; i < 16; ++i)
+		{
+			scene->objectToWorld.push_back(Translate(rng.UniformVector(-3, 3)));
+			scene->worldToObject.push_back(Inverse(scene->objectToWorld.back()));
+		}
+		for (int i = 0; i < 16; ++i)
+			scene->spheres.emplace_back(new Sphere(&scene->objectToWorld[i], &scene->worldToObject[i],
+				false, rng.Uniform(0.5f, 2), -2, 2, 360));
+		scene->batches.resize(16 / SphereBatchWidth);
+		for (int i = 0; i < 16; ++i)
+			scene->batches[i / SphereBatchWidth].Set(i % SphereBatchWidth, scene->objectToWorld[i](Point3f(0, 0, 0)),
+				scene->spheres[i]->radius);
+		for (int i = 0; i < InputCount; ++i)
+			scene->rays.push_back(RandomRay(rng));
+		return scene;
+	};
+
+	AddBenchmark("Sphere::Intersect", [=](BenchRNG &rng) -> BenchLoop {
+		auto scene = makeSpheres(rng);
+		return [=](int64_t n) {
+			for (int64_t i = 0; i < n; ++i)
+			{
+				Float tHit;
+				SurfaceInteraction isect;
+				bool hit = scene->spheres[i & 15]->Intersect(scene->rays[i & InputMask], &tHit, &isect);
+				DoNotOptimize(hit);
+				DoNotOptimize(isect);
+			}
+		};
+	});
+
+	AddBenchmark("Sphere::IntersectP", [=](BenchRNG &rng) -> BenchLoop {
+		auto scene = makeSpheres(rng);
+		return [=](int64_t n) {
+			for (int64_t i = 0; i < n; ++i)
+			{
+				bool hit = scene->spheres[i & 15]->IntersectP(scene->rays[i & InputMask]);
+				DoNotOptimize(hit);
+			}
+		};
+	});
+
+	// ͬһߣһβһÿĺʱֱӺSphere::IntersectPȽ
+	AddBenchmark("IntersectSphereBatch<" + std::to_string(SphereBatchWidth) + ">", [=](BenchRNG &rng) -> BenchLoop {
+		auto scene = makeSpheres(rng);
+		const int nBatches = 16 / SphereBatchWidth;
+		return [=](int64_t n) {
+			for (int64_t i = 0; i < n; ++i)
+			{
+				Float tHit;
+				int lane = IntersectSphereBatch(scene->batches[i % nBatches], scene->rays[(i / nBatches) & InputMask],
+					std::numeric_limits<Float>::infinity(), &tHit);
+				DoNotOptimize(lane);
+			}
+		};
+	}, SphereBatchWidth);
+
+	AddBenchmark("Triangle::Intersect", [](BenchRNG &rng) -> BenchLoop {
+		auto mesh = RandomTriangleSoup(rng, InputCount);
+		auto rays = std::make_shared<std::vector<Ray>>();
+		for (int i = 0; i < InputCount; ++i)
+			rays->push_back(RandomRay(rng));
+		return [=](int64_t n) {
+			for (int64_t i = 0; i < n; ++i)
+			{
+				Float tHit, b[3];
+				bool hit = Triangle(mesh.get(), (int)(i & InputMask)).Intersect((*rays)[(i >> 10) & InputMask],
+					&tHit, b);
+				DoNotOptimize(hit);
+			}
+		};
+	});
+
+	// ͬһκߣһβһ飬ÿεĺʱֱӺͱ汾Ƚ
+	AddBenchmark("IntersectTriangleGroup<" + std::to_string(TriangleGroupWidth) + ">", [](BenchRNG &rng) -> BenchLoop {
+		typedef TriangleGroup<TriangleGroupWidth> Group;
+		const int nGroups = InputCount / TriangleGroupWidth;
+		auto mesh = RandomTriangleSoup(rng, InputCount);
+		auto groups = std::make_shared<AlignedVector<Group>>(nGroups);
+		for (int f = 0; f < InputCount; ++f)
+		{
+			const int *v = &mesh->vertexIndices[3 * f];
+			(*groups)[f / TriangleGroupWidth].Set(f % TriangleGroupWidth, mesh->p[v[0]], mesh->p[v[1]],
+				mesh->p[v[2]], f);
+		}
+		auto rays = std::make_shared<std::vector<WatertightRay>>();
+		for (int i = 0; i < InputCount; ++i)
+			rays->push_back(WatertightRay(RandomRay(rng)));
+		return [=](int64_t n) {
+			for (int64_t i = 0; i < n; ++i)
+			{
+				Float tHit, b[3];
+				int lane = IntersectTriangleGroup((*groups)[i % nGroups], (*rays)[(i / nGroups) & InputMask],
+					std::numeric_limits<Float>::infinity(), &tHit, b);
+				DoNotOptimize(lane);
+			}
+		};
+	}, TriangleGroupWidth);
+
+	struct MeshScene
+	{
+		std::unique_ptr<TriangleMeshShape> shape;
+		std::vector<Ray> rays;
+	};
+	auto makeMesh = [](BenchRNG &rng) {
+		auto scene = std::make_shared<MeshScene>();
+		scene->shape.reset(new TriangleMeshShape(RandomTriangleSoup(rng, 100000)));
+		for (int i = 0; i < InputCount; ++i)
+			scene->rays.push_back(RandomRay(rng));
+		return scene;
+	};
+
+	AddBenchmark("TriangleMeshShape::Intersect", [=](BenchRNG &rng) -> BenchLoop {
+		auto scene = makeMesh(rng);
+		return [=](int64_t n) {
+			for (int64_t i = 0; i < n; ++i)
+			{
+				Float tHit;
+				SurfaceInteraction isect;
+				bool hit = scene->shape->Intersect(scene->rays[i & InputMask], &tHit, &isect);
+				DoNotOptimize(hit);
+				DoNotOptimize(isect);
+			}
+		};
+	});
+
+	AddBenchmark("TriangleMeshShape::IntersectP", [=](BenchRNG &rng) -> BenchLoop {
+		auto scene = makeMesh(rng);
+		return [=](int64_t n) {
+			for (int64_t i = 0; i < n; ++i)
+			{
+				bool hit = scene->shape->IntersectP(scene->rays[i & InputMask]);
+				DoNotOptimize(hit);
+			}
+		};
+	});
+
+	struct BVHScene
+	{
+		std::vector<Transform> objectToWorld, worldToObject;
+		std::shared_ptr<Aggregate> accel;
+		std::vector<Ray> rays;
+	};
+	// 4096СBVHǱҶͼԪ״ĵáBVHÿҶ4ͼԪ
+	// QBVHOBVHͬһߣҶӴСĬֱֵӱȽ
+	auto makeBVH = [](BenchRNG &rng, AccelType type) {
+		const int nSpheres = 4096;
+		auto scene = std::make_shared<BVHScene>();
+		for (int i = 0; i < nSpheres; ++i)
+		{
+			scene->objectToWorld.push_back(Translate(rng.UniformVector(-5, 5)));
+			scene->worldToObject.push_back(Inverse(scene->objectToWorld.back()));
+		}
+		std::vector<std::shared_ptr<Primitive>> prims;
+		for (int i = 0; i < nSpheres; ++i)
+			prims.push_back(std::make_shared<GeometricPrimitive>(std::make_shared<Sphere>(
+				&scene->objectToWorld[i], &scene->worldToObject[i], false, rng.Uniform(0.1f, 0.4f), -1, 1, 360)));
+		if (type == AccelType::BVH)
+			scene->accel = std::make_shared<BVHAccel>(std::move(prims), 4);
+		else
+			scene->accel = CreateAccel(type, std::move(prims));
+		for (int i = 0; i < InputCount; ++i)
+			scene->rays.push_back(RandomRay(rng));
+		return scene;
+	};
+
+	const std::pair<AccelType, std::string> accels[] = {
+		{ AccelType::BVH, "BVHAccel" }, { AccelType::QBVH, "QBVHAccel" }, { AccelType::OBVH, "OBVHAccel" }
+	};
+	for (const auto &accel : accels)
+	{
+		AccelType type = accel.first;
+		AddBenchmark(accel.second + "::IntersectHit (spheres)", [=](BenchRNG &rng) -> BenchLoop {
+			auto scene = makeBVH(rng, type);
+			return [=](int64_t n) {
+				for (int64_t i = 0; i < n; ++i)
+				{
+					Ray ray = scene->rays[i & InputMask];
+					SurfaceHit hit;
+					bool found = scene->accel->IntersectHit(ray, &hit);
+					DoNotOptimize(found);
+				}
+			};
+		});
+	}
+
+	for (const auto &accel : accels)
+	{
+		AccelType type = accel.first;
+		AddBenchmark(accel.second + "::IntersectP (spheres)", [=](BenchRNG &rng) -> BenchLoop {
+			auto scene = makeBVH(rng, type);
+			return [=](int64_t n) {
+				for (int64_t i = 0; i < n; ++i)
+				{
+					bool hit = scene->accel->IntersectP(scene->rays[i & InputMask]);
+					DoNotOptimize(hit);
+				}
+			};
+		});
+	}
+
+	// ߰ÿߴͬһͬһСصߡ
+	// ͬñ汾Աȣÿ߼ʱ
+	auto makePackets = [](BenchRNG &rng) {
+		auto packets = std::make_shared<AlignedVector<RayPacket>>(InputCount / RayPacket::MaxSize);
+		for (RayPacket &packet : *packets)
+		{
+			Point3f o = rng.UniformPoint(-20, 20);
+			Point3f target = rng.UniformPoint(-5, 5);
+			for (int i = 0; i < RayPacket::MaxSize; ++i)
+				packet.Add(Ray(o, Normalize(target + rng.UniformVector(-0.5f, 0.5f) - o)));
+		}
+		return packets;
+	};
+	const int64_t packetMask = InputCount / RayPacket::MaxSize - 1;
+
+	AddBenchmark("BVHAccel::IntersectPacket (spheres)", [=](BenchRNG &rng) -> BenchLoop {
+		auto scene = makeBVH(rng, AccelType::BVH);
+		auto packets = makePackets(rng);
+		return [=](int64_t n) {
+			RayPacket packet;
+			SurfaceInteraction isects[RayPacket::MaxSize];
+			for (int64_t i = 0; i < n; ++i)
+			{
+				packet = (*packets)[i & packetMask];
+				uint32_t hit = scene->accel->IntersectPacket(packet, packet.activeMask, isects);
+				DoNotOptimize(hit);
+			}
+		};
+	}, RayPacket::MaxSize);
+
+	AddBenchmark("BVHAccel::Intersect (spheres, packet rays)", [=](BenchRNG &rng) -> BenchLoop {
+		auto scene = makeBVH(rng, AccelType::BVH);
+		auto packets = makePackets(rng);
+		return [=](int64_t n) {
+			for (int64_t i = 0; i < n; ++i)
+			{
+				const RayPacket &packet = (*packets)[i & packetMask];
+				for (int j = 0; j < packet.size; ++j)
+				{
+					SurfaceInteraction isect;
+					bool hit = scene->accel->Intersect(packet.GetRay(j), &isect);
+					DoNotOptimize(hit);
+				}
+			}
+		};
+	}, RayPacket::MaxSize);
+
+	AddBenchmark("BVHAccel::IntersectPPacket (spheres)", [=](BenchRNG &rng) -> BenchLoop {
+		auto scene = makeBVH(rng, AccelType::BVH);
+		auto packets = makePackets(rng);
+		return [=](int64_t n) {
+			for (int64_t i = 0; i < n; ++i)
+			{
+				const RayPacket &packet = (*packets)[i & packetMask];
+				uint32_t occluded = scene->accel->IntersectPPacket(packet, packet.activeMask);
+				DoNotOptimize(occluded);
+			}
+		};
+	}, RayPacket::MaxSize);
+
+	AddBenchmark("BVHAccel::IntersectP (spheres, packet rays)", [=](BenchRNG &rng) -> BenchLoop {
+		auto scene = makeBVH(rng, AccelType::BVH);
+		auto packets = makePackets(rng);
+		return [=](int64_t n) {
+			for (int64_t i = 0; i < n; ++i)
+			{
+				const RayPacket &packet = (*packets)[i & packetMask];
+				for (int j = 0; j < packet.size; ++j)
+				{
+					bool hit = scene->accel->IntersectP(packet.GetRay(j));
+					DoNotOptimize(hit);
+				}
+			}
+		};
+	}, RayPacket::MaxSize);
+}
+
+
+struct BenchResult
+{
+	std::string name;
+	int64_t iterations;   // ÿμʱִеĲ
+	int itemsPerOp;
+	std::vector<double> nsPerOp;   // ÿμʱĽ
+	double Median() const
+	{
+		size_t n = nsPerOp.size();
+		return n % 2 ? nsPerOp[n / 2] : 0.5 * (nsPerOp[n / 2 - 1] + nsPerOp[n / 2]);
+	}
+	double Mean() const
+	{
+		double sum = 0;
+		for (double t : nsPerOp)
+			sum += t;
+		return sum / nsPerOp.size();
+	}
+	double Stddev() const
+	{
+		double mean = Mean(), sum = 0;
+		for (double t : nsPerOp)
+			sum += (t - mean) * (t - mean);
+		return nsPerOp.size() > 1 ? std::sqrt(sum / (nsPerOp.size() - 1)) : 0;
+	}
+};
+
+static double TimeLoop(const BenchLoop &loop, int64_t n)
+{
+	auto start = std::chrono::steady_clock::now();
+	loop(n);
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// ȰѲֱһ㹻ٰմԤȵǼβ
+static BenchResult RunBenchmark(const Benchmark &bench, const BenchOptions &options)
+{
+	BenchRNG rng(options.seed);
+	BenchLoop loop = bench.setup(rng);
+
+	int64_t n = 1;
+	double seconds = TimeLoop(loop, n);
+	while (seconds < 0.1 * options.minTime && n < (int64_t(1) << 40))
+	{
+		n *= 4;
+		seconds = TimeLoop(loop, n);
+	}
+	n = std::max<int64_t>(1, (int64_t)(n * options.minTime / std::max(seconds, 1e-9)));
+
+	BenchResult result;
+	result.name = bench.name;
+	result.iterations = n;
+	result.itemsPerOp = bench.itemsPerOp;
+	for (int r = 0; r < options.repetitions; ++r)
+		result.nsPerOp.push_back(TimeLoop(loop, n) * 1e9 / n);
+	std::sort(result.nsPerOp.begin(), result.nsPerOp.end());
+	return result;
+}
+
+
+static std::string JSONString(const std::string &s)
+{
+	std::string r = "\"";
+	for (char c : s)
+	{
+		if (c == '"' || c == '\\')
+			r += '\\';
+		r += c;
+	}
+	return r + "\"";
+}
+
+static std::string CompilerName()
+{
+#if defined(__clang__)
+	return std::string("clang ") + __clang_version__;
+#elif defined(__GNUC__)
+	return std::string("gcc ") + __VERSION__;
+#elif defined(_MSC_VER)
+	return "msvc " + std::to_string(_MSC_VER);
+#else
+	return "unknown";
+#endif
+}
+
+static bool WriteJSON(const std::string &name, const BenchOptions &options,
+	const std::vector<BenchResult> &results)
+{
+	FILE *fp = name == "-" ? stdout : fopen(name.c_str(), "w");
+	if (!fp)
+	{
+		fprintf(stderr, "pbrt-lu-bench: %s: unable to open for writing\n", name.c_str());
+		return false;
+	}
+
+	char date[32];
+	time_t now = time(nullptr);
+	strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+#if defined(PBRT_HAVE_AVX)
+	const char *simd = "avx";
+#elif defined(PBRT_HAVE_SSE)
+	const char *simd = "sse";
+#else
+	const char *simd = "none";
+#endif
+
+	fprintf(fp, "{\n  \"context\": {\n");
+	fprintf(fp, "    \"date\": %s,\n", JSONString(date).c_str());
+	fprintf(fp, "    \"compiler\": %s,\n", JSONString(CompilerName()).c_str());
+	fprintf(fp, "    \"simd\": \"%s\",\n", simd);
+	fprintf(fp, "    \"float_bits\": %d,\n", (int)(8 * sizeof(Float)));
+	fprintf(fp, "    \"seed\": %llu,\n", (unsigned long long)options.seed);
+	fprintf(fp, "    \"min_time\": %g,\n", options.minTime);
+	fprintf(fp, "    \"repetitions\": %d\n", options.repetitions);
+	fprintf(fp, "  },\n  \"benchmarks\": [");
+	for (size_t i = 0; i < results.size(); ++i)
+	{
+		const BenchResult &r = results[i];
+		fprintf(fp, "%s\n    {\n", i ? "," : "");
+		fprintf(fp, "      \"name\": %s,\n", JSONString(r.name).c_str());
+		fprintf(fp, "      \"iterations\": %lld,\n", (long long)r.iterations);
+		fprintf(fp, "      \"items_per_op\": %d,\n", r.itemsPerOp);
+		fprintf(fp, "      \"ns_per_op\": %.4f,\n", r.Median());
+		fprintf(fp, "      \"ns_per_op_min\": %.4f,\n", r.nsPerOp.front());
+		fprintf(fp, "      \"ns_per_op_mean\": %.4f,\n", r.Mean());
+		fprintf(fp, "      \"ns_per_op_stddev\": %.4f,\n", r.Stddev());
+		fprintf(fp, "      \"ns_per_item\": %.4f\n", r.Median() / r.itemsPerOp);
+		fprintf(fp, "    }");
+	}
+	fprintf(fp, "\n  ]\n}\n");
+
+	bool ok = !ferror(fp);
+	if (fp != stdout)
+		ok = (fclose(fp) == 0) && ok;
+	if (!ok)
+		fprintf(stderr, "pbrt-lu-bench: %s: error writing JSON\n", name.c_str());
+	return ok;
+}
+
+
+int main(int argc, char *argv[])
+{
+	BenchOptions options;
+	for (int i = 1; i < argc; ++i)
+	{
+		auto needs = [&](int n) {
+			if (i + n >= argc)
+				Usage((std::string("missing value after ") + argv[i]).c_str());
+		};
+		if (!strcmp(argv[i], "--help") || !strcmp(argv[i], "-h"))
+			Usage();
+		else if (!strcmp(argv[i], "--list"))
+			options.list = true;
+		else if (!strcmp(argv[i], "--filter"))
+		{
+			needs(1);
+			options.filter = argv[++i];
+		}
+		else if (!strcmp(argv[i], "--json"))
+		{
+			needs(1);
+			options.jsonFile = argv[++i];
+		}
+		else if (!strcmp(argv[i], "--mintime"))
+		{
+			needs(1);
+			options.minTime = atof(argv[++i]);
+		}
+		else if (!strcmp(argv[i], "--repetitions"))
+		{
+			needs(1);
+			options.repetitions = atoi(argv[++i]);
+		}
+		else if (!strcmp(argv[i], "--seed"))
+		{
+			needs(1);
+			options.seed = strtoull(argv[++i], nullptr, 10);
+		}
+		else
+			Usage((std::string("unknown option ") + argv[i]).c_str());
+	}
+	if (options.minTime <= 0 || options.repetitions <= 0)
+		Usage("mintime and repetitions must be positive");
+
+	RegisterGeometryBenchmarks();
+	RegisterTransformBenchmarks();
+	RegisterInteractionBenchmarks();
+	RegisterShapeBenchmarks();
+	RegisterSamplerBenchmarks();
+	RegisterParserBenchmarks();
+
+	// JSONдstdoutʱдstderrJSONһ
+	FILE *out = options.jsonFile == "-" ? stderr : stdout;
+	std::vector<BenchResult> results;
+	for (const Benchmark &bench : Registry())
+	{
+		if (!options.filter.empty() && bench.name.find(options.filter) == std::string::npos)
+			continue;
+		if (options.list)
+		{
+			printf("%s\n", bench.name.c_str());
+			continue;
+		}
+		results.push_back(RunBenchmark(bench, options));
+		const BenchResult &r = results.back();
+		fprintf(out, "%-42s %10.2f ns/op  (min %.2f, stddev %.2f", r.name.c_str(), r.Median(),
+			r.nsPerOp.front(), r.Stddev());
+		if (r.itemsPerOp > 1)
+			fprintf(out, ", %.3f ns/item", r.Median() / r.itemsPerOp);
+		fprintf(out, ")\n");
+		fflush(out);
+	}
+
+	if (!options.list && !options.jsonFile.empty())
+		return WriteJSON(options.jsonFile, options, results) ? 0 : 1;
+	return 0;
+}
@@ -0,0 +1,957 @@
+// ڣûдڣ߳ȾдͼʱͳϢ
+// ûʾLinuxȾ
+
+#include "../pbrt.h"
+#include "../core/geometry.h"
+#include "../core/interaction.h"
+#include "../core/adaptive.h"
+#include "../core/film.h"
+#include "../core/parallel.h"
+#include "../core/parser.h"
+#include "../core/primitive.h"
+#include "../core/profile.h"
+#include "../core/scenecache.h"
+#include "../core/stats.h"
+#include "../core/transform.h"
+#include "../core/transformcache.h"
+#include "../accelerators/bvh.h"
+#include "../accelerators/instance.h"
+#include "../accelerators/widebvh.h"
+#include "../samplers/halton.h"
+#include "../samplers/random.h"
+#include "../samplers/sobol.h"
+#include "../shapes/sphere.h"
+#include "../shapes/spherecloud.h"
+#include "../shapes/triangle.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace pbrt;
+
+
+struct Options
+{
+	int nThreads = 0;
+	std::string sceneName = "instances";
+	std::string sceneFile;   // Ϊʱpbrtļ򳡾湹
+	std::string writeCache;
+	AccelType accel = AccelType::BVH;
+	bool accelGiven = false;
+	// 滻
+	bool lookAt = false;
+	Point3f cameraPos, cameraLook;
+	Vector3f cameraUp;
+	Float fov = 0;
+	std::string outFile = "pbrt-lu.pfm";
+	int xResolution = 640, yResolution = 480;
+	int spp = 1;
+	std::string samplerName = "sobol";
+	int tileSize = 16;
+	int streamRows = 0;   // 0ʾͼڴ
+	// ֵʱԤ㲻Ϊ0ʱʹӦspp
+	Float noiseThreshold = 0;
+	double timeLimit = 0;   // 
+	AdaptiveSamplingOptions adaptive;
+	int sceneSize = 0;   // 0ʾóĬϹģ
+	bool quiet = false;
+	bool profile = false;
+	std::string traceFile;
+};
+
+static void Usage(const char *msg = nullptr)
+{
+	if (msg)
+		fprintf(stderr, "pbrt-lu: %s\n\n", msg);
+	fprintf(stderr, R"(usage: pbrt-lu [<options>] [<scene.pbrt>]
+Render options:
+  --help               Print this help text.
+  --nthreads <num>     Use specified number of threads for rendering (0 = all cores).
+  --outfile <name>     Write the final image to the given filename (.pfm or .ppm).
+  --quiet              Suppress all text output other than error messages.
+  --resolution <x> <y> Image resolution (default 640 480).
+  --sampler <name>     Sample generator: sobol (default), halton, random.
+  --spp <num>          Samples per pixel (default 1).
+  --streamrows <num>   Keep only this many image rows in memory and stream finished rows
+                       to the output file (default 0 = whole image).
+  --tilesize <num>     Edge length of the square tiles handed to threads (default 16).
+Adaptive sampling options (enabled by --noise or --timelimit; --spp is then ignored):
+  --noise <err>        Stop sampling a pixel once the relative standard error of its
+                       luminance is below err (e.g. 0.01).
+  --timelimit <sec>    Stop adding passes when the render time budget is used up.
+  --minspp <num>       Samples every pixel gets in the first pass (default 16).
+  --maxspp <num>       Upper limit on samples per pixel (default 1024).
+  --passspp <num>      Samples added to each unconverged pixel per pass (default 4).
+Profiling options:
+  --profile            Sample where CPU time goes and print a per-phase breakdown.
+  --trace <file.json>  Write a Chrome trace-event timeline of the coarse phases.
+Scene options:
+  --scene <name>       Built-in scene: instances (default), spheres, mesh, shapes.
+                       Ignored when a scene file is given.
+  --scenesize <num>    Number of instances / particles / torus segments / spheres.
+  --accel <name>       BVH over the shapes of the "shapes" scene and of scene files:
+                       bvh (default, binary), qbvh (4-wide), obvh (8-wide).
+  --writecache <file>  After building the scene from a scene file, write the built
+                       geometry and acceleration structures to a binary scene cache.
+                       Give the cache instead of the scene file to skip parsing and
+                       building on later runs.
+Camera options (override the scene's camera):
+  --lookat <ex> <ey> <ez> <lx> <ly> <lz> <ux> <uy> <uz>
+                       Camera position, look-at point and up vector.
+  --fov <degrees>      Field of view of the shorter image axis.
+)");
+	exit(msg ? 1 : 0);
+}
+
+
+// 򵥵
+struct Camera
+{
+	Camera(const Point3f &pos, const Point3f &look, const Vector3f &up, Float fovDegrees,
+		int xRes, int yRes)
+		: Camera(Inverse(LookAt(pos, look, up)), fovDegrees, xRes, yRes)
+	{
+	}
+
+	Camera(const Transform &cameraToWorld, Float fovDegrees, int xRes, int yRes)
+		: cameraToWorld(cameraToWorld), xRes(xRes), yRes(yRes)
+	{
+		Float aspect = (Float)xRes / (Float)yRes;
+		Float tanHalf = std::tan(fovDegrees * 0.5f * Pi / 180);
+		// fovӦ̱
+		sx = aspect > 1 ? tanHalf * aspect : tanHalf;
+		sy = aspect > 1 ? tanHalf : tanHalf / aspect;
+	}
+
+	Ray GenerateRay(Float px, Float py) const
+	{
+		Float x = (2 * px / xRes - 1) * sx;
+		Float y = (1 - 2 * py / yRes) * sy;
+		return cameraToWorld(Ray(Point3f(0, 0, 0), Normalize(Vector3f(x, y, 1))));
+	}
+
+	Transform cameraToWorld;
+	int xRes, yRes;
+	Float sx, sy;
+};
+
+
+struct Scene
+{
+	std::shared_ptr<Primitive> aggregate;
+	Point3f cameraPos, cameraLook;
+	// ļ任cameraPos/cameraLook
+	bool hasCameraToWorld = false;
+	Transform cameraToWorld;
+	// ӳʱ״ı任ָӳ
+	std::shared_ptr<MappedFile> cacheFile;
+	Float fov = 45;
+	int64_t primitiveCount = 0;
+	size_t bytes = 0;
+	const BVHBuildStats *buildStats = nullptr;
+	const char *accelName = nullptr;   // ͼԪBVHʱΪ
+};
+
+
+// 񣬴㷨ߺuv
+static std::shared_ptr<TriangleMesh> MakeTorus(const Transform &objectToWorld, Float R, Float r,
+	int nu, int nv)
+{
+	std::vector<Point3f> P;
+	std::vector<Normal3f> N;
+	std::vector<Point2f> UV;
+	std::vector<int> indices;
+	for (int j = 0; j <= nv; ++j)
+	{
+		for (int i = 0; i <= nu; ++i)
+		{
+			Float u = (Float)i / nu, v = (Float)j / nv;
+			Float phi = 2 * Pi * u, theta = 2 * Pi * v;
+			Vector3f radial(std::cos(phi), std::sin(phi), 0);
+			Normal3f n(radial * std::cos(theta) + Vector3f(0, 0, std::sin(theta)));
+			P.push_back(Point3f(0, 0, 0) + radial * R + Vector3f(n) * r);
+			N.push_back(n);
+			UV.push_back(Point2f(u, v));
+		}
+	}
+	for (int j = 0; j < nv; ++j)
+	{
+		for (int i = 0; i < nu; ++i)
+		{
+			int a = j * (nu + 1) + i, b = a + 1, c = a + nu + 1, d = c + 1;
+			int quad[6] = { a, b, d, a, d, c };
+			indices.insert(indices.end(), quad, quad + 6);
+		}
+	}
+	return std::make_shared<TriangleMesh>(objectToWorld, (int)indices.size() / 3, indices.data(),
+		(int)P.size(), P.data(), N.data(), UV.data());
+}
+
+// 򵥵Ŀɸÿιһ
+struct SceneRNG
+{
+	explicit SceneRNG(uint64_t seed) : state(seed * 2862933555777941757ULL + 3037000493ULL) {}
+	Float Uniform()
+	{
+		state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+		return (Float)((state >> 40) * (1.0 / 16777216.0));
+	}
+	uint64_t state;
+};
+
+static bool MakeScene(const Options &options, TransformCache *transformCache, Scene *scene)
+{
+	ProfilePhase _(Prof::SceneConstruction);
+	static const Transform identity;
+	SceneRNG rng(7);
+
+	if (options.sceneName == "mesh")
+	{
+		int n = options.sceneSize > 0 ? options.sceneSize : 512;
+		auto mesh = MakeTorus(RotateX(-60), 1, 0.4f, n, n / 2);
+		auto shape = std::make_shared<TriangleMeshShape>(mesh);
+		scene->aggregate = std::make_shared<GeometricPrimitive>(shape);
+		scene->primitiveCount = mesh->nTriangles;
+		scene->bytes = mesh->BytesUsed() + shape->BytesUsed();
+		scene->buildStats = &shape->GetBuildStats();
+		scene->cameraPos = Point3f(0, -4, 1.5f);
+		scene->cameraLook = Point3f(0, 0, 0);
+		return true;
+	}
+
+	if (options.sceneName == "spheres")
+	{
+		int n = options.sceneSize > 0 ? options.sceneSize : 1000000;
+		std::vector<Point3f> centers(n);
+		for (int i = 0; i < n; ++i)
+			centers[i] = Point3f(rng.Uniform() * 2 - 1, rng.Uniform() * 2 - 1, rng.Uniform() * 2 - 1);
+		Float radius = 0.5f / std::cbrt((Float)n);
+		auto cloud = SphereCloud::Create(centers, std::vector<Float>(1, radius));
+		if (!cloud)
+			return false;
+		scene->aggregate = std::make_shared<GeometricPrimitive>(cloud);
+		scene->primitiveCount = n;
+		scene->bytes = cloud->BytesUsed();
+		scene->buildStats = &cloud->GetBuildStats();
+		scene->cameraPos = Point3f(0.5f, -3, 1);
+		scene->cameraLook = Point3f(0, 0, 0);
+		return true;
+	}
+
+	if (options.sceneName == "instances")
+	{
+		// ԭͣɢڵϣ汾Ҳһʵ
+		int n = options.sceneSize > 0 ? options.sceneSize : 100000;
+		auto torus = MakeTorus(identity, 1, 0.3f, 64, 32);
+		auto torusShape = std::make_shared<TriangleMeshShape>(torus);
+		auto sphere = std::make_shared<Sphere>(&identity, &identity, false, 0.8f, -0.8f, 0.8f, 360.f);
+		Point3f groundP[4] = { Point3f(-1, -1, 0), Point3f(1, -1, 0), Point3f(1, 1, 0), Point3f(-1, 1, 0) };
+		int groundIndices[6] = { 0, 1, 2, 0, 2, 3 };
+		auto ground = std::make_shared<TriangleMesh>(identity, 2, groundIndices, 4, groundP, nullptr, nullptr);
+		std::vector<std::shared_ptr<Primitive>> prototypes = {
+			std::make_shared<GeometricPrimitive>(torusShape),
+			std::make_shared<GeometricPrimitive>(sphere),
+			std::make_shared<GeometricPrimitive>(std::make_shared<TriangleMeshShape>(ground))
+		};
+
+		Float extent = 2 * std::sqrt((Float)n);
+		std::vector<Instance> instances;
+		instances.reserve(n + 1);
+		auto addInstance = [&](const Transform &t, int prototype) {
+			Instance instance;
+			transformCache->Lookup(t, &instance.InstanceToWorld, &instance.WorldToInstance);
+			instance.prototype = prototype;
+			instances.push_back(instance);
+		};
+		addInstance(Scale(extent, extent, 1), 2);
+		for (int i = 0; i < n; ++i)
+		{
+			Float x = (rng.Uniform() * 2 - 1) * extent, y = (rng.Uniform() * 2 - 1) * extent;
+			Float s = 0.3f + 0.7f * rng.Uniform();
+			int prototype = rng.Uniform() < 0.7f ? 0 : 1;
+			Transform t = Translate(Vector3f(x, y, s * (prototype == 0 ? 0.3f : 0.8f))) *
+				RotateZ(360 * rng.Uniform()) * Scale(s, s, s);
+			addInstance(t, prototype);
+		}
+		auto tlas = std::make_shared<InstanceAccel>(std::move(prototypes), std::move(instances));
+		scene->aggregate = tlas;
+		scene->primitiveCount = tlas->NumInstances();
+		scene->bytes = tlas->BytesUsed() + torus->BytesUsed() + torusShape->BytesUsed();
+		scene->buildStats = &tlas->GetBuildStats();
+		scene->cameraPos = Point3f(0, -extent * 0.3f, 6);
+		scene->cameraLook = Point3f(0, 0, 0);
+		scene->fov = 60;
+		return true;
+	}
+
+	if (options.sceneName == "shapes")
+	{
+		// ÿһͼԪŽBVH--accelѡࣩ
+		int n = options.sceneSize > 0 ? options.sceneSize : 100000;
+		Float extent = std::cbrt((Float)n);
+		std::vector<std::shared_ptr<Primitive>> prims;
+		prims.reserve(n);
+		for (int i = 0; i < n; ++i)
+		{
+			Vector3f p((rng.Uniform() * 2 - 1) * extent, (rng.Uniform() * 2 - 1) * extent,
+				(rng.Uniform() * 2 - 1) * extent);
+			Float radius = 0.1f + 0.3f * rng.Uniform();
+			const Transform *o2w, *w2o;
+			transformCache->Lookup(Translate(p), &o2w, &w2o);
+			prims.push_back(std::make_shared<GeometricPrimitive>(
+				std::make_shared<Sphere>(o2w, w2o, false, radius, -radius, radius, 360.f)));
+		}
+		scene->aggregate = CreateAccel(options.accel, std::move(prims), &scene->buildStats);
+		scene->accelName = AccelTypeName(options.accel);
+		scene->primitiveCount = n;
+		scene->bytes = n * (sizeof(Sphere) + sizeof(GeometricPrimitive)) + scene->buildStats->treeBytes;
+		scene->cameraPos = Point3f(0, -3 * extent, extent);
+		scene->cameraLook = Point3f(0, 0, 0);
+		return true;
+	}
+
+	fprintf(stderr, "pbrt-lu: unknown scene \"%s\"\n", options.sceneName.c_str());
+	return false;
+}
+
+
+// ѽ״SceneGeometry֧trianglemeshsphere״͸Ͷʵ
+class SceneFileTarget : public ParserTarget
+{
+public:
+	SceneFileTarget(TransformCache *transformCache, SceneGeometry *geometry)
+		: transformCache(transformCache), geometry(geometry)
+	{
+	}
+
+	virtual void Camera(const std::string &name, const ParamSet &params, const Transform &cameraToWorld,
+		const FileLoc &loc)
+	{
+		if (name != "perspective")
+			fprintf(stderr, "%s: warning: camera \"%s\" is not supported, using perspective\n",
+				loc.ToString().c_str(), name.c_str());
+		geometry->hasCamera = true;
+		geometry->cameraToWorld = cameraToWorld;
+		geometry->fov = params.GetOneFloat("fov", 90);
+	}
+
+	virtual void Shape(const std::string &name, const ParamSet &params, const Transform &objectToWorld,
+		bool reverseOrientation, const FileLoc &loc)
+	{
+		SceneGeometry::ShapeEntry shape;
+		if (name == "trianglemesh")
+		{
+			shape.mesh = MakeTriangleMesh(params, objectToWorld, reverseOrientation, loc);
+			if (!shape.mesh)
+				return;
+		}
+		else if (name == "sphere")
+		{
+			const Transform *o2w, *w2o;
+			transformCache->Lookup(objectToWorld, &o2w, &w2o);
+			shape.radius = params.GetOneFloat("radius", 1);
+			shape.zMin = params.GetOneFloat("zmin", -shape.radius);
+			shape.zMax = params.GetOneFloat("zmax", shape.radius);
+			shape.phiMax = params.GetOneFloat("phimax", 360);
+			shape.sphere = std::make_shared<Sphere>(o2w, w2o, reverseOrientation, shape.radius, shape.zMin,
+				shape.zMax, shape.phiMax);
+		}
+		else
+		{
+			if (unsupportedShapes.insert(name).second)
+				fprintf(stderr, "%s: warning: shape \"%s\" is not supported and is ignored\n",
+					loc.ToString().c_str(), name.c_str());
+			return;
+		}
+		if (currentObject)
+			currentObject->push_back(std::move(shape));
+		else
+		{
+			worldShapes.push_back((int)geometry->shapes.size());
+			geometry->shapes.push_back(std::move(shape));
+		}
+	}
+
+	virtual void ObjectBegin(const std::string &name, const FileLoc &loc)
+	{
+		if (currentObject)
+			fprintf(stderr, "%s: error: ObjectBegin inside object \"%s\"\n", loc.ToString().c_str(),
+				currentObjectName.c_str());
+		objects[name].clear();
+		currentObject = &objects[name];
+		currentObjectName = name;
+	}
+
+	virtual void ObjectEnd(const FileLoc &loc)
+	{
+		if (!currentObject)
+			fprintf(stderr, "%s: error: ObjectEnd outside of an object\n", loc.ToString().c_str());
+		currentObject = nullptr;
+	}
+
+	virtual void ObjectInstance(const std::string &name, const Transform &instanceToWorld, const FileLoc &loc)
+	{
+		if (currentObject)
+		{
+			// InstanceAccelֻ֧һʵ
+			fprintf(stderr, "%s: error: ObjectInstance inside object \"%s\" is not supported\n",
+				loc.ToString().c_str(), currentObjectName.c_str());
+			return;
+		}
+		int prototype = GetPrototype(name);
+		if (prototype < 0)
+		{
+			fprintf(stderr, "%s: error: object \"%s\" is not defined or is empty\n", loc.ToString().c_str(),
+				name.c_str());
+			return;
+		}
+		Instance instance;
+		transformCache->Lookup(instanceToWorld, &instance.InstanceToWorld, &instance.WorldToInstance);
+		instance.prototype = prototype;
+		geometry->instances.push_back(instance);
+	}
+
+	// ڶ״ԭ
+	void Finish()
+	{
+		if (worldShapes.empty())
+			return;
+		geometry->worldPrototype = (int)geometry->prototypes.size();
+		geometry->prototypes.emplace_back();
+		geometry->prototypes.back().shapes = std::move(worldShapes);
+	}
+
+private:
+	std::shared_ptr<TriangleMeshShape> MakeTriangleMesh(const ParamSet &params, const Transform &objectToWorld,
+		bool reverseOrientation, const FileLoc &loc)
+	{
+		size_t nIndices, nP, nN, nUV;
+		const int *indices = params.GetIntArray("indices", &nIndices);
+		const Point3f *P = params.GetPoint3Array("P", &nP);
+		const Normal3f *N = params.GetNormal3Array("N", &nN);
+		const Point2f *UV = params.GetPoint2Array("uv", &nUV);
+		if (!UV)
+			UV = params.GetPoint2Array("st", &nUV);
+		if (!P)
+		{
+			fprintf(stderr, "%s: error: trianglemesh without \"point3 P\"\n", loc.ToString().c_str());
+			return nullptr;
+		}
+		// pbrt-v3ʡindices
+		static const int defaultIndices[3] = { 0, 1, 2 };
+		if (!indices && nP == 3)
+		{
+			indices = defaultIndices;
+			nIndices = 3;
+		}
+		if (!indices || nIndices % 3 != 0)
+		{
+			fprintf(stderr, "%s: error: trianglemesh needs a multiple of 3 \"integer indices\"\n",
+				loc.ToString().c_str());
+			return nullptr;
+		}
+		for (size_t i = 0; i < nIndices; ++i)
+		{
+			if (indices[i] < 0 || (size_t)indices[i] >= nP)
+			{
+				fprintf(stderr, "%s: error: trianglemesh index %d is out of range [0, %zu)\n",
+					loc.ToString().c_str(), indices[i], nP);
+				return nullptr;
+			}
+		}
+		if (N && nN != nP)
+		{
+			fprintf(stderr, "%s: warning: trianglemesh \"N\" and \"P\" sizes differ, ignoring \"N\"\n",
+				loc.ToString().c_str());
+			N = nullptr;
+		}
+		if (UV && nUV != nP)
+		{
+			fprintf(stderr, "%s: warning: trianglemesh \"uv\" and \"P\" sizes differ, ignoring \"uv\"\n",
+				loc.ToString().c_str());
+			UV = nullptr;
+		}
+		auto mesh = std::make_shared<TriangleMesh>(objectToWorld, (int)(nIndices / 3), indices, (int)nP, P, N, UV);
+		return std::make_shared<TriangleMeshShape>(mesh, reverseOrientation);
+	}
+
+	// ڵһʵʱųΪԭͣûõĶ󲻽볡
+	int GetPrototype(const std::string &name)
+	{
+		auto built = prototypeIndex.find(name);
+		if (built != prototypeIndex.end())
+			return built->second;
+		auto object = objects.find(name);
+		if (object == objects.end() || object->second.empty())
+			return -1;
+		SceneGeometry::Prototype prototype;
+		for (SceneGeometry::ShapeEntry &shape : object->second)
+		{
+			prototype.shapes.push_back((int)geometry->shapes.size());
+			geometry->shapes.push_back(std::move(shape));
+		}
+		objects.erase(object);
+		geometry->prototypes.push_back(std::move(prototype));
+		return prototypeIndex[name] = (int)geometry->prototypes.size() - 1;
+	}
+
+	TransformCache *transformCache;
+	SceneGeometry *geometry;
+	std::vector<int> worldShapes;
+	std::map<std::string, std::vector<SceneGeometry::ShapeEntry>> objects;
+	std::vector<SceneGeometry::ShapeEntry> *currentObject = nullptr;
+	std::string currentObjectName;
+	std::map<std::string, int> prototypeIndex;
+	std::set<std::string> unsupportedShapes;
+};
+
+// ļ߳棨ļͷı֣cacheFileΪʱѽõĳдɻ
+static bool LoadSceneFile(const Options &options, TransformCache *transformCache, Scene *scene)
+{
+	const std::string &filename = options.sceneFile, &cacheFile = options.writeCache;
+	SceneGeometry geometry;
+	if (IsSceneCacheFile(filename))
+	{
+		if (!ReadSceneCache(filename, &geometry))
+			return false;
+		if (options.accelGiven && options.accel != AccelType::BVH)
+			fprintf(stderr, "pbrt-lu: warning: %s holds prebuilt binary BVHs, ignoring --accel %s\n",
+				filename.c_str(), AccelTypeName(options.accel));
+	}
+	else
+	{
+		SceneFileTarget target(transformCache, &geometry);
+		if (!ParseFile(filename, &target))
+			return false;
+		target.Finish();
+		ProfilePhase _(Prof::SceneConstruction);
+		BuildSceneAggregates(&geometry, transformCache, options.accel);
+	}
+	if (!geometry.aggregate)
+	{
+		fprintf(stderr, "pbrt-lu: %s: the scene has no supported shapes\n", filename.c_str());
+		return false;
+	}
+	if (!cacheFile.empty() && !WriteSceneCache(cacheFile, geometry))
+		return false;
+
+	scene->aggregate = geometry.aggregate;
+	scene->primitiveCount = geometry.PrimitiveCount();
+	scene->bytes = geometry.BytesUsed();
+	if (geometry.instanceAccel)
+		scene->buildStats = &geometry.instanceAccel->GetBuildStats();
+	else
+		scene->buildStats = geometry.prototypes[geometry.worldPrototype].buildStats;
+	for (const SceneGeometry::Prototype &prototype : geometry.prototypes)
+		if (prototype.buildStats)
+			scene->accelName = prototype.bvh ? AccelTypeName(AccelType::BVH) : AccelTypeName(options.accel);
+	scene->hasCameraToWorld = geometry.hasCamera;
+	scene->cameraToWorld = geometry.cameraToWorld;
+	scene->fov = geometry.fov;
+	scene->cacheFile = geometry.cacheFile;
+	return true;
+}
+
+
+STAT_COUNTER("Integrator/Camera rays traced", nCameraRays);
+
+// ÿ߳ԼļȾϲ
+struct RenderCounters
+{
+	int64_t cameraRays = 0;
+	int64_t hits = 0;
+	int passes = 0;   // Ӧı
+};
+
+// ۹Դɫɫɫ߾Ϊ뷨߼нǵ
+static void Shade(const Ray &ray, const SurfaceInteraction &isect, Float rgb[3])
+{
+	ProfilePhase _(Prof::Shading);
+	Vector3f n = Normalize(Vector3f(isect.shading.n));
+	Float cosTheta = std::abs(Dot(n, Normalize(ray.d)));
+	rgb[0] = cosTheta * (0.5f + 0.5f * n.x);
+	rgb[1] = cosTheta * (0.5f + 0.5f * n.y);
+	rgb[2] = cosTheta * (0.5f + 0.5f * n.z);
+}
+
+static std::unique_ptr<Sampler> MakeSampler(const Options &options)
+{
+	if (options.samplerName == "sobol")
+		return std::unique_ptr<Sampler>(new SobolSampler);
+	if (options.samplerName == "halton")
+		return std::unique_ptr<Sampler>(new HaltonSampler(Point2i(options.xResolution, options.yResolution)));
+	if (options.samplerName == "random")
+		return std::unique_ptr<Sampler>(new RandomSampler);
+	return nullptr;
+}
+
+static bool UseAdaptiveSampling(const Options &options)
+{
+	return options.noiseThreshold > 0 || options.timeLimit > 0;
+}
+
+// ͼƽϵ(fx, fy)һߣrgbΪصɫ
+static void TraceCameraRay(const Scene &scene, const Camera &camera, Float fx, Float fy, Float rgb[3],
+	RenderCounters *c)
+{
+	Ray ray = camera.GenerateRay(fx, fy);
+	++c->cameraRays;
+	++nCameraRays;
+	SurfaceInteraction isect;
+	bool hit;
+	{
+		ProfilePhase p(Prof::SceneIntersect);
+		hit = scene.aggregate->Intersect(ray, &isect);
+	}
+	rgb[0] = rgb[1] = rgb[2] = 0;
+	if (hit)
+	{
+		++c->hits;
+		Shade(ray, isect, rgb);
+	}
+}
+
+// adaptiveΪʱÿزoptions.sppֻһָǷ
+static bool RenderTile(const Options &options, const Scene &scene, const Camera &camera, Sampler *sampler,
+	FilmTile *tile, AdaptiveSampling *adaptive, MemoryArena &arena, RenderCounters *c)
+{
+	const Bounds2i &bounds = tile->GetPixelBounds();
+	if (!adaptive)
+	{
+		// һصsλáÿصȻs˳ۼӡ
+		// ÿֻһʱȡ
+		size_t nPixels = (size_t)std::max(0, bounds.Area());
+		Float *u = arena.Alloc<Float>(nPixels, false), *v = arena.Alloc<Float>(nPixels, false);
+		std::fill(u, u + nPixels, 0.5f);
+		std::fill(v, v + nPixels, 0.5f);
+		for (int s = 0; s < options.spp; ++s)
+		{
+			if (options.spp > 1)
+				sampler->GeneratePixel2DBatch(bounds, s, u, v);
+			size_t i = 0;
+			for (int y = bounds.pMin.y; y < bounds.pMax.y; ++y)
+			{
+				for (int x = bounds.pMin.x; x < bounds.pMax.x; ++x, ++i)
+				{
+					Float rgb[3];
+					TraceCameraRay(scene, camera, x + u[i], y + v[i], rgb, c);
+					tile->AddSample(Point2i(x, y), rgb);
+				}
+			}
+		}
+		return nPixels > 0;
+	}
+
+	bool sampled = false;
+	for (int y = bounds.pMin.y; y < bounds.pMax.y; ++y)
+	{
+		for (int x = bounds.pMin.x; x < bounds.pMax.x; ++x)
+		{
+			Point2i pPixel(x, y);
+			int firstSample = adaptive->SampleCount(pPixel);
+			int nSamples = adaptive->SamplesThisPass(pPixel);
+			sampled |= nSamples > 0;
+			for (int s = firstSample; s < firstSample + nSamples; ++s)
+			{
+				sampler->StartPixelSample(pPixel, s);
+				Point2f uv = sampler->GetPixel2D();
+				Float rgb[3];
+				TraceCameraRay(scene, camera, x + uv.x, y + uv.y, rgb, c);
+				tile->AddSample(pPixel, rgb);
+				adaptive->AddSample(pPixel, rgb);
+			}
+		}
+	}
+	return sampled;
+}
+
+// FilmĶδϵȾÿȾдļ
+// ӦʱÿΰȾֱضֹͣһηֵʱ
+static bool Render(const Options &options, const Scene &scene, const Sampler &sampler, Film *film,
+	RenderCounters *total)
+{
+	const int xRes = options.xResolution, yRes = options.yResolution;
+	Camera camera = scene.hasCameraToWorld ? Camera(scene.cameraToWorld, scene.fov, xRes, yRes) :
+		Camera(scene.cameraPos, scene.cameraLook, Vector3f(0, 0, 1), scene.fov, xRes, yRes);
+	typedef std::chrono::steady_clock Clock;
+	const Clock::time_point endTime = Clock::now() +
+		std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.timeLimit));
+
+	PerThread<RenderCounters> counters;
+	PerThread<std::unique_ptr<Sampler>> samplers;
+	for (int i = 0; i < samplers.Size(); ++i)
+		samplers[i] = sampler.Clone();
+	bool ok = true;
+	while (ok && !film->Done())
+	{
+		Bounds2i band = film->GetCurrentBand();
+		std::unique_ptr<AdaptiveSampling> adaptive;
+		Clock::time_point bandEndTime;
+		if (UseAdaptiveSampling(options))
+		{
+			adaptive.reset(new AdaptiveSampling(band, options.adaptive));
+			// ʣµʱƽָʣµĶ
+			int bandsLeft = (yRes - band.pMin.y + film->bandHeight - 1) / film->bandHeight;
+			bandEndTime = Clock::now() + (endTime - Clock::now()) / bandsLeft;
+		}
+
+		do
+		{
+			ParallelFor2D([&](Bounds2i tileBounds) {
+				ProfilePhase _(Prof::RenderTile);
+				RenderCounters &c = counters.Get();
+				// غλö̵߳arenaϣÿResetȶٷʶ
+				MemoryArena &arena = ThreadArena();
+				FilmTile *tile = film->GetFilmTile(tileBounds, arena);
+				// 鶼ʱúϲ
+				if (RenderTile(options, scene, camera, samplers.Get().get(), tile, adaptive.get(), arena, &c))
+					film->MergeFilmTile(*tile);
+				arena.Reset();
+			}, band, options.tileSize);
+		} while (adaptive && adaptive->EndPass() > 0 &&
+			(options.timeLimit <= 0 || Clock::now() < bandEndTime));
+
+		if (adaptive)
+		{
+			adaptive->ReportStats();
+			total->passes += adaptive->Passes();
+		}
+		ok = film->FinishBand();
+	}
+
+	counters.ForEach([&](const RenderCounters &c) {
+		total->cameraRays += c.cameraRays;
+		total->hits += c.hits;
+	});
+	return ok;
+}
+
+
+int main(int argc, char *argv[])
+{
+	Options options;
+	for (int i = 1; i < argc; ++i)
+	{
+		auto needs = [&](int n) {
+			if (i + n >= argc)
+				Usage((std::string("missing value after ") + argv[i]).c_str());
+		};
+		if (!strcmp(argv[i], "--help") || !strcmp(argv[i], "-h"))
+			Usage();
+		else if (!strcmp(argv[i], "--nthreads"))
+		{
+			needs(1);
+			options.nThreads = atoi(argv[++i]);
+		}
+		else if (!strcmp(argv[i], "--outfile"))
+		{
+			needs(1);
+			options.outFile = argv[++i];
+		}
+		else if (!strcmp(argv[i], "--quiet"))
+			options.quiet = true;
+		else if (!strcmp(argv[i], "--profile"))
+			options.profile = true;
+		else if (!strcmp(argv[i], "--trace"))
+		{
+			needs(1);
+			options.traceFile = argv[++i];
+		}
+		else if (!strcmp(argv[i], "--resolution"))
+		{
+			needs(2);
+			options.xResolution = atoi(argv[++i]);
+			options.yResolution = atoi(argv[++i]);
+		}
+		else if (!strcmp(argv[i], "--spp"))
+		{
+			needs(1);
+			options.spp = atoi(argv[++i]);
+		}
+		else if (!strcmp(argv[i], "--noise"))
+		{
+			needs(1);
+			options.noiseThreshold = (Float)atof(argv[++i]);
+		}
+		else if (!strcmp(argv[i], "--timelimit"))
+		{
+			needs(1);
+			options.timeLimit = atof(argv[++i]);
+		}
+		else if (!strcmp(argv[i], "--minspp"))
+		{
+			needs(1);
+			options.adaptive.minSamples = atoi(argv[++i]);
+		}
+		else if (!strcmp(argv[i], "--maxspp"))
+		{
+			needs(1);
+			options.adaptive.maxSamples = atoi(argv[++i]);
+		}
+		else if (!strcmp(argv[i], "--passspp"))
+		{
+			needs(1);
+			options.adaptive.passSamples = atoi(argv[++i]);
+		}
+		else if (!strcmp(argv[i], "--streamrows"))
+		{
+			needs(1);
+			options.streamRows = atoi(argv[++i]);
+		}
+		else if (!strcmp(argv[i], "--tilesize"))
+		{
+			needs(1);
+			options.tileSize = atoi(argv[++i]);
+		}
+		else if (!strcmp(argv[i], "--sampler"))
+		{
+			needs(1);
+			options.samplerName = argv[++i];
+		}
+		else if (!strcmp(argv[i], "--scene"))
+		{
+			needs(1);
+			options.sceneName = argv[++i];
+		}
+		else if (!strcmp(argv[i], "--scenesize"))
+		{
+			needs(1);
+			options.sceneSize = atoi(argv[++i]);
+		}
+		else if (!strcmp(argv[i], "--accel"))
+		{
+			needs(1);
+			if (!ParseAccelType(argv[++i], &options.accel))
+				Usage((std::string("unknown accelerator ") + argv[i]).c_str());
+			options.accelGiven = true;
+		}
+		else if (!strcmp(argv[i], "--writecache"))
+		{
+			needs(1);
+			options.writeCache = argv[++i];
+		}
+		else if (!strcmp(argv[i], "--lookat"))
+		{
+			needs(9);
+			Float v[9];
+			for (int j = 0; j < 9; ++j)
+				v[j] = (Float)atof(argv[++i]);
+			options.lookAt = true;
+			options.cameraPos = Point3f(v[0], v[1], v[2]);
+			options.cameraLook = Point3f(v[3], v[4], v[5]);
+			options.cameraUp = Vector3f(v[6], v[7], v[8]);
+		}
+		else if (!strcmp(argv[i], "--fov"))
+		{
+			needs(1);
+			options.fov = (Float)atof(argv[++i]);
+		}
+		else if (argv[i][0] == '-')
+			Usage((std::string("unknown option ") + argv[i]).c_str());
+		else if (options.sceneFile.empty())
+			options.sceneFile = argv[i];
+		else
+			Usage("only one scene file can be given");
+	}
+	if (options.xResolution <= 0 || options.yResolution <= 0 || options.spp <= 0 || options.tileSize <= 0)
+		Usage("resolution, spp and tile size must be positive");
+	if (options.streamRows < 0)
+		Usage("--streamrows must not be negative");
+	if (!options.writeCache.empty() && options.sceneFile.empty())
+		Usage("--writecache needs a scene file");
+	if (!options.writeCache.empty() && options.accel != AccelType::BVH)
+		Usage("--writecache only supports --accel bvh");
+	options.adaptive.errorThreshold = options.noiseThreshold;
+	if (options.adaptive.minSamples <= 0 || options.adaptive.passSamples <= 0 ||
+		options.adaptive.maxSamples < options.adaptive.minSamples)
+		Usage("adaptive sampling needs 0 < minspp <= maxspp and passspp > 0");
+
+	std::unique_ptr<Sampler> sampler = MakeSampler(options);
+	if (!sampler)
+		Usage(("unknown sampler " + options.samplerName).c_str());
+
+	ParallelInit(options.nThreads);
+	int nThreads = MaxThreadIndex();
+	InitProfiler(options.profile, !options.traceFile.empty());
+
+	auto startTime = std::chrono::steady_clock::now();
+	TransformCache transformCache;
+	Scene scene;
+	if (!options.sceneFile.empty() ?
+		!LoadSceneFile(options, &transformCache, &scene) :
+		!MakeScene(options, &transformCache, &scene))
+		return 1;
+	if (options.lookAt)
+	{
+		scene.hasCameraToWorld = true;
+		scene.cameraToWorld = Inverse(LookAt(options.cameraPos, options.cameraLook, options.cameraUp));
+	}
+	if (options.fov > 0)
+		scene.fov = options.fov;
+	auto buildTime = std::chrono::steady_clock::now();
+
+	Film film(Point2i(options.xResolution, options.yResolution), options.outFile, options.streamRows);
+	if (!film.Ok())
+		return 1;
+	RenderCounters counters;
+	bool written = Render(options, scene, *sampler, &film, &counters);
+	auto renderTime = std::chrono::steady_clock::now();
+
+	MergeWorkerThreadStats();
+	ParallelCleanup();
+	CleanupProfiler();
+	if (!options.traceFile.empty() && !WriteProfilerTrace(options.traceFile))
+		written = false;
+
+	if (!options.quiet)
+	{
+		double buildSeconds = std::chrono::duration<double>(buildTime - startTime).count();
+		double renderSeconds = std::chrono::duration<double>(renderTime - buildTime).count();
+		printf("Scene \"%s\"\n", (options.sceneFile.empty() ? options.sceneName : options.sceneFile).c_str());
+		printf("    Primitives                %lld\n", (long long)scene.primitiveCount);
+		printf("    Scene memory              %.2f MB\n", scene.bytes / (1024. * 1024.));
+		printf("    Build time                %.3f s\n", buildSeconds);
+		if (scene.accelName)
+			printf("    Accelerator               %s\n", scene.accelName);
+		printf("Render\n");
+		printf("    Threads                   %d\n", nThreads);
+		printf("    Sampler                   %s\n", options.samplerName.c_str());
+		if (UseAdaptiveSampling(options))
+		{
+			printf("    Resolution                %d x %d, adaptive %d-%d spp\n", options.xResolution,
+				options.yResolution, options.adaptive.minSamples, options.adaptive.maxSamples);
+			printf("    Average spp               %.2f in %d passes\n", (double)counters.cameraRays /
+				((double)options.xResolution * options.yResolution), counters.passes);
+		}
+		else
+			printf("    Resolution                %d x %d, %d spp\n", options.xResolution,
+				options.yResolution, options.spp);
+		printf("    Film memory               %.2f MB (%d resident rows)\n", film.BytesUsed() / (1024. * 1024.),
+			film.bandHeight);
+		printf("    Render time               %.3f s\n", renderSeconds);
+		printf("    Camera rays               %lld\n", (long long)counters.cameraRays);
+		printf("    Hits                      %lld (%.2f%%)\n", (long long)counters.hits,
+			100. * counters.hits / std::max((int64_t)1, counters.cameraRays));
+		printf("    Throughput                %.2f Mrays/s\n",
+			counters.cameraRays / std::max(renderSeconds, 1e-9) * 1e-6);
+		if (scene.buildStats)
+			ReportBVHStats(stdout, "Scene BVH", *scene.buildStats);
+		if (transformCache.GetStats().lookups > 0)
+			transformCache.ReportStats(stdout);
+		PrintStats(stdout);
+		if (options.profile)
+			ReportProfilerResults(stdout);
+		if (written)
+			printf("Wrote %s\n", options.outFile.c_str());
+	}
+	return written ? 0 : 1;
+}
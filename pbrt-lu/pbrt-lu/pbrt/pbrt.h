@@ -8,6 +8,23 @@
 #define DCHECK( c ) assert( (c) )
 
 
+// SIMD support
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PBRT_HAVE_SSE
+#endif
+
+#if defined(__AVX__)
+#define PBRT_HAVE_AVX
+#endif
+
+// Ҫ̬ʼֲ߳̾thread_local״ηʱĳʼ飬ͳƼ
+#if defined(_MSC_VER)
+#define PBRT_THREAD_LOCAL __declspec(thread)
+#else
+#define PBRT_THREAD_LOCAL __thread
+#endif
+
+
 
 //#ifdef PBRT_FLOAT_AS_DOUBLE
 //typedef double Float;
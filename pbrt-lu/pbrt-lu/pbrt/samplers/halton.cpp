@@ -0,0 +1,108 @@
+#include "halton.h"
+
+
+namespace pbrt
+{
+	// 갴ظʹţŵļ̫
+	static const int MaxHaltonResolution = 128;
+
+	static void ExtendedGCD(uint64_t a, uint64_t b, int64_t *x, int64_t *y)
+	{
+		if (b == 0)
+		{
+			*x = 1;
+			*y = 0;
+			return;
+		}
+		int64_t d = a / b, xp, yp;
+		ExtendedGCD(b, a % b, &xp, &yp);
+		*x = yp;
+		*y = xp - (d * yp);
+	}
+
+	// aģnĳ˷Ԫ
+	static uint64_t MultiplicativeInverse(int64_t a, int64_t n)
+	{
+		int64_t x, y;
+		ExtendedGCD(a, n, &x, &y);
+		int64_t r = x % n;
+		return r < 0 ? r + n : r;
+	}
+
+	static inline int Mod(int a, int b)
+	{
+		int r = a % b;
+		return r < 0 ? r + b : r;
+	}
+
+	HaltonSampler::HaltonSampler(const Point2i & fullResolution, int seed)
+	{
+		RNG rng((uint64_t)seed);
+		radicalInversePermutations = std::make_shared<const std::vector<uint16_t>>(
+			ComputeRadicalInversePermutations(rng));
+
+		// ҳͼ񣨲MaxHaltonResolution2^j3^k
+		for (int i = 0; i < 2; ++i)
+		{
+			int base = (i == 0) ? 2 : 3;
+			int scale = 1, exp = 0;
+			while (scale < std::min(fullResolution[i], MaxHaltonResolution))
+			{
+				scale *= base;
+				++exp;
+			}
+			baseScales[i] = scale;
+			baseExponents[i] = exp;
+		}
+		sampleStride = baseScales[0] * baseScales[1];
+		multInverse[0] = (int)MultiplicativeInverse(baseScales[1], baseScales[0]);
+		multInverse[1] = (int)MultiplicativeInverse(baseScales[0], baseScales[1]);
+
+		offsetPixel = Point2i(std::numeric_limits<int>::max(), std::numeric_limits<int>::max());
+		offsetForPixel = 0;
+	}
+
+	uint64_t HaltonSampler::PixelOffset(const Point2i & p) const
+	{
+		if (sampleStride == 1)
+			return 0;
+		// ģ2^jxģ3^kyйʣඨϳģsampleStride
+		Point2i pm(Mod(p.x, MaxHaltonResolution), Mod(p.y, MaxHaltonResolution));
+		uint64_t offset = 0;
+		for (int i = 0; i < 2; ++i)
+		{
+			uint64_t dimOffset = (i == 0) ? InverseRadicalInverse<2>(pm[i], baseExponents[i])
+				: InverseRadicalInverse<3>(pm[i], baseExponents[i]);
+			offset += dimOffset * (sampleStride / baseScales[i]) * multInverse[i];
+		}
+		return offset % sampleStride;
+	}
+
+	void HaltonSampler::StartPixelSample(const Point2i & p, int64_t sampleIndex, int dimension)
+	{
+		if (p != offsetPixel)
+		{
+			offsetForPixel = PixelOffset(p);
+			offsetPixel = p;
+		}
+		haltonIndex = offsetForPixel + (uint64_t)sampleIndex * sampleStride;
+		this->dimension = dimension;
+	}
+
+	Float HaltonSampler::SampleDimension(int dim) const
+	{
+		// ǰάȥصǼλ֣ʣµľڵλ
+		if (dim == 0)
+			return RadicalInverse(0, haltonIndex >> baseExponents[0]);
+		if (dim == 1)
+			return RadicalInverse(1, haltonIndex / baseScales[1]);
+		if (dim >= PrimeTableSize)
+			dim = 2 + (dim - 2) % (PrimeTableSize - 2);
+		return ScrambledRadicalInverse(dim, haltonIndex, PermutationForDimension(dim));
+	}
+
+	std::unique_ptr<Sampler> HaltonSampler::Clone() const
+	{
+		return std::unique_ptr<Sampler>(new HaltonSampler(*this));
+	}
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+
+#include <memory>
+#include <vector>
+
+#include "../core/lowdiscrepancy.h"
+#include "../core/sampler.h"
+
+
+namespace pbrt
+{
+	// ҵHaltonpbrt-v3 7.4ڣͼһHaltonУǰά
+	// 2^j3^kСͼС128־꣬ÿص
+	// Ϊ2^j * 3^kһ㡣صĵһйʣඨ֮iֱţʡ
+	// 2άԺÿһûңûCloneĸ֮乲
+	class HaltonSampler : public Sampler
+	{
+	public:
+		HaltonSampler(const Point2i &fullResolution, int seed = 0);
+
+		virtual void StartPixelSample(const Point2i &p, int64_t sampleIndex, int dimension = 0);
+		virtual Float Get1D() { return SampleDimension(dimension++); }
+		virtual Point2f Get2D()
+		{
+			Float u = SampleDimension(dimension);
+			Float v = SampleDimension(dimension + 1);
+			dimension += 2;
+			return Point2f(u, v);
+		}
+
+		virtual std::unique_ptr<Sampler> Clone() const;
+
+	private:
+		// pĵһHalton
+		uint64_t PixelOffset(const Point2i &p) const;
+		Float SampleDimension(int dim) const;
+		const uint16_t *PermutationForDimension(int dim) const
+		{
+			return &(*radicalInversePermutations)[PrimeSums[dim]];
+		}
+
+		std::shared_ptr<const std::vector<uint16_t>> radicalInversePermutations;
+		Point2i baseScales, baseExponents;
+		int sampleStride;
+		int multInverse[2];
+
+		// ͬһȡʱƫ
+		Point2i offsetPixel;
+		uint64_t offsetForPixel;
+		uint64_t haltonIndex = 0;
+		int dimension = 0;
+	};
+}
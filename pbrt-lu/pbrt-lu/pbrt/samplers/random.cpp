@@ -0,0 +1,17 @@
+#include "random.h"
+
+
+namespace pbrt
+{
+	void RandomSampler::StartPixelSample(const Point2i & p, int64_t sampleIndex, int dimension)
+	{
+		uint64_t pixel = ((uint64_t)(uint32_t)p.x << 32) | (uint32_t)p.y;
+		rng.SetSequence(RNG::MixBits(pixel ^ RNG::MixBits((uint64_t)seed)));
+		rng.Advance(sampleIndex * 65536ull + dimension);
+	}
+
+	std::unique_ptr<Sampler> RandomSampler::Clone() const
+	{
+		return std::unique_ptr<Sampler>(new RandomSampler(*this));
+	}
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+
+#include "../core/rng.h"
+#include "../core/sampler.h"
+
+
+namespace pbrt
+{
+	// ûκηֲ㣬ΪȽϵĻ׼
+	// ÿһPCG32Уiĵdάеĵi * 65536 + dRNG::Advanceֱȥ
+	class RandomSampler : public Sampler
+	{
+	public:
+		explicit RandomSampler(int seed = 0) : seed(seed) {}
+
+		virtual void StartPixelSample(const Point2i &p, int64_t sampleIndex, int dimension = 0);
+		virtual Float Get1D() { return rng.UniformFloat(); }
+		virtual Point2f Get2D()
+		{
+			Float u = rng.UniformFloat();
+			return Point2f(u, rng.UniformFloat());
+		}
+
+		virtual std::unique_ptr<Sampler> Clone() const;
+
+	private:
+		int seed;
+		RNG rng;
+	};
+}
@@ -0,0 +1,99 @@
+#include "sobol.h"
+
+#if defined(PBRT_HAVE_SSE)
+#include <immintrin.h>
+#endif
+
+
+namespace pbrt
+{
+#ifdef PBRT_HAVE_SSE
+	// 32λԪȡ32λSSE2û_mm_mullo_epi3232x32->64λ˷ƴ
+	static inline __m128i MulLo32(__m128i a, __m128i b)
+	{
+#if defined(__SSE4_1__)
+		return _mm_mullo_epi32(a, b);
+#else
+		__m128i even = _mm_mul_epu32(a, b);
+		__m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+		return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+			_mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+#endif
+	}
+
+	static inline __m128i ReverseBits32x4(__m128i n)
+	{
+		const __m128i m8 = _mm_set1_epi32(0x00ff00ff), m4 = _mm_set1_epi32(0x0f0f0f0f),
+			m2 = _mm_set1_epi32(0x33333333), m1 = _mm_set1_epi32(0x55555555);
+		n = _mm_or_si128(_mm_slli_epi32(n, 16), _mm_srli_epi32(n, 16));
+		n = _mm_or_si128(_mm_slli_epi32(_mm_and_si128(n, m8), 8), _mm_and_si128(_mm_srli_epi32(n, 8), m8));
+		n = _mm_or_si128(_mm_slli_epi32(_mm_and_si128(n, m4), 4), _mm_and_si128(_mm_srli_epi32(n, 4), m4));
+		n = _mm_or_si128(_mm_slli_epi32(_mm_and_si128(n, m2), 2), _mm_and_si128(_mm_srli_epi32(n, 2), m2));
+		n = _mm_or_si128(_mm_slli_epi32(_mm_and_si128(n, m1), 1), _mm_and_si128(_mm_srli_epi32(n, 1), m1));
+		return n;
+	}
+
+	// OwenScrambleͬ
+	static inline __m128i OwenScramble4(__m128i v, __m128i seed)
+	{
+		v = ReverseBits32x4(v);
+		v = _mm_xor_si128(v, MulLo32(v, _mm_set1_epi32(0x3d20adea)));
+		v = _mm_add_epi32(v, seed);
+		v = MulLo32(v, _mm_or_si128(_mm_srli_epi32(seed, 16), _mm_set1_epi32(1)));
+		v = _mm_xor_si128(v, MulLo32(v, _mm_set1_epi32(0x05526c56)));
+		v = _mm_xor_si128(v, MulLo32(v, _mm_set1_epi32(0x53a22864)));
+		return ReverseBits32x4(v);
+	}
+
+	// SobolSampler::ScrambleSeedͬrowTermΪyάһﲻ
+	static inline __m128i ScrambleSeed4(__m128i x, uint32_t rowTerm)
+	{
+		__m128i h = _mm_xor_si128(MulLo32(x, _mm_set1_epi32((int)0x8da6b343u)), _mm_set1_epi32((int)rowTerm));
+		h = _mm_xor_si128(h, _mm_srli_epi32(h, 16));
+		h = MulLo32(h, _mm_set1_epi32(0x7feb352d));
+		h = _mm_xor_si128(h, _mm_srli_epi32(h, 15));
+		h = MulLo32(h, _mm_set1_epi32((int)0x846ca68bu));
+		h = _mm_xor_si128(h, _mm_srli_epi32(h, 16));
+		return h;
+	}
+
+	// FixedToUnitFloatͬ8λ24λǸзתû⣬Ҳû
+	static inline __m128 FixedToUnitFloat4(__m128i v)
+	{
+		return _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(v, 8)), _mm_set1_ps(1.f / 16777216.f));
+	}
+#endif
+
+	void SobolSampler::GeneratePixel2DBatch(const Bounds2i & tile, int64_t sampleIndex, Float * u, Float * v)
+	{
+		// صĵsampleIndex֮ǰһֻһ
+		const uint32_t bits[2] = { SobolSampleBits((uint32_t)sampleIndex, 0), SobolSampleBits((uint32_t)sampleIndex, 1) };
+		Float *out[2] = { u, v };
+		for (int y = tile.pMin.y; y < tile.pMax.y; ++y)
+		{
+			for (int d = 0; d < 2; ++d)
+			{
+				Float *dst = out[d];
+				int x = tile.pMin.x;
+#ifdef PBRT_HAVE_SSE
+				const uint32_t rowTerm = (uint32_t)y * 0xd8163841u ^ ((uint32_t)d + seed) * 0xcb1ab31fu;
+				const __m128i vbits = _mm_set1_epi32((int)bits[d]);
+				for (; x + 4 <= tile.pMax.x; x += 4, dst += 4)
+				{
+					__m128i px = _mm_add_epi32(_mm_set1_epi32(x), _mm_setr_epi32(0, 1, 2, 3));
+					__m128i scrambled = OwenScramble4(vbits, ScrambleSeed4(px, rowTerm));
+					_mm_storeu_ps(dst, FixedToUnitFloat4(scrambled));
+				}
+#endif
+				for (; x < tile.pMax.x; ++x)
+					*dst++ = FixedToUnitFloat(OwenScramble(bits[d], ScrambleSeed(Point2i(x, y), d)));
+				out[d] = dst;
+			}
+		}
+	}
+
+	std::unique_ptr<Sampler> SobolSampler::Clone() const
+	{
+		return std::unique_ptr<Sampler>(new SobolSampler(*this));
+	}
+}
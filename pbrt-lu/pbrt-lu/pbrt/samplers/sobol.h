@@ -0,0 +1,64 @@
+#pragma once
+
+
+#include "../core/lowdiscrepancy.h"
+#include "../core/sampler.h"
+
+
+namespace pbrt
+{
+	// OwenҵSobolÿͬһSobolеǰN㣬ά(, ά)ϣõ
+	// ӷֱOwenң֮以ءiֱɾiõʡ
+	// ÿصȡ2ʱֲãǰάڵλã(0, 2)-С
+	// άNumSobolDimensionsʱѭʹɾ󣬿ͬȥءֻõ32λ
+	class SobolSampler : public Sampler
+	{
+	public:
+		explicit SobolSampler(int seed = 0) : seed(RNG::MixBits((uint64_t)seed) & 0xffffffff) {}
+
+		virtual void StartPixelSample(const Point2i &p, int64_t sampleIndex, int dimension = 0)
+		{
+			pixel = p;
+			index = (uint32_t)sampleIndex;
+			this->dimension = dimension;
+		}
+		virtual Float Get1D() { return SampleDimension(dimension++); }
+		virtual Point2f Get2D()
+		{
+			Float u = SampleDimension(dimension);
+			Float v = SampleDimension(dimension + 1);
+			dimension += 2;
+			return Point2f(u, v);
+		}
+
+		// SSE2ÿ4
+		virtual void GeneratePixel2DBatch(const Bounds2i &tile, int64_t sampleIndex, Float *u, Float *v);
+
+		virtual std::unique_ptr<Sampler> Clone() const;
+
+		// pdimensionάӣSIMD汾ͬ
+		uint32_t ScrambleSeed(const Point2i &p, int dimension) const
+		{
+			uint32_t h = (uint32_t)p.x * 0x8da6b343u ^ (uint32_t)p.y * 0xd8163841u ^
+				((uint32_t)dimension + seed) * 0xcb1ab31fu;
+			h ^= h >> 16;
+			h *= 0x7feb352du;
+			h ^= h >> 15;
+			h *= 0x846ca68bu;
+			h ^= h >> 16;
+			return h;
+		}
+
+	private:
+		Float SampleDimension(int dim) const
+		{
+			uint32_t bits = SobolSampleBits(index, dim % NumSobolDimensions);
+			return FixedToUnitFloat(OwenScramble(bits, ScrambleSeed(pixel, dim)));
+		}
+
+		uint32_t seed;
+		Point2i pixel;
+		uint32_t index = 0;
+		int dimension = 0;
+	};
+}
@@ -0,0 +1,384 @@
+#include "sphere.h"
+#include "../core/efloat.h"
+#include "../core/interaction.h"
+#include "../core/stats.h"
+#include "../core/transform.h"
+
+#include <algorithm>
+
+#if defined(PBRT_HAVE_AVX) || defined(PBRT_HAVE_SSE)
+#include <immintrin.h>
+#endif
+
+
+namespace pbrt
+{
+	STAT_PERCENT("Intersections/Ray-sphere hits", nSphereHits, nSphereTests);
+
+	// ͶӰϣСphi
+	static inline void ReprojectHit(const Ray &ray, Float t, Float radius, Point3f *pHit, Float *phi)
+	{
+		*pHit = ray(t);
+		*pHit *= radius / Distance(*pHit, Point3f(0, 0, 0));
+		if (pHit->x == 0 && pHit->y == 0) pHit->x = 1e-5f * radius;
+		*phi = std::atan2(pHit->y, pHit->x);
+		if (*phi < 0) *phi += 2 * Pi;
+	}
+
+	bool Sphere::IntersectObjectSpace(const Ray & r, Ray * rayObj, Float * tHit, Point3f * pHitOut, Float * phiOut) const
+	{
+		Float phi;
+		Point3f pHit;
+		++nSphereTests;
+
+		// ߱任ռ䣬ͬʱõԭͷ
+		Vector3f oErr, dErr;
+		Ray ray = (*WorldToObject)(r, &oErr, &dErr);
+
+		// ߴ淽 x^2 + y^2 + z^2 = r^2õtĶη
+		EFloat ox(ray.o.x, oErr.x), oy(ray.o.y, oErr.y), oz(ray.o.z, oErr.z);
+		EFloat dx(ray.d.x, dErr.x), dy(ray.d.y, dErr.y), dz(ray.d.z, dErr.z);
+		EFloat a = dx * dx + dy * dy + dz * dz;
+		EFloat b = 2 * (dx * ox + dy * oy + dz * oz);
+		EFloat c = ox * ox + oy * oy + oz * oz - EFloat(radius) * EFloat(radius);
+
+		EFloat t0, t1;
+		if (!Quadratic(a, b, c, &t0, &t1))
+			return false;
+
+		// 䱣صжtǷ(0, tMax)
+		if (t0.UpperBound() > ray.tMax || t1.LowerBound() <= 0)
+			return false;
+		EFloat tShapeHit = t0;
+		if (tShapeHit.LowerBound() <= 0)
+		{
+			tShapeHit = t1;
+			if (tShapeHit.UpperBound() > ray.tMax)
+				return false;
+		}
+
+		ReprojectHit(ray, (Float)tShapeHit, radius, &pHit, &phi);
+
+		// zphiõĻԵڶ
+		if ((zMin > -radius && pHit.z < zMin) || (zMax < radius && pHit.z > zMax) || phi > phiMax)
+		{
+			if (tShapeHit == t1) return false;
+			if (t1.UpperBound() > ray.tMax) return false;
+			tShapeHit = t1;
+
+			ReprojectHit(ray, (Float)tShapeHit, radius, &pHit, &phi);
+			if ((zMin > -radius && pHit.z < zMin) || (zMax < radius && pHit.z > zMax) || phi > phiMax)
+				return false;
+		}
+
+		*rayObj = ray;
+		*tHit = (Float)tShapeHit;
+		*pHitOut = pHit;
+		*phiOut = phi;
+		++nSphereHits;
+		return true;
+	}
+
+	void Sphere::InteractionFromHit(const Ray & ray, const Point3f & pHit, Float phi, SurfaceInteraction * isect) const
+	{
+		//  u = phi / phiMaxv = (theta - thetaMin) / (thetaMax - thetaMin)
+		Float u = phi / phiMax;
+		Float cosTheta = pHit.z / radius;
+		Float theta = SafeACos(cosTheta);
+		Float v = (theta - thetaMin) / (thetaMax - thetaMin);
+
+		// ƫ dp/du, dp/dv
+		Float zRadius = std::sqrt(pHit.x * pHit.x + pHit.y * pHit.y);
+		Float invZRadius = 1 / zRadius;
+		Float cosPhi = pHit.x * invZRadius;
+		Float sinPhi = pHit.y * invZRadius;
+		Vector3f dpdu(-phiMax * pHit.y, phiMax * pHit.x, 0);
+		Float sinTheta = std::sqrt(std::max((Float)0, 1 - cosTheta * cosTheta));
+		Vector3f dpdv = (thetaMax - thetaMin) *
+			Vector3f(pHit.z * cosPhi, pHit.z * sinPhi, -radius * sinTheta);
+
+		// Weingarten̼㷨ߵƫ dn/du, dn/dv
+		Vector3f d2Pduu = -phiMax * phiMax * Vector3f(pHit.x, pHit.y, 0);
+		Vector3f d2Pduv = (thetaMax - thetaMin) * pHit.z * phiMax * Vector3f(-sinPhi, cosPhi, 0.);
+		Vector3f d2Pdvv = -(thetaMax - thetaMin) * (thetaMax - thetaMin) *
+			Vector3f(pHit.x, pHit.y, pHit.z);
+
+		Float E = Dot(dpdu, dpdu);
+		Float F = Dot(dpdu, dpdv);
+		Float G = Dot(dpdv, dpdv);
+		Vector3f N = Normalize(Cross(dpdu, dpdv));
+		Float e = Dot(N, d2Pduu);
+		Float f = Dot(N, d2Pduv);
+		Float g = Dot(N, d2Pdvv);
+
+		Float invEGF2 = 1 / (E * G - F * F);
+		Normal3f dndu = Normal3f((f * F - e * G) * invEGF2 * dpdu +
+			(e * F - f * E) * invEGF2 * dpdv);
+		Normal3f dndv = Normal3f((g * F - f * G) * invEGF2 * dpdu +
+			(f * F - g * E) * invEGF2 * dpdv);
+
+		// ͶӰĽ
+		Vector3f pError = gamma(5) * Abs((Vector3f)pHit);
+
+		*isect = (*ObjectToWorld)(SurfaceInteraction(pHit, pError, Point2f(u, v),
+			-ray.d, dpdu, dpdv, dndu, dndv, ray.time, this));
+	}
+
+	bool Sphere::Intersect(const Ray & r, Float * tHit, SurfaceInteraction * isect, bool testAlphaTexture) const
+	{
+		Ray ray;
+		Float t, phi;
+		Point3f pHit;
+		if (!IntersectObjectSpace(r, &ray, &t, &pHit, &phi))
+			return false;
+
+		if (isect)
+			InteractionFromHit(ray, pHit, phi, isect);
+		if (tHit)
+			*tHit = t;
+		return true;
+	}
+
+	bool Sphere::IntersectHit(const Ray & r, SurfaceHit * hit, bool testAlphaTexture) const
+	{
+		Ray ray;
+		Float t, phi;
+		Point3f pHit;
+		if (!IntersectObjectSpace(r, &ray, &t, &pHit, &phi))
+			return false;
+
+		hit->tHit = t;
+		hit->primIndex = 0;
+		return true;
+	}
+
+	void Sphere::ComputeSurfaceInteraction(const Ray & r, const SurfaceHit & hit, SurfaceInteraction * isect) const
+	{
+		// IntersectObjectSpaceȫͬ㣬õռߺͽλͬ
+		Vector3f oErr, dErr;
+		Ray ray = (*WorldToObject)(r, &oErr, &dErr);
+		Point3f pHit;
+		Float phi;
+		ReprojectHit(ray, hit.tHit, radius, &pHit, &phi);
+		InteractionFromHit(ray, pHit, phi, isect);
+	}
+
+	bool Sphere::IntersectP(const Ray & r, bool testAlphaTexture) const
+	{
+		Float phi;
+		Point3f pHit;
+
+		Vector3f oErr, dErr;
+		Ray ray = (*WorldToObject)(r, &oErr, &dErr);
+
+		EFloat ox(ray.o.x, oErr.x), oy(ray.o.y, oErr.y), oz(ray.o.z, oErr.z);
+		EFloat dx(ray.d.x, dErr.x), dy(ray.d.y, dErr.y), dz(ray.d.z, dErr.z);
+		EFloat a = dx * dx + dy * dy + dz * dz;
+		EFloat b = 2 * (dx * ox + dy * oy + dz * oz);
+		EFloat c = ox * ox + oy * oy + oz * oz - EFloat(radius) * EFloat(radius);
+
+		EFloat t0, t1;
+		if (!Quadratic(a, b, c, &t0, &t1))
+			return false;
+
+		if (t0.UpperBound() > ray.tMax || t1.LowerBound() <= 0)
+			return false;
+		EFloat tShapeHit = t0;
+		if (tShapeHit.LowerBound() <= 0)
+		{
+			tShapeHit = t1;
+			if (tShapeHit.UpperBound() > ray.tMax)
+				return false;
+		}
+
+		// Ҫü
+		if (IsFullSphere())
+			return true;
+
+		ReprojectHit(ray, (Float)tShapeHit, radius, &pHit, &phi);
+
+		if ((zMin > -radius && pHit.z < zMin) || (zMax < radius && pHit.z > zMax) || phi > phiMax)
+		{
+			if (tShapeHit == t1) return false;
+			if (t1.UpperBound() > ray.tMax) return false;
+			tShapeHit = t1;
+
+			ReprojectHit(ray, (Float)tShapeHit, radius, &pHit, &phi);
+			if ((zMin > -radius && pHit.z < zMin) || (zMax < radius && pHit.z > zMax) || phi > phiMax)
+				return false;
+		}
+		return true;
+	}
+
+	Float Sphere::Area() const
+	{
+		return phiMax * radius * (zMax - zMin);
+	}
+
+
+	// 󽻡
+	// Ϊ˼бʽ b^2 - acĵߵĴ l
+	//   b^2 - a*c = a * (r^2 - |l|^2)l = oc - (ocd / dd) d
+	// ȡ q = -(b + sign(b) * sqrt(бʽ))t0 = c / qt1 = q / a
+	template <int N>
+	int IntersectSpheres(const float * cx, const float * cy, const float * cz, const float * radius,
+		const Ray & ray, Float tMax, Float * tHit)
+	{
+		float a = ray.d.x * ray.d.x + ray.d.y * ray.d.y + ray.d.z * ray.d.z;
+		float invA = 1 / a;
+
+		int best = -1;
+		float bestT = tMax;
+		for (int i = 0; i < N; ++i)
+		{
+			float r = radius[i];
+			float ocx = ray.o.x - cx[i], ocy = ray.o.y - cy[i], ocz = ray.o.z - cz[i];
+			float b = ocx * ray.d.x + ocy * ray.d.y + ocz * ray.d.z;
+			float c = ocx * ocx + ocy * ocy + ocz * ocz - r * r;
+			float s = b * invA;
+			float lx = ocx - s * ray.d.x, ly = ocy - s * ray.d.y, lz = ocz - s * ray.d.z;
+			float discrim = r * r - (lx * lx + ly * ly + lz * lz);
+			if (r < 0 || discrim < 0)
+				continue;
+			float q = -(b + std::copysign(std::sqrt(a * discrim), b));
+			float t0 = c / q, t1 = q * invA;
+			if (t0 > t1) std::swap(t0, t1);
+			float t = t0 > 0 ? t0 : t1;
+			if (t > 0 && t < bestT)
+			{
+				best = i;
+				bestT = t;
+			}
+		}
+		if (best >= 0)
+			*tHit = bestT;
+		return best;
+	}
+
+#ifdef PBRT_HAVE_SSE
+	template <>
+	int IntersectSpheres<4>(const float * cx, const float * cy, const float * cz, const float * radius,
+		const Ray & ray, Float tMax, Float * tHit)
+	{
+		float a = ray.d.x * ray.d.x + ray.d.y * ray.d.y + ray.d.z * ray.d.z;
+		__m128 invA = _mm_set1_ps(1 / a);
+		__m128 dx = _mm_set1_ps(ray.d.x), dy = _mm_set1_ps(ray.d.y), dz = _mm_set1_ps(ray.d.z);
+		__m128 r = _mm_loadu_ps(radius);
+		__m128 ocx = _mm_sub_ps(_mm_set1_ps(ray.o.x), _mm_loadu_ps(cx));
+		__m128 ocy = _mm_sub_ps(_mm_set1_ps(ray.o.y), _mm_loadu_ps(cy));
+		__m128 ocz = _mm_sub_ps(_mm_set1_ps(ray.o.z), _mm_loadu_ps(cz));
+
+		__m128 b = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ocx, dx), _mm_mul_ps(ocy, dy)), _mm_mul_ps(ocz, dz));
+		__m128 r2 = _mm_mul_ps(r, r);
+		__m128 c = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(ocx, ocx), _mm_mul_ps(ocy, ocy)),
+			_mm_mul_ps(ocz, ocz)), r2);
+		__m128 s = _mm_mul_ps(b, invA);
+		__m128 lx = _mm_sub_ps(ocx, _mm_mul_ps(s, dx));
+		__m128 ly = _mm_sub_ps(ocy, _mm_mul_ps(s, dy));
+		__m128 lz = _mm_sub_ps(ocz, _mm_mul_ps(s, dz));
+		__m128 discrim = _mm_sub_ps(r2, _mm_add_ps(_mm_add_ps(_mm_mul_ps(lx, lx), _mm_mul_ps(ly, ly)),
+			_mm_mul_ps(lz, lz)));
+
+		__m128 zero = _mm_setzero_ps();
+		__m128 valid = _mm_and_ps(_mm_cmpge_ps(r, zero), _mm_cmpge_ps(discrim, zero));
+		// ӳҶﳣֻһ򣬶ͽˣʡͳ
+		if (_mm_movemask_ps(valid) == 0)
+			return -1;
+
+		// copysignbķλsqrt
+		__m128 signMask = _mm_set1_ps(-0.f);
+		__m128 root = _mm_sqrt_ps(_mm_max_ps(_mm_mul_ps(_mm_set1_ps(a), discrim), zero));
+		root = _mm_or_ps(root, _mm_and_ps(b, signMask));
+		__m128 q = _mm_xor_ps(_mm_add_ps(b, root), signMask);
+		__m128 ta = _mm_div_ps(c, q), tb = _mm_mul_ps(q, invA);
+		__m128 t0 = _mm_min_ps(ta, tb), t1 = _mm_max_ps(ta, tb);
+		__m128 t0Pos = _mm_cmpgt_ps(t0, zero);
+		__m128 t = _mm_or_ps(_mm_and_ps(t0Pos, t0), _mm_andnot_ps(t0Pos, t1));
+		valid = _mm_and_ps(valid, _mm_and_ps(_mm_cmpgt_ps(t, zero), _mm_cmplt_ps(t, _mm_set1_ps(tMax))));
+
+		int mask = _mm_movemask_ps(valid);
+		if (mask == 0)
+			return -1;
+		alignas(16) float ts[4];
+		_mm_store_ps(ts, t);
+		int best = -1;
+		float bestT = tMax;
+		for (int i = 0; i < 4; ++i)
+			if ((mask & (1 << i)) && ts[i] < bestT)
+			{
+				best = i;
+				bestT = ts[i];
+			}
+		*tHit = bestT;
+		return best;
+	}
+#endif  // PBRT_HAVE_SSE
+
+#ifdef PBRT_HAVE_AVX
+	template <>
+	int IntersectSpheres<8>(const float * cx, const float * cy, const float * cz, const float * radius,
+		const Ray & ray, Float tMax, Float * tHit)
+	{
+		float a = ray.d.x * ray.d.x + ray.d.y * ray.d.y + ray.d.z * ray.d.z;
+		__m256 invA = _mm256_set1_ps(1 / a);
+		__m256 dx = _mm256_set1_ps(ray.d.x), dy = _mm256_set1_ps(ray.d.y), dz = _mm256_set1_ps(ray.d.z);
+		__m256 r = _mm256_loadu_ps(radius);
+		__m256 ocx = _mm256_sub_ps(_mm256_set1_ps(ray.o.x), _mm256_loadu_ps(cx));
+		__m256 ocy = _mm256_sub_ps(_mm256_set1_ps(ray.o.y), _mm256_loadu_ps(cy));
+		__m256 ocz = _mm256_sub_ps(_mm256_set1_ps(ray.o.z), _mm256_loadu_ps(cz));
+
+		__m256 b = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ocx, dx), _mm256_mul_ps(ocy, dy)),
+			_mm256_mul_ps(ocz, dz));
+		__m256 r2 = _mm256_mul_ps(r, r);
+		__m256 c = _mm256_sub_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ocx, ocx),
+			_mm256_mul_ps(ocy, ocy)), _mm256_mul_ps(ocz, ocz)), r2);
+		__m256 s = _mm256_mul_ps(b, invA);
+		__m256 lx = _mm256_sub_ps(ocx, _mm256_mul_ps(s, dx));
+		__m256 ly = _mm256_sub_ps(ocy, _mm256_mul_ps(s, dy));
+		__m256 lz = _mm256_sub_ps(ocz, _mm256_mul_ps(s, dz));
+		__m256 discrim = _mm256_sub_ps(r2, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(lx, lx),
+			_mm256_mul_ps(ly, ly)), _mm256_mul_ps(lz, lz)));
+
+		__m256 zero = _mm256_setzero_ps();
+		__m256 valid = _mm256_and_ps(_mm256_cmp_ps(r, zero, _CMP_GE_OQ),
+			_mm256_cmp_ps(discrim, zero, _CMP_GE_OQ));
+		if (_mm256_movemask_ps(valid) == 0)
+			return -1;
+
+		__m256 signMask = _mm256_set1_ps(-0.f);
+		__m256 root = _mm256_sqrt_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_set1_ps(a), discrim), zero));
+		root = _mm256_or_ps(root, _mm256_and_ps(b, signMask));
+		__m256 q = _mm256_xor_ps(_mm256_add_ps(b, root), signMask);
+		__m256 ta = _mm256_div_ps(c, q), tb = _mm256_mul_ps(q, invA);
+		__m256 t0 = _mm256_min_ps(ta, tb), t1 = _mm256_max_ps(ta, tb);
+		__m256 t = _mm256_blendv_ps(t1, t0, _mm256_cmp_ps(t0, zero, _CMP_GT_OQ));
+		valid = _mm256_and_ps(valid, _mm256_and_ps(_mm256_cmp_ps(t, zero, _CMP_GT_OQ),
+			_mm256_cmp_ps(t, _mm256_set1_ps(tMax), _CMP_LT_OQ)));
+
+		int mask = _mm256_movemask_ps(valid);
+		if (mask == 0)
+			return -1;
+		alignas(32) float ts[8];
+		_mm256_store_ps(ts, t);
+		int best = -1;
+		float bestT = tMax;
+		for (int i = 0; i < 8; ++i)
+			if ((mask & (1 << i)) && ts[i] < bestT)
+			{
+				best = i;
+				bestT = ts[i];
+			}
+		*tHit = bestT;
+		return best;
+	}
+#endif  // PBRT_HAVE_AVX
+
+#ifndef PBRT_HAVE_SSE
+	template int IntersectSpheres<4>(const float *, const float *, const float *, const float *,
+		const Ray &, Float, Float *);
+#endif
+#ifndef PBRT_HAVE_AVX
+	template int IntersectSpheres<8>(const float *, const float *, const float *, const float *,
+		const Ray &, Float, Float *);
+#endif
+}
@@ -6,7 +6,7 @@
 
 namespace pbrt
 {
-	class Sphere : public Shape
+	class Sphere final : public Shape
 	{
 	public:
 		const Float radius;
@@ -32,5 +32,77 @@ namespace pbrt
 		{
 			return Bounds3f(Point3f(-radius, -radius, zMin), Point3f(radius, radius, zMax));
 		}
+
+		virtual bool Intersect(const Ray &ray, Float *tHit, SurfaceInteraction *isect,
+			bool testAlphaTexture = true) const;
+
+		virtual bool IntersectP(const Ray &ray, bool testAlphaTexture = true) const;
+
+		virtual bool IntersectHit(const Ray &ray, SurfaceHit *hit, bool testAlphaTexture = true) const;
+
+		virtual void ComputeSurfaceInteraction(const Ray &ray, const SurfaceHit &hit,
+			SurfaceInteraction *isect) const;
+
+		virtual Float Area() const;
+
+		// ûzphiĲü
+		bool IsFullSphere() const
+		{
+			return zMin <= -radius && zMax >= radius && phiMax >= 2 * Pi;
+		}
+
+	private:
+		// ռе󽻺zphiürayObjΪ任ռߣpHitΪͶӰϵĽ
+		bool IntersectObjectSpace(const Ray &r, Ray *rayObj, Float *tHit, Point3f *pHit, Float *phi) const;
+
+		void InteractionFromHit(const Ray &rayObj, const Point3f &pHit, Float phi,
+			SurfaceInteraction *isect) const;
+	};
+
+
+	// õ壨ûвüĺͰ뾶ռ䣬SoAš
+	// ӳͼԪһһβNN = 4SSEN = 8AVX
+	template <int N>
+	struct alignas(32) SphereBatch
+	{
+		float cx[N], cy[N], cz[N];
+		float radius[N];   // ղλ뾶Ϊ-1Զᱻ
+
+		SphereBatch()
+		{
+			for (int i = 0; i < N; ++i)
+			{
+				cx[i] = cy[i] = cz[i] = 0;
+				radius[i] = -1;
+			}
+		}
+
+		void Set(int i, const Point3f &c, Float r)
+		{
+			DCHECK(i >= 0 && i < N);
+			cx[i] = c.x;
+			cy[i] = c.y;
+			cz[i] = c.z;
+			radius[i] = r;
+		}
 	};
+
+	// һͬʱcxcyczradiusŵN򣬰뾶ΪĲλԶᱻС
+	// (0, tMax)ĽڵĲλûн㷵-1*tHitΪtֵ
+	// ֻõ磬ҪȷʱSphere::Intersectȷϡ
+	template <int N>
+	int IntersectSpheres(const float *cx, const float *cy, const float *cz, const float *radius,
+		const Ray &ray, Float tMax, Float *tHit);
+
+	template <int N>
+	inline int IntersectSphereBatch(const SphereBatch<N> &batch, const Ray &ray, Float tMax, Float *tHit)
+	{
+		return IntersectSpheres<N>(batch.cx, batch.cy, batch.cz, batch.radius, ray, tMax, tHit);
+	}
+
+#ifdef PBRT_HAVE_AVX
+	static const int SphereBatchWidth = 8;
+#else
+	static const int SphereBatchWidth = 4;
+#endif
 }
@@ -0,0 +1,275 @@
+#include "spherecloud.h"
+#include "../core/interaction.h"
+#include "../core/transform.h"
+
+#include <algorithm>
+#include <cstdio>
+
+
+namespace pbrt
+{
+	// Ѿռ䣬Shape任ָͬһλ任
+	static const Transform identityTransform;
+
+
+	std::shared_ptr<SphereCloud> SphereCloud::Create(const std::vector<Point3f>& centers,
+		const std::vector<Float>& radii, bool reverseOrientation, int maxPrimsInNode)
+	{
+		if (radii.size() != 1 && radii.size() != centers.size())
+		{
+			fprintf(stderr, "error: SphereCloud needs one radius or one per center (%zu radii for %zu centers)\n",
+				radii.size(), centers.size());
+			return nullptr;
+		}
+		for (Float r : radii)
+		{
+			// 뾶ǿղλı
+			if (!(r > 0))
+			{
+				fprintf(stderr, "error: SphereCloud radius %f is not positive\n", r);
+				return nullptr;
+			}
+		}
+		return std::shared_ptr<SphereCloud>(new SphereCloud(centers, radii, reverseOrientation, maxPrimsInNode));
+	}
+
+	SphereCloud::SphereCloud(const std::vector<Point3f>& centers, const std::vector<Float>& radii,
+		bool reverseOrientation, int maxPrimsInNode)
+		: Shape(&identityTransform, &identityTransform, reverseOrientation)
+	{
+		size_t n = centers.size();
+		auto radiusOf = [&](size_t i) { return radii.size() == 1 ? radii[0] : radii[i]; };
+
+		std::vector<Bounds3f> primBounds(n);
+		for (size_t i = 0; i < n; ++i)
+		{
+			Float r = radiusOf(i);
+			Vector3f e(r, r, r);
+			primBounds[i] = Bounds3f(centers[i] - e, centers[i] + e);
+		}
+
+		std::vector<int> orderedIndices;
+		BuildLinearBVH(primBounds, maxPrimsInNode, BVHSplitMethod::SAH, &nodes,
+			&orderedIndices, &buildStats, SphereBatchWidth);
+		primBounds.clear();
+		primBounds.shrink_to_fit();
+
+		// Ҷ˳ţͬһҶڴ
+		size_t padded = n + SphereBatchWidth - 1;
+		cx.assign(padded, 0);
+		cy.assign(padded, 0);
+		cz.assign(padded, 0);
+		radius.assign(padded, -1);
+		for (size_t i = 0; i < n; ++i)
+		{
+			int index = orderedIndices[i];
+			cx[i] = centers[index].x;
+			cy[i] = centers[index].y;
+			cz[i] = centers[index].z;
+			radius[i] = radiusOf(index);
+		}
+		particleIndex = std::move(orderedIndices);
+
+		if (!nodes.empty())
+			bounds = nodes[0].bounds;
+	}
+
+	// ҶÿNһβꡣһβԵĲλܳҶӣںҶӵ
+	// ĩβ뾶Ϊ-1ĲλϣҲʵӣĽͬЧֻǶһ㹤
+	static inline int IntersectLeaf(const std::vector<float> &cx, const std::vector<float> &cy,
+		const std::vector<float> &cz, const std::vector<float> &radius, int start, int count,
+		const Ray &ray, Float tMax, Float *tHit)
+	{
+		const int N = SphereBatchWidth;
+		int closest = -1;
+		for (int i = start; i < start + count; i += N)
+		{
+			int lane = IntersectSpheres<N>(&cx[i], &cy[i], &cz[i], &radius[i], ray, tMax, tHit);
+			if (lane >= 0)
+			{
+				tMax = *tHit;
+				closest = i + lane;
+			}
+		}
+		return closest;
+	}
+
+	int SphereCloud::FindClosest(const Ray & ray, Float * tHit) const
+	{
+		if (nodes.empty()) return -1;
+
+		Vector3f invDir(1 / ray.d.x, 1 / ray.d.y, 1 / ray.d.z);
+		int dirIsNeg[3] = { invDir.x < 0, invDir.y < 0, invDir.z < 0 };
+
+		// þֲ߸tMaxڵõҲ
+		Ray r = ray;
+		int closest = -1;
+
+		int toVisitOffset = 0, currentNodeIndex = 0;
+		int nodesToVisit[64];
+		while (true)
+		{
+			const LinearBVHNode *node = &nodes[currentNodeIndex];
+			if (node->bounds.IntersectP(r, invDir, dirIsNeg))
+			{
+				if (node->nPrimitives > 0)
+				{
+					Float t;
+					int i = IntersectLeaf(cx, cy, cz, radius, node->primitivesOffset, node->nPrimitives, r, r.tMax, &t);
+					if (i >= 0)
+					{
+						r.tMax = t;
+						closest = i;
+					}
+					if (toVisitOffset == 0) break;
+					currentNodeIndex = nodesToVisit[--toVisitOffset];
+				}
+				else
+				{
+					if (dirIsNeg[node->axis])
+					{
+						nodesToVisit[toVisitOffset++] = currentNodeIndex + 1;
+						currentNodeIndex = node->secondChildOffset;
+					}
+					else
+					{
+						nodesToVisit[toVisitOffset++] = node->secondChildOffset;
+						currentNodeIndex = currentNodeIndex + 1;
+					}
+				}
+			}
+			else
+			{
+				if (toVisitOffset == 0) break;
+				currentNodeIndex = nodesToVisit[--toVisitOffset];
+			}
+		}
+
+		if (closest >= 0)
+			*tHit = r.tMax;
+		return closest;
+	}
+
+	bool SphereCloud::Intersect(const Ray & ray, Float * tHit, SurfaceInteraction * isect, bool testAlphaTexture) const
+	{
+		SurfaceHit hit;
+		if (!IntersectHit(ray, &hit, testAlphaTexture))
+			return false;
+		if (isect)
+			ComputeSurfaceInteraction(ray, hit, isect);
+		if (tHit)
+			*tHit = hit.tHit;
+		return true;
+	}
+
+	bool SphereCloud::IntersectHit(const Ray & ray, SurfaceHit * hit, bool testAlphaTexture) const
+	{
+		Float t;
+		int i = FindClosest(ray, &t);
+		if (i < 0)
+			return false;
+		hit->tHit = t;
+		hit->primIndex = i;
+		return true;
+	}
+
+	void SphereCloud::ComputeSurfaceInteraction(const Ray & ray, const SurfaceHit & hit, SurfaceInteraction * isect) const
+	{
+		int i = hit.primIndex;
+		Float t = hit.tHit;
+
+		// ֻΪɽϢSphereͬthetaMin = PithetaMax = 0
+		// ֻΪԭľֲм㣬ƽƻռ䡣
+		Float r = radius[i];
+		Point3f center(cx[i], cy[i], cz[i]);
+		Vector3f pLocal = ray(t) - center;
+		pLocal *= r / pLocal.Length();
+		if (pLocal.x == 0 && pLocal.y == 0) pLocal.x = 1e-5f * r;
+
+		Float phi = std::atan2(pLocal.y, pLocal.x);
+		if (phi < 0) phi += 2 * Pi;
+		Float u = phi / (2 * Pi);
+		Float cosTheta = pLocal.z / r;
+		Float theta = SafeACos(cosTheta);
+		Float v = (Pi - theta) / Pi;
+
+		Float zRadius = std::sqrt(pLocal.x * pLocal.x + pLocal.y * pLocal.y);
+		Float cosPhi = pLocal.x / zRadius;
+		Float sinPhi = pLocal.y / zRadius;
+		Float sinTheta = std::sqrt(std::max((Float)0, 1 - cosTheta * cosTheta));
+		Vector3f dpdu(-2 * Pi * pLocal.y, 2 * Pi * pLocal.x, 0);
+		Vector3f dpdv = -Pi * Vector3f(pLocal.z * cosPhi, pLocal.z * sinPhi, -r * sinTheta);
+
+		//  n = (p - c) / rԷߵƫλõƫr
+		Float invR = 1 / r;
+		Normal3f dndu(dpdu * invR), dndv(dpdv * invR);
+
+		// ͶӰƽƻռ
+		Point3f pHit = center + pLocal;
+		Vector3f pError = gamma(5) * Abs(pLocal) + gamma(1) * Abs((Vector3f)pHit);
+
+		*isect = SurfaceInteraction(pHit, pError, Point2f(u, v), -ray.d, dpdu, dpdv,
+			dndu, dndv, ray.time, this, particleIndex[i]);
+	}
+
+	bool SphereCloud::IntersectP(const Ray & ray, bool testAlphaTexture) const
+	{
+		if (nodes.empty()) return false;
+
+		Vector3f invDir(1 / ray.d.x, 1 / ray.d.y, 1 / ray.d.z);
+		int dirIsNeg[3] = { invDir.x < 0, invDir.y < 0, invDir.z < 0 };
+
+		int toVisitOffset = 0, currentNodeIndex = 0;
+		int nodesToVisit[64];
+		while (true)
+		{
+			const LinearBVHNode *node = &nodes[currentNodeIndex];
+			if (node->bounds.IntersectP(ray, invDir, dirIsNeg))
+			{
+				if (node->nPrimitives > 0)
+				{
+					Float t;
+					if (IntersectLeaf(cx, cy, cz, radius, node->primitivesOffset, node->nPrimitives, ray, ray.tMax, &t) >= 0)
+						return true;
+					if (toVisitOffset == 0) break;
+					currentNodeIndex = nodesToVisit[--toVisitOffset];
+				}
+				else
+				{
+					if (dirIsNeg[node->axis])
+					{
+						nodesToVisit[toVisitOffset++] = currentNodeIndex + 1;
+						currentNodeIndex = node->secondChildOffset;
+					}
+					else
+					{
+						nodesToVisit[toVisitOffset++] = node->secondChildOffset;
+						currentNodeIndex = currentNodeIndex + 1;
+					}
+				}
+			}
+			else
+			{
+				if (toVisitOffset == 0) break;
+				currentNodeIndex = nodesToVisit[--toVisitOffset];
+			}
+		}
+		return false;
+	}
+
+	Float SphereCloud::Area() const
+	{
+		Float area = 0;
+		for (size_t i = 0; i < particleIndex.size(); ++i)
+			area += 4 * Pi * radius[i] * radius[i];
+		return area;
+	}
+
+	size_t SphereCloud::BytesUsed() const
+	{
+		return sizeof(*this) +
+			(cx.capacity() + cy.capacity() + cz.capacity() + radius.capacity()) * sizeof(float) +
+			particleIndex.capacity() * sizeof(int) +
+			nodes.capacity() * sizeof(LinearBVHNode);
+	}
+}
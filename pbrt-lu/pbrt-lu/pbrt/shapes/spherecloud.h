@@ -0,0 +1,61 @@
+#pragma once
+
+
+#include <memory>
+#include <vector>
+
+#include "../core/Shape.h"
+#include "../accelerators/bvh.h"
+#include "sphere.h"
+
+
+namespace pbrt
+{
+	// ɵơ
+	// ÿֻռĺͰ뾶SoAûͱ任ƽÿ20ֽڣԭʼ±꣩
+	// ڲԴһBVHӰҶ˳ţҶÿSphereBatchWidthһIntersectSpheresꡣ
+	// ʱSurfaceInteraction::faceIndexΪе±ꡣ
+	class SphereCloud final : public Shape
+	{
+	public:
+		// radiiֻһԪʱӹ뾶Ϸʱnullptr
+		static std::shared_ptr<SphereCloud> Create(const std::vector<Point3f> &centers,
+			const std::vector<Float> &radii, bool reverseOrientation = false, int maxPrimsInNode = 8);
+
+		virtual Bounds3f ObjectBound() const { return bounds; }
+		virtual Bounds3f WorldBound() const { return bounds; }
+
+		virtual bool Intersect(const Ray &ray, Float *tHit, SurfaceInteraction *isect,
+			bool testAlphaTexture = true) const;
+
+		virtual bool IntersectP(const Ray &ray, bool testAlphaTexture = true) const;
+
+		// hit->primIndexźеλ
+		virtual bool IntersectHit(const Ray &ray, SurfaceHit *hit, bool testAlphaTexture = true) const;
+
+		virtual void ComputeSurfaceInteraction(const Ray &ray, const SurfaceHit &hit,
+			SurfaceInteraction *isect) const;
+
+		virtual Float Area() const;
+
+		int NumParticles() const { return (int)particleIndex.size(); }
+		size_t BytesUsed() const;
+		const BVHBuildStats &GetBuildStats() const { return buildStats; }
+
+	private:
+		SphereCloud(const std::vector<Point3f> &centers, const std::vector<Float> &radii,
+			bool reverseOrientation, int maxPrimsInNode);
+
+		// BVHҵӣźеλãûн㷵-1
+		int FindClosest(const Ray &ray, Float *tHit) const;
+
+		// źݣռ䣩ĩβSphereBatchWidth - 1뾶Ϊ-1Ĳλ
+		// ҶӵһβԶĩβ֮ҲԽ
+		std::vector<float> cx, cy, cz, radius;
+		std::vector<int> particleIndex;
+
+		AlignedVector<LinearBVHNode> nodes;
+		Bounds3f bounds;
+		BVHBuildStats buildStats;
+	};
+}
@@ -0,0 +1,747 @@
+#include "triangle.h"
+#include "../core/interaction.h"
+#include "../core/stats.h"
+#include "../core/transform.h"
+
+#include <algorithm>
+
+#if defined(PBRT_HAVE_AVX) || defined(PBRT_HAVE_SSE)
+#include <immintrin.h>
+#endif
+
+
+namespace pbrt
+{
+	// Ѿռ䣬Shape任ָͬһλ任
+	static const Transform identityTransform;
+
+	STAT_PERCENT("Intersections/Ray-triangle hits", nTriangleHits, nTriangleTests);
+	STAT_COUNTER("Intersections/Triangle group tests", nTriangleGroupTests);
+
+
+	TriangleMesh::TriangleMesh(const Transform & ObjectToWorld, int nTriangles, const int * vertexIndices,
+		int nVertices, const Point3f * P, const Normal3f * N, const Point2f * UV)
+		: nTriangles(nTriangles),
+		nVertices(nVertices),
+		transformSwapsHandedness(ObjectToWorld.SwapsHandedness()),
+		indexStorage(vertexIndices, vertexIndices + 3 * nTriangles)
+	{
+		this->vertexIndices = indexStorage.data();
+		pStorage.reset(new Point3f[nVertices]);
+		ObjectToWorld.TransformPoints(P, pStorage.get(), nVertices);
+		p = pStorage.get();
+		n = nullptr;
+		uv = nullptr;
+		if (N)
+		{
+			nStorage.reset(new Normal3f[nVertices]);
+			ObjectToWorld.TransformNormals(N, nStorage.get(), nVertices);
+			n = nStorage.get();
+		}
+		if (UV)
+		{
+			uvStorage.reset(new Point2f[nVertices]);
+			std::copy(UV, UV + nVertices, uvStorage.get());
+			uv = uvStorage.get();
+		}
+	}
+
+	TriangleMesh::TriangleMesh(int nTriangles, const int * vertexIndices, int nVertices, const Point3f * P,
+		const Normal3f * N, const Point2f * UV, bool transformSwapsHandedness, std::shared_ptr<const void> storage)
+		: nTriangles(nTriangles), nVertices(nVertices), vertexIndices(vertexIndices), p(P), n(N), uv(UV),
+		transformSwapsHandedness(transformSwapsHandedness), storage(std::move(storage))
+	{
+	}
+
+	size_t TriangleMesh::BytesUsed() const
+	{
+		size_t bytes = sizeof(*this) + 3 * nTriangles * sizeof(int) +
+			nVertices * sizeof(Point3f);
+		if (n) bytes += nVertices * sizeof(Normal3f);
+		if (uv) bytes += nVertices * sizeof(Point2f);
+		return bytes;
+	}
+
+
+	Bounds3f Triangle::WorldBound() const
+	{
+		const Point3f &p0 = mesh->p[v[0]];
+		const Point3f &p1 = mesh->p[v[1]];
+		const Point3f &p2 = mesh->p[v[2]];
+		return Union(Bounds3f(p0, p1), p2);
+	}
+
+	Float Triangle::Area() const
+	{
+		const Point3f &p0 = mesh->p[v[0]];
+		const Point3f &p1 = mesh->p[v[1]];
+		const Point3f &p2 = mesh->p[v[2]];
+		return 0.5f * Cross(p1 - p0, p2 - p0).Length();
+	}
+
+	void Triangle::GetUVs(Point2f uv[3]) const
+	{
+		if (mesh->uv)
+		{
+			uv[0] = mesh->uv[v[0]];
+			uv[1] = mesh->uv[v[1]];
+			uv[2] = mesh->uv[v[2]];
+		}
+		else
+		{
+			uv[0] = Point2f(0, 0);
+			uv[1] = Point2f(1, 0);
+			uv[2] = Point2f(1, 1);
+		}
+	}
+
+	WatertightRay::WatertightRay(const Ray & ray)
+		: o(ray.o)
+	{
+		// ûᣬ߷ֵķΪz
+		kz = MaxDimension(Abs(ray.d));
+		kx = kz + 1;
+		if (kx == 3) kx = 0;
+		ky = kx + 1;
+		if (ky == 3) ky = 0;
+		Vector3f d = Permute(ray.d, kx, ky, kz);
+
+		// б任߷Ϊ+z
+		Sx = -d.x / d.z;
+		Sy = -d.y / d.z;
+		Sz = 1.f / d.z;
+	}
+
+	// ˮ󽻵壬Triangle::Intersectı汾
+	static bool IntersectWatertight(const WatertightRay &ray, const Point3f &p0, const Point3f &p1,
+		const Point3f &p2, Float tMax, Float *tHit, Float b[3])
+	{
+		int kx = ray.kx, ky = ray.ky, kz = ray.kz;
+		Float Sx = ray.Sx, Sy = ray.Sy, Sz = ray.Sz;
+
+		// ƽƵԭ㲢û
+		Vector3f p0t = Permute(p0 - ray.o, kx, ky, kz);
+		Vector3f p1t = Permute(p1 - ray.o, kx, ky, kz);
+		Vector3f p2t = Permute(p2 - ray.o, kx, ky, kz);
+
+		// zļȷཻ֮
+		p0t.x += Sx * p0t.z;
+		p0t.y += Sy * p0t.z;
+		p1t.x += Sx * p1t.z;
+		p1t.y += Sy * p1t.z;
+		p2t.x += Sx * p2t.z;
+		p2t.y += Sy * p2t.z;
+
+		// ߺ
+		Float e0 = p1t.x * p2t.y - p1t.y * p2t.x;
+		Float e1 = p2t.x * p0t.y - p2t.y * p0t.x;
+		Float e2 = p0t.x * p1t.y - p0t.y * p1t.x;
+
+		// ߺǡΪ0ʱdouble¼㣬ô߻򶥵ʱҲܵõһµĽ
+		if (sizeof(Float) == sizeof(float) && (e0 == 0.0f || e1 == 0.0f || e2 == 0.0f))
+		{
+			double p2txp1ty = (double)p2t.x * (double)p1t.y;
+			double p2typ1tx = (double)p2t.y * (double)p1t.x;
+			e0 = (float)(p2typ1tx - p2txp1ty);
+			double p0txp2ty = (double)p0t.x * (double)p2t.y;
+			double p0typ2tx = (double)p0t.y * (double)p2t.x;
+			e1 = (float)(p0typ2tx - p0txp2ty);
+			double p1txp0ty = (double)p1t.x * (double)p0t.y;
+			double p1typ0tx = (double)p1t.y * (double)p0t.x;
+			e2 = (float)(p1typ0tx - p1txp0ty);
+		}
+
+		if ((e0 < 0 || e1 < 0 || e2 < 0) && (e0 > 0 || e1 > 0 || e2 > 0))
+			return false;
+		Float det = e0 + e1 + e2;
+		if (det == 0)
+			return false;
+
+		// ÷ŴdettΧжϣ
+		p0t.z *= Sz;
+		p1t.z *= Sz;
+		p2t.z *= Sz;
+		Float tScaled = e0 * p0t.z + e1 * p1t.z + e2 * p2t.z;
+		if (det < 0 && (tScaled >= 0 || tScaled < tMax * det))
+			return false;
+		else if (det > 0 && (tScaled <= 0 || tScaled > tMax * det))
+			return false;
+
+		Float invDet = 1 / det;
+		Float b0 = e0 * invDet;
+		Float b1 = e1 * invDet;
+		Float b2 = e2 * invDet;
+		Float t = tScaled * invDet;
+
+		// tı磬tĻΪûн
+		Float maxZt = MaxComponent(Abs(Vector3f(p0t.z, p1t.z, p2t.z)));
+		Float deltaZ = gamma(3) * maxZt;
+		Float maxXt = MaxComponent(Abs(Vector3f(p0t.x, p1t.x, p2t.x)));
+		Float maxYt = MaxComponent(Abs(Vector3f(p0t.y, p1t.y, p2t.y)));
+		Float deltaX = gamma(5) * (maxXt + maxZt);
+		Float deltaY = gamma(5) * (maxYt + maxZt);
+		Float deltaE = 2 * (gamma(2) * maxXt * maxYt + deltaY * maxXt + deltaX * maxYt);
+		Float maxE = MaxComponent(Abs(Vector3f(e0, e1, e2)));
+		Float deltaT = 3 * (gamma(3) * maxE * maxZt + deltaE * maxZt + deltaZ * maxE) * std::abs(invDet);
+		if (t <= deltaT)
+			return false;
+
+		*tHit = t;
+		b[0] = b0;
+		b[1] = b1;
+		b[2] = b2;
+		return true;
+	}
+
+	bool Triangle::Intersect(const Ray & ray, Float * tHit, Float b[3]) const
+	{
+		++nTriangleTests;
+		bool hit = IntersectWatertight(WatertightRay(ray), mesh->p[v[0]], mesh->p[v[1]], mesh->p[v[2]],
+			ray.tMax, tHit, b);
+		nTriangleHits += hit;
+		return hit;
+	}
+
+	// еiεı
+	template <int N>
+	static inline bool IntersectGroupLane(const TriangleGroup<N> &group, int i, const WatertightRay &ray,
+		Float tMax, Float *tHit, Float b[3])
+	{
+		Point3f p0(group.p0[0][i], group.p0[1][i], group.p0[2][i]);
+		Point3f p1(group.p1[0][i], group.p1[1][i], group.p1[2][i]);
+		Point3f p2(group.p2[0][i], group.p2[1][i], group.p2[2][i]);
+		return IntersectWatertight(ray, p0, p1, p2, tMax, tHit, b);
+	}
+
+	template <int N>
+	int IntersectTriangleGroup(const TriangleGroup<N>& group, const WatertightRay & ray, Float tMax,
+		Float * tHit, Float b[3])
+	{
+		int best = -1;
+		for (int i = 0; i < N; ++i)
+		{
+			Float t, bi[3];
+			if (IntersectGroupLane(group, i, ray, best < 0 ? tMax : *tHit, &t, bi) && (best < 0 || t < *tHit))
+			{
+				best = i;
+				*tHit = t;
+				b[0] = bi[0];
+				b[1] = bi[1];
+				b[2] = bi[2];
+			}
+		}
+		return best;
+	}
+
+	// SIMDĺѡλѡһٲϱߺΪ0ҪdoubleĲλ
+	template <int N>
+	static inline int SelectClosestLane(const TriangleGroup<N> &group, const WatertightRay &ray, Float tMax,
+		int mask, int zeroMask, const float *ts, const float *e0, const float *e1, const float *e2,
+		const float *invDet, Float *tHit, Float b[3])
+	{
+		int best = -1;
+		for (int i = 0; i < N; ++i)
+			if ((mask & (1 << i)) && (best < 0 || ts[i] < *tHit))
+			{
+				best = i;
+				*tHit = ts[i];
+			}
+		if (best >= 0)
+		{
+			b[0] = e0[best] * invDet[best];
+			b[1] = e1[best] * invDet[best];
+			b[2] = e2[best] * invDet[best];
+		}
+		for (int i = 0; i < N; ++i)
+		{
+			Float t, bi[3];
+			if ((zeroMask & (1 << i)) &&
+				IntersectGroupLane(group, i, ray, best < 0 ? tMax : *tHit, &t, bi) && (best < 0 || t < *tHit))
+			{
+				best = i;
+				*tHit = t;
+				b[0] = bi[0];
+				b[1] = bi[1];
+				b[2] = bi[2];
+			}
+		}
+		return best;
+	}
+
+	// SIMD汾ӦIntersectWatertight㣬˳ͬ
+	// det < 0ʱtScaleddetͬʱȡַŵķΧжϺϲһαȽϡ
+#ifdef PBRT_HAVE_SSE
+	template <>
+	int IntersectTriangleGroup<4>(const TriangleGroup<4>& group, const WatertightRay & ray, Float tMax,
+		Float * tHit, Float b[3])
+	{
+		const int kx = ray.kx, ky = ray.ky, kz = ray.kz;
+		__m128 ox = _mm_set1_ps(ray.o[kx]), oy = _mm_set1_ps(ray.o[ky]), oz = _mm_set1_ps(ray.o[kz]);
+		__m128 p0x = _mm_sub_ps(_mm_loadu_ps(group.p0[kx]), ox);
+		__m128 p0y = _mm_sub_ps(_mm_loadu_ps(group.p0[ky]), oy);
+		__m128 p0z = _mm_sub_ps(_mm_loadu_ps(group.p0[kz]), oz);
+		__m128 p1x = _mm_sub_ps(_mm_loadu_ps(group.p1[kx]), ox);
+		__m128 p1y = _mm_sub_ps(_mm_loadu_ps(group.p1[ky]), oy);
+		__m128 p1z = _mm_sub_ps(_mm_loadu_ps(group.p1[kz]), oz);
+		__m128 p2x = _mm_sub_ps(_mm_loadu_ps(group.p2[kx]), ox);
+		__m128 p2y = _mm_sub_ps(_mm_loadu_ps(group.p2[ky]), oy);
+		__m128 p2z = _mm_sub_ps(_mm_loadu_ps(group.p2[kz]), oz);
+
+		__m128 Sx = _mm_set1_ps(ray.Sx), Sy = _mm_set1_ps(ray.Sy), Sz = _mm_set1_ps(ray.Sz);
+		p0x = _mm_add_ps(p0x, _mm_mul_ps(Sx, p0z));
+		p0y = _mm_add_ps(p0y, _mm_mul_ps(Sy, p0z));
+		p1x = _mm_add_ps(p1x, _mm_mul_ps(Sx, p1z));
+		p1y = _mm_add_ps(p1y, _mm_mul_ps(Sy, p1z));
+		p2x = _mm_add_ps(p2x, _mm_mul_ps(Sx, p2z));
+		p2y = _mm_add_ps(p2y, _mm_mul_ps(Sy, p2z));
+
+		__m128 e0 = _mm_sub_ps(_mm_mul_ps(p1x, p2y), _mm_mul_ps(p1y, p2x));
+		__m128 e1 = _mm_sub_ps(_mm_mul_ps(p2x, p0y), _mm_mul_ps(p2y, p0x));
+		__m128 e2 = _mm_sub_ps(_mm_mul_ps(p0x, p1y), _mm_mul_ps(p0y, p1x));
+
+		__m128 zero = _mm_setzero_ps();
+		int zeroMask = _mm_movemask_ps(_mm_or_ps(_mm_or_ps(_mm_cmpeq_ps(e0, zero), _mm_cmpeq_ps(e1, zero)),
+			_mm_cmpeq_ps(e2, zero)));
+		__m128 anyNeg = _mm_or_ps(_mm_or_ps(_mm_cmplt_ps(e0, zero), _mm_cmplt_ps(e1, zero)), _mm_cmplt_ps(e2, zero));
+		__m128 anyPos = _mm_or_ps(_mm_or_ps(_mm_cmpgt_ps(e0, zero), _mm_cmpgt_ps(e1, zero)), _mm_cmpgt_ps(e2, zero));
+		__m128 det = _mm_add_ps(_mm_add_ps(e0, e1), e2);
+		__m128 valid = _mm_andnot_ps(_mm_and_ps(anyNeg, anyPos), _mm_cmpneq_ps(det, zero));
+
+		p0z = _mm_mul_ps(p0z, Sz);
+		p1z = _mm_mul_ps(p1z, Sz);
+		p2z = _mm_mul_ps(p2z, Sz);
+		__m128 tScaled = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e0, p0z), _mm_mul_ps(e1, p1z)), _mm_mul_ps(e2, p2z));
+		__m128 signMask = _mm_set1_ps(-0.f);
+		__m128 detSign = _mm_and_ps(det, signMask);
+		__m128 tScaledSigned = _mm_xor_ps(tScaled, detSign);
+		__m128 detAbs = _mm_xor_ps(det, detSign);
+		valid = _mm_and_ps(valid, _mm_and_ps(_mm_cmpgt_ps(tScaledSigned, zero),
+			_mm_cmple_ps(tScaledSigned, _mm_mul_ps(_mm_set1_ps(tMax), detAbs))));
+		if ((_mm_movemask_ps(valid) & ~zeroMask) == 0 && zeroMask == 0)
+			return -1;
+
+		__m128 invDet = _mm_div_ps(_mm_set1_ps(1.f), det);
+		__m128 t = _mm_mul_ps(tScaled, invDet);
+
+		// tı
+		__m128 maxZt = _mm_max_ps(_mm_andnot_ps(signMask, p0z),
+			_mm_max_ps(_mm_andnot_ps(signMask, p1z), _mm_andnot_ps(signMask, p2z)));
+		__m128 maxXt = _mm_max_ps(_mm_andnot_ps(signMask, p0x),
+			_mm_max_ps(_mm_andnot_ps(signMask, p1x), _mm_andnot_ps(signMask, p2x)));
+		__m128 maxYt = _mm_max_ps(_mm_andnot_ps(signMask, p0y),
+			_mm_max_ps(_mm_andnot_ps(signMask, p1y), _mm_andnot_ps(signMask, p2y)));
+		__m128 maxE = _mm_max_ps(_mm_andnot_ps(signMask, e0),
+			_mm_max_ps(_mm_andnot_ps(signMask, e1), _mm_andnot_ps(signMask, e2)));
+		__m128 gamma2 = _mm_set1_ps(gamma(2)), gamma3 = _mm_set1_ps(gamma(3)), gamma5 = _mm_set1_ps(gamma(5));
+		__m128 deltaZ = _mm_mul_ps(gamma3, maxZt);
+		__m128 deltaX = _mm_mul_ps(gamma5, _mm_add_ps(maxXt, maxZt));
+		__m128 deltaY = _mm_mul_ps(gamma5, _mm_add_ps(maxYt, maxZt));
+		__m128 deltaE = _mm_mul_ps(_mm_set1_ps(2.f), _mm_add_ps(_mm_add_ps(
+			_mm_mul_ps(_mm_mul_ps(gamma2, maxXt), maxYt), _mm_mul_ps(deltaY, maxXt)), _mm_mul_ps(deltaX, maxYt)));
+		__m128 deltaT = _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(3.f), _mm_add_ps(_mm_add_ps(
+			_mm_mul_ps(_mm_mul_ps(gamma3, maxE), maxZt), _mm_mul_ps(deltaE, maxZt)), _mm_mul_ps(deltaZ, maxE))),
+			_mm_andnot_ps(signMask, invDet));
+		valid = _mm_and_ps(valid, _mm_cmpgt_ps(t, deltaT));
+
+		int mask = _mm_movemask_ps(valid) & ~zeroMask;
+		if (mask == 0 && zeroMask == 0)
+			return -1;
+		alignas(16) float ts[4], e0s[4], e1s[4], e2s[4], invDets[4];
+		_mm_store_ps(ts, t);
+		_mm_store_ps(e0s, e0);
+		_mm_store_ps(e1s, e1);
+		_mm_store_ps(e2s, e2);
+		_mm_store_ps(invDets, invDet);
+		return SelectClosestLane(group, ray, tMax, mask, zeroMask, ts, e0s, e1s, e2s, invDets, tHit, b);
+	}
+#endif  // PBRT_HAVE_SSE
+
+#ifdef PBRT_HAVE_AVX
+	template <>
+	int IntersectTriangleGroup<8>(const TriangleGroup<8>& group, const WatertightRay & ray, Float tMax,
+		Float * tHit, Float b[3])
+	{
+		const int kx = ray.kx, ky = ray.ky, kz = ray.kz;
+		__m256 ox = _mm256_set1_ps(ray.o[kx]), oy = _mm256_set1_ps(ray.o[ky]), oz = _mm256_set1_ps(ray.o[kz]);
+		__m256 p0x = _mm256_sub_ps(_mm256_loadu_ps(group.p0[kx]), ox);
+		__m256 p0y = _mm256_sub_ps(_mm256_loadu_ps(group.p0[ky]), oy);
+		__m256 p0z = _mm256_sub_ps(_mm256_loadu_ps(group.p0[kz]), oz);
+		__m256 p1x = _mm256_sub_ps(_mm256_loadu_ps(group.p1[kx]), ox);
+		__m256 p1y = _mm256_sub_ps(_mm256_loadu_ps(group.p1[ky]), oy);
+		__m256 p1z = _mm256_sub_ps(_mm256_loadu_ps(group.p1[kz]), oz);
+		__m256 p2x = _mm256_sub_ps(_mm256_loadu_ps(group.p2[kx]), ox);
+		__m256 p2y = _mm256_sub_ps(_mm256_loadu_ps(group.p2[ky]), oy);
+		__m256 p2z = _mm256_sub_ps(_mm256_loadu_ps(group.p2[kz]), oz);
+
+		__m256 Sx = _mm256_set1_ps(ray.Sx), Sy = _mm256_set1_ps(ray.Sy), Sz = _mm256_set1_ps(ray.Sz);
+		p0x = _mm256_add_ps(p0x, _mm256_mul_ps(Sx, p0z));
+		p0y = _mm256_add_ps(p0y, _mm256_mul_ps(Sy, p0z));
+		p1x = _mm256_add_ps(p1x, _mm256_mul_ps(Sx, p1z));
+		p1y = _mm256_add_ps(p1y, _mm256_mul_ps(Sy, p1z));
+		p2x = _mm256_add_ps(p2x, _mm256_mul_ps(Sx, p2z));
+		p2y = _mm256_add_ps(p2y, _mm256_mul_ps(Sy, p2z));
+
+		__m256 e0 = _mm256_sub_ps(_mm256_mul_ps(p1x, p2y), _mm256_mul_ps(p1y, p2x));
+		__m256 e1 = _mm256_sub_ps(_mm256_mul_ps(p2x, p0y), _mm256_mul_ps(p2y, p0x));
+		__m256 e2 = _mm256_sub_ps(_mm256_mul_ps(p0x, p1y), _mm256_mul_ps(p0y, p1x));
+
+		__m256 zero = _mm256_setzero_ps();
+		int zeroMask = _mm256_movemask_ps(_mm256_or_ps(_mm256_or_ps(_mm256_cmp_ps(e0, zero, _CMP_EQ_OQ),
+			_mm256_cmp_ps(e1, zero, _CMP_EQ_OQ)), _mm256_cmp_ps(e2, zero, _CMP_EQ_OQ)));
+		__m256 anyNeg = _mm256_or_ps(_mm256_or_ps(_mm256_cmp_ps(e0, zero, _CMP_LT_OQ),
+			_mm256_cmp_ps(e1, zero, _CMP_LT_OQ)), _mm256_cmp_ps(e2, zero, _CMP_LT_OQ));
+		__m256 anyPos = _mm256_or_ps(_mm256_or_ps(_mm256_cmp_ps(e0, zero, _CMP_GT_OQ),
+			_mm256_cmp_ps(e1, zero, _CMP_GT_OQ)), _mm256_cmp_ps(e2, zero, _CMP_GT_OQ));
+		__m256 det = _mm256_add_ps(_mm256_add_ps(e0, e1), e2);
+		__m256 valid = _mm256_andnot_ps(_mm256_and_ps(anyNeg, anyPos), _mm256_cmp_ps(det, zero, _CMP_NEQ_UQ));
+
+		p0z = _mm256_mul_ps(p0z, Sz);
+		p1z = _mm256_mul_ps(p1z, Sz);
+		p2z = _mm256_mul_ps(p2z, Sz);
+		__m256 tScaled = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(e0, p0z), _mm256_mul_ps(e1, p1z)),
+			_mm256_mul_ps(e2, p2z));
+		__m256 signMask = _mm256_set1_ps(-0.f);
+		__m256 detSign = _mm256_and_ps(det, signMask);
+		__m256 tScaledSigned = _mm256_xor_ps(tScaled, detSign);
+		__m256 detAbs = _mm256_xor_ps(det, detSign);
+		valid = _mm256_and_ps(valid, _mm256_and_ps(_mm256_cmp_ps(tScaledSigned, zero, _CMP_GT_OQ),
+			_mm256_cmp_ps(tScaledSigned, _mm256_mul_ps(_mm256_set1_ps(tMax), detAbs), _CMP_LE_OQ)));
+		if ((_mm256_movemask_ps(valid) & ~zeroMask) == 0 && zeroMask == 0)
+			return -1;
+
+		__m256 invDet = _mm256_div_ps(_mm256_set1_ps(1.f), det);
+		__m256 t = _mm256_mul_ps(tScaled, invDet);
+
+		// tı
+		__m256 maxZt = _mm256_max_ps(_mm256_andnot_ps(signMask, p0z),
+			_mm256_max_ps(_mm256_andnot_ps(signMask, p1z), _mm256_andnot_ps(signMask, p2z)));
+		__m256 maxXt = _mm256_max_ps(_mm256_andnot_ps(signMask, p0x),
+			_mm256_max_ps(_mm256_andnot_ps(signMask, p1x), _mm256_andnot_ps(signMask, p2x)));
+		__m256 maxYt = _mm256_max_ps(_mm256_andnot_ps(signMask, p0y),
+			_mm256_max_ps(_mm256_andnot_ps(signMask, p1y), _mm256_andnot_ps(signMask, p2y)));
+		__m256 maxE = _mm256_max_ps(_mm256_andnot_ps(signMask, e0),
+			_mm256_max_ps(_mm256_andnot_ps(signMask, e1), _mm256_andnot_ps(signMask, e2)));
+		__m256 gamma2 = _mm256_set1_ps(gamma(2)), gamma3 = _mm256_set1_ps(gamma(3)), gamma5 = _mm256_set1_ps(gamma(5));
+		__m256 deltaZ = _mm256_mul_ps(gamma3, maxZt);
+		__m256 deltaX = _mm256_mul_ps(gamma5, _mm256_add_ps(maxXt, maxZt));
+		__m256 deltaY = _mm256_mul_ps(gamma5, _mm256_add_ps(maxYt, maxZt));
+		__m256 deltaE = _mm256_mul_ps(_mm256_set1_ps(2.f), _mm256_add_ps(_mm256_add_ps(
+			_mm256_mul_ps(_mm256_mul_ps(gamma2, maxXt), maxYt), _mm256_mul_ps(deltaY, maxXt)),
+			_mm256_mul_ps(deltaX, maxYt)));
+		__m256 deltaT = _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(3.f), _mm256_add_ps(_mm256_add_ps(
+			_mm256_mul_ps(_mm256_mul_ps(gamma3, maxE), maxZt), _mm256_mul_ps(deltaE, maxZt)),
+			_mm256_mul_ps(deltaZ, maxE))), _mm256_andnot_ps(signMask, invDet));
+		valid = _mm256_and_ps(valid, _mm256_cmp_ps(t, deltaT, _CMP_GT_OQ));
+
+		int mask = _mm256_movemask_ps(valid) & ~zeroMask;
+		if (mask == 0 && zeroMask == 0)
+			return -1;
+		alignas(32) float ts[8], e0s[8], e1s[8], e2s[8], invDets[8];
+		_mm256_store_ps(ts, t);
+		_mm256_store_ps(e0s, e0);
+		_mm256_store_ps(e1s, e1);
+		_mm256_store_ps(e2s, e2);
+		_mm256_store_ps(invDets, invDet);
+		return SelectClosestLane(group, ray, tMax, mask, zeroMask, ts, e0s, e1s, e2s, invDets, tHit, b);
+	}
+#endif  // PBRT_HAVE_AVX
+
+#ifndef PBRT_HAVE_SSE
+	template int IntersectTriangleGroup<4>(const TriangleGroup<4> &, const WatertightRay &, Float, Float *, Float[3]);
+#endif
+#ifndef PBRT_HAVE_AVX
+	template int IntersectTriangleGroup<8>(const TriangleGroup<8> &, const WatertightRay &, Float, Float *, Float[3]);
+#endif
+
+	void Triangle::ComputeSurfaceInteraction(const Ray & ray, const Float b[3], const Shape * shape, SurfaceInteraction * isect) const
+	{
+		const Point3f &p0 = mesh->p[v[0]];
+		const Point3f &p1 = mesh->p[v[1]];
+		const Point3f &p2 = mesh->p[v[2]];
+		Float b0 = b[0], b1 = b[1], b2 = b[2];
+
+		// uvdp/dudp/dv
+		Point2f uv[3];
+		GetUVs(uv);
+		Float duv02u = uv[0].x - uv[2].x, duv02v = uv[0].y - uv[2].y;
+		Float duv12u = uv[1].x - uv[2].x, duv12v = uv[1].y - uv[2].y;
+		Vector3f dp02 = p0 - p2, dp12 = p1 - p2;
+		Float determinant = duv02u * duv12v - duv02v * duv12u;
+		bool degenerateUV = std::abs(determinant) < 1e-8f;
+		Float invdet = degenerateUV ? 0 : 1 / determinant;
+		Vector3f dpdu, dpdv;
+		if (!degenerateUV)
+		{
+			dpdu = (duv12v * dp02 - duv02v * dp12) * invdet;
+			dpdv = (duv02u * dp12 - duv12u * dp02) * invdet;
+		}
+		if (degenerateUV || Cross(dpdu, dpdv).LengthSquared() == 0)
+		{
+			// uv˻ʱȡһ鴹ֱڼηߵ
+			Vector3f ng = Cross(p2 - p0, p1 - p0);
+			CoordinateSystem(Normalize(ng), &dpdu, &dpdv);
+		}
+
+		// ֵ
+		Float xAbsSum = std::abs(b0 * p0.x) + std::abs(b1 * p1.x) + std::abs(b2 * p2.x);
+		Float yAbsSum = std::abs(b0 * p0.y) + std::abs(b1 * p1.y) + std::abs(b2 * p2.y);
+		Float zAbsSum = std::abs(b0 * p0.z) + std::abs(b1 * p1.z) + std::abs(b2 * p2.z);
+		Vector3f pError = gamma(7) * Vector3f(xAbsSum, yAbsSum, zAbsSum);
+
+		Point3f pHit = b0 * p0 + b1 * p1 + b2 * p2;
+		Point2f uvHit(b0 * uv[0].x + b1 * uv[1].x + b2 * uv[2].x,
+			b0 * uv[0].y + b1 * uv[1].y + b2 * uv[2].y);
+
+		*isect = SurfaceInteraction(pHit, pError, uvHit, -ray.d, dpdu, dpdv,
+			Normal3f(0, 0, 0), Normal3f(0, 0, 0), ray.time, shape, faceIndex);
+
+		// ηεı߾uv
+		isect->n = isect->shading.n = Normal3f(Normalize(Cross(dp02, dp12)));
+		if (shape->reverseOrientation ^ shape->transformSwapsHandedness)
+			isect->n = isect->shading.n = -isect->n;
+
+		if (mesh->n)
+		{
+			// ֵɫ
+			Normal3f ns = b0 * mesh->n[v[0]] + b1 * mesh->n[v[1]] + b2 * mesh->n[v[2]];
+			ns = ns.LengthSquared() > 0 ? Normalize(ns) : isect->n;
+
+			Vector3f ss = Normalize(isect->dpdu);
+			Vector3f ts = Cross(ss, ns);
+			if (ts.LengthSquared() > 0)
+			{
+				ts = Normalize(ts);
+				ss = Cross(ts, ns);
+			}
+			else
+				CoordinateSystem(Vector3f(ns), &ss, &ts);
+
+			Normal3f dndu, dndv;
+			Normal3f dn1 = mesh->n[v[0]] - mesh->n[v[2]];
+			Normal3f dn2 = mesh->n[v[1]] - mesh->n[v[2]];
+			if (degenerateUV)
+			{
+				Vector3f dn = Cross(Vector3f(mesh->n[v[2]] - mesh->n[v[0]]),
+					Vector3f(mesh->n[v[1]] - mesh->n[v[0]]));
+				if (dn.LengthSquared() != 0)
+				{
+					Vector3f dnu, dnv;
+					CoordinateSystem(dn, &dnu, &dnv);
+					dndu = Normal3f(dnu);
+					dndv = Normal3f(dnv);
+				}
+			}
+			else
+			{
+				dndu = (duv12v * dn1 - duv02v * dn2) * invdet;
+				dndv = (duv02u * dn2 - duv12u * dn1) * invdet;
+			}
+			isect->SetShadingGeometry(ss, ts, dndu, dndv, true);
+		}
+	}
+
+
+	TriangleMeshShape::TriangleMeshShape(const std::shared_ptr<TriangleMesh>& mesh, bool reverseOrientation, int maxPrimsInNode)
+		: Shape(&identityTransform, &identityTransform, reverseOrientation ^ mesh->transformSwapsHandedness),
+		mesh(mesh)
+	{
+		// Shapeı任ǵλ任任ǷıԺϲreverseOrientation
+		// õreverseOrientation ^ transformSwapsHandednessĵط
+		std::vector<Bounds3f> primBounds(mesh->nTriangles);
+		for (int i = 0; i < mesh->nTriangles; ++i)
+			primBounds[i] = Triangle(mesh.get(), i).WorldBound();
+
+		std::vector<int> orderedFaces;
+		AlignedVector<LinearBVHNode> nodes;
+		BuildLinearBVH(primBounds, maxPrimsInNode, BVHSplitMethod::SAH, &nodes,
+			&orderedFaces, &buildStats, TriangleGroupWidth);
+		if (!nodes.empty())
+			bounds = nodes[0].bounds;
+
+		// ÿҶӵδ飬ҶӸΪ
+		const int N = TriangleGroupWidth;
+		AlignedVector<TriangleGroup<N>> groups;
+		for (LinearBVHNode &node : nodes)
+		{
+			if (node.nPrimitives == 0)
+				continue;
+			int first = node.primitivesOffset, n = node.nPrimitives;
+			node.primitivesOffset = (int)groups.size();
+			node.nPrimitives = (uint16_t)((n + N - 1) / N);
+			for (int i = 0; i < n; i += N)
+			{
+				groups.emplace_back();
+				for (int j = 0; j < N; ++j)
+				{
+					int face = orderedFaces[first + std::min(i + j, n - 1)];
+					const int *v = &mesh->vertexIndices[3 * face];
+					groups.back().Set(j, mesh->p[v[0]], mesh->p[v[1]], mesh->p[v[2]], face);
+				}
+			}
+		}
+		this->nodes = ReadOnlyArray<LinearBVHNode>(std::move(nodes));
+		this->groups = ReadOnlyArray<TriangleGroup<N>>(std::move(groups));
+	}
+
+	TriangleMeshShape::TriangleMeshShape(const std::shared_ptr<TriangleMesh>& mesh, bool reverseOrientation,
+		ReadOnlyArray<LinearBVHNode> nodes, ReadOnlyArray<TriangleGroup<TriangleGroupWidth>> groups)
+		: Shape(&identityTransform, &identityTransform, reverseOrientation ^ mesh->transformSwapsHandedness),
+		mesh(mesh), groups(std::move(groups)), nodes(std::move(nodes))
+	{
+		if (!this->nodes.empty())
+			bounds = this->nodes[0].bounds;
+		// ûؽͳֻйģ
+		buildStats.primitives = mesh->nTriangles;
+		buildStats.treeBytes = this->nodes.BytesUsed();
+	}
+
+	bool TriangleMeshShape::Intersect(const Ray & ray, Float * tHit, SurfaceInteraction * isect, bool testAlphaTexture) const
+	{
+		SurfaceHit hit;
+		if (!IntersectHit(ray, &hit, testAlphaTexture))
+			return false;
+		if (isect)
+			ComputeSurfaceInteraction(ray, hit, isect);
+		if (tHit)
+			*tHit = hit.tHit;
+		return true;
+	}
+
+	bool TriangleMeshShape::IntersectHit(const Ray & ray, SurfaceHit * hit, bool testAlphaTexture) const
+	{
+		if (nodes.empty()) return false;
+
+		Vector3f invDir(1 / ray.d.x, 1 / ray.d.y, 1 / ray.d.z);
+		int dirIsNeg[3] = { invDir.x < 0, invDir.y < 0, invDir.z < 0 };
+		WatertightRay wr(ray);
+
+		// þֲ߸tMax
+		Ray r = ray;
+		int closest = -1;
+		Float bClosest[3] = { 0, 0, 0 };
+
+		int toVisitOffset = 0, currentNodeIndex = 0;
+		int nodesToVisit[64];
+		while (true)
+		{
+			const LinearBVHNode *node = &nodes[currentNodeIndex];
+			if (node->bounds.IntersectP(r, invDir, dirIsNeg))
+			{
+				if (node->nPrimitives > 0)
+				{
+					int end = node->primitivesOffset + node->nPrimitives;
+					for (int i = node->primitivesOffset; i < end; ++i)
+					{
+						Float t, b[3];
+						++nTriangleGroupTests;
+						int lane = IntersectTriangleGroup(groups[i], wr, r.tMax, &t, b);
+						if (lane >= 0)
+						{
+							r.tMax = t;
+							closest = groups[i].faceIndex[lane];
+							bClosest[1] = b[1];
+							bClosest[2] = b[2];
+						}
+					}
+					if (toVisitOffset == 0) break;
+					currentNodeIndex = nodesToVisit[--toVisitOffset];
+				}
+				else
+				{
+					if (dirIsNeg[node->axis])
+					{
+						nodesToVisit[toVisitOffset++] = currentNodeIndex + 1;
+						currentNodeIndex = node->secondChildOffset;
+					}
+					else
+					{
+						nodesToVisit[toVisitOffset++] = node->secondChildOffset;
+						currentNodeIndex = currentNodeIndex + 1;
+					}
+				}
+			}
+			else
+			{
+				if (toVisitOffset == 0) break;
+				currentNodeIndex = nodesToVisit[--toVisitOffset];
+			}
+		}
+
+		if (closest < 0)
+			return false;
+		hit->tHit = r.tMax;
+		hit->primIndex = closest;
+		hit->uv = Point2f(bClosest[1], bClosest[2]);
+		return true;
+	}
+
+	void TriangleMeshShape::ComputeSurfaceInteraction(const Ray & ray, const SurfaceHit & hit, SurfaceInteraction * isect) const
+	{
+		Float b[3] = { 1 - hit.uv.x - hit.uv.y, hit.uv.x, hit.uv.y };
+		Triangle(mesh.get(), hit.primIndex).ComputeSurfaceInteraction(ray, b, this, isect);
+	}
+
+	bool TriangleMeshShape::IntersectP(const Ray & ray, bool testAlphaTexture) const
+	{
+		if (nodes.empty()) return false;
+
+		Vector3f invDir(1 / ray.d.x, 1 / ray.d.y, 1 / ray.d.z);
+		int dirIsNeg[3] = { invDir.x < 0, invDir.y < 0, invDir.z < 0 };
+		WatertightRay wr(ray);
+
+		int toVisitOffset = 0, currentNodeIndex = 0;
+		int nodesToVisit[64];
+		while (true)
+		{
+			const LinearBVHNode *node = &nodes[currentNodeIndex];
+			if (node->bounds.IntersectP(ray, invDir, dirIsNeg))
+			{
+				if (node->nPrimitives > 0)
+				{
+					int end = node->primitivesOffset + node->nPrimitives;
+					for (int i = node->primitivesOffset; i < end; ++i)
+					{
+						Float t, b[3];
+						++nTriangleGroupTests;
+						if (IntersectTriangleGroup(groups[i], wr, ray.tMax, &t, b) >= 0)
+							return true;
+					}
+					if (toVisitOffset == 0) break;
+					currentNodeIndex = nodesToVisit[--toVisitOffset];
+				}
+				else
+				{
+					if (dirIsNeg[node->axis])
+					{
+						nodesToVisit[toVisitOffset++] = currentNodeIndex + 1;
+						currentNodeIndex = node->secondChildOffset;
+					}
+					else
+					{
+						nodesToVisit[toVisitOffset++] = node->secondChildOffset;
+						currentNodeIndex = currentNodeIndex + 1;
+					}
+				}
+			}
+			else
+			{
+				if (toVisitOffset == 0) break;
+				currentNodeIndex = nodesToVisit[--toVisitOffset];
+			}
+		}
+		return false;
+	}
+
+	Float TriangleMeshShape::Area() const
+	{
+		Float area = 0;
+		for (int i = 0; i < mesh->nTriangles; ++i)
+			area += Triangle(mesh.get(), i).Area();
+		return area;
+	}
+
+	size_t TriangleMeshShape::BytesUsed() const
+	{
+		return sizeof(*this) + groups.BytesUsed() + nodes.BytesUsed();
+	}
+}
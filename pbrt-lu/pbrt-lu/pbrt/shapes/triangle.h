@@ -0,0 +1,166 @@
+#pragma once
+
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "../core/Shape.h"
+#include "../core/memory.h"
+#include "../accelerators/bvh.h"
+
+
+namespace pbrt
+{
+	// Ķֻһݣʱͱ任ռ䡣
+	// nuvΪգûuvʱȡ(0, 0)(1, 0)(1, 1)
+	struct TriangleMesh
+	{
+		TriangleMesh(const Transform &ObjectToWorld, int nTriangles, const int *vertexIndices,
+			int nVertices, const Point3f *P, const Normal3f *N, const Point2f *UV);
+
+		// Ѿռ䣨糡ģƣstorage֤֮ǰЧ
+		TriangleMesh(int nTriangles, const int *vertexIndices, int nVertices, const Point3f *P,
+			const Normal3f *N, const Point2f *UV, bool transformSwapsHandedness,
+			std::shared_ptr<const void> storage);
+
+		size_t BytesUsed() const;
+
+		const int nTriangles, nVertices;
+		const int *vertexIndices;
+		const Point3f *p;
+		const Normal3f *n;
+		const Point2f *uv;
+		const bool transformSwapsHandedness;
+
+	private:
+		std::vector<int> indexStorage;
+		std::unique_ptr<Point3f[]> pStorage;
+		std::unique_ptr<Normal3f[]> nStorage;
+		std::unique_ptr<Point2f[]> uvStorage;
+		std::shared_ptr<const void> storage;
+	};
+
+
+	// ˮֻйصĲ֣ûͼϵ
+	// ÿֻһΣ֮Եιá
+	struct WatertightRay
+	{
+		explicit WatertightRay(const Ray &ray);
+
+		Point3f o;
+		int kx, ky, kz;
+		Float Sx, Sy, Sz;
+	};
+
+
+	// һεãֻʱʱ죬档
+	class Triangle
+	{
+	public:
+		Triangle(const TriangleMesh *mesh, int faceIndex)
+			: mesh(mesh), v(&mesh->vertexIndices[3 * faceIndex]), faceIndex(faceIndex)
+		{
+		}
+
+		Bounds3f WorldBound() const;
+		Float Area() const;
+
+		// ˮwatertight󽻣ƽơûкڶάߺ
+		// ιı߲©㡣bΪꡣ
+		bool Intersect(const Ray &ray, Float *tHit, Float b[3]) const;
+
+		// 깹콻ϢshapeΪ״Ƿת
+		void ComputeSurfaceInteraction(const Ray &ray, const Float b[3], const Shape *shape,
+			SurfaceInteraction *isect) const;
+
+	private:
+		void GetUVs(Point2f uv[3]) const;
+
+		const TriangleMesh *mesh;
+		const int *v;
+		int faceIndex;
+	};
+
+
+	// Nεռ䶥㰴SoAţp0[0]Nxp0[1]Nyơ
+	// Nʱһβ룬ظνͬӰ
+	template <int N>
+	struct alignas(32) TriangleGroup
+	{
+		float p0[3][N], p1[3][N], p2[3][N];
+		int32_t faceIndex[N];
+
+		void Set(int i, const Point3f &v0, const Point3f &v1, const Point3f &v2, int face)
+		{
+			DCHECK(i >= 0 && i < N);
+			for (int k = 0; k < 3; ++k)
+			{
+				p0[k][i] = v0[k];
+				p1[k][i] = v1[k];
+				p2[k][i] = v2[k];
+			}
+			faceIndex[i] = face;
+		}
+	};
+
+	// һͬʱеNΣN = 4SSEN = 8AVX֧ʱ˻رѭ
+	// Triangle::Intersectͬһˮ㷨FMAʱtλһ£
+	// ߺΪ0Ĳλ汾double㡣
+	// tMaxڵĲλûн㷵-1*tHitbΪòλtֵꡣ
+	template <int N>
+	int IntersectTriangleGroup(const TriangleGroup<N> &group, const WatertightRay &ray, Float tMax,
+		Float *tHit, Float b[3]);
+
+#ifdef PBRT_HAVE_AVX
+	static const int TriangleGroupWidth = 8;
+#else
+	static const int TriangleGroupWidth = 4;
+#endif
+
+
+	// һȫΪһ״ڲԼBVH
+	// BVHҶֱӴ飺ҶӽڵprimitivesOffsetǵһ±꣬nPrimitivesĸ
+	// һһSIMD󽻲ꡣÿռ40ֽڣ9ͱţټBVHڵ㡣
+	// ʱSurfaceInteraction::faceIndexΪеıš
+	class TriangleMeshShape final : public Shape
+	{
+	public:
+		TriangleMeshShape(const std::shared_ptr<TriangleMesh> &mesh, bool reverseOrientation = false,
+			int maxPrimsInNode = TriangleGroupWidth);
+
+		// ѾõBVHģҲؽ
+		TriangleMeshShape(const std::shared_ptr<TriangleMesh> &mesh, bool reverseOrientation,
+			ReadOnlyArray<LinearBVHNode> nodes, ReadOnlyArray<TriangleGroup<TriangleGroupWidth>> groups);
+
+		virtual Bounds3f ObjectBound() const { return bounds; }
+		virtual Bounds3f WorldBound() const { return bounds; }
+
+		virtual bool Intersect(const Ray &ray, Float *tHit, SurfaceInteraction *isect,
+			bool testAlphaTexture = true) const;
+
+		virtual bool IntersectP(const Ray &ray, bool testAlphaTexture = true) const;
+
+		// hit->primIndexΪαţhit->uvΪ(b1, b2)
+		virtual bool IntersectHit(const Ray &ray, SurfaceHit *hit, bool testAlphaTexture = true) const;
+
+		virtual void ComputeSurfaceInteraction(const Ray &ray, const SurfaceHit &hit,
+			SurfaceInteraction *isect) const;
+
+		virtual Float Area() const;
+
+		const std::shared_ptr<TriangleMesh> &GetMesh() const { return mesh; }
+		const ReadOnlyArray<LinearBVHNode> &GetNodes() const { return nodes; }
+		const ReadOnlyArray<TriangleGroup<TriangleGroupWidth>> &GetGroups() const { return groups; }
+		size_t BytesUsed() const;
+		const BVHBuildStats &GetBuildStats() const { return buildStats; }
+
+	private:
+		std::shared_ptr<TriangleMesh> mesh;
+		// Ҷ˳е顣std::vector֤32ֽڶ룬ʱ÷Ƕȡ
+		ReadOnlyArray<TriangleGroup<TriangleGroupWidth>> groups;
+		ReadOnlyArray<LinearBVHNode> nodes;
+		Bounds3f bounds;
+		BVHBuildStats buildStats;
+	};
+}